@@ -1,28 +1,93 @@
 #include <SDL2/SDL.h>
+#include <ctype.h>
 #include <math.h>
+#include <stdarg.h>
 #include <stdbool.h>
 #include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
 
 #ifdef __EMSCRIPTEN__
 #include <emscripten.h>
+#include <emscripten/heap.h>
 #endif
 
-/* Window config */
+#if !defined(__EMSCRIPTEN__) && !defined(_WIN32)
+#define HAS_TERMINAL_VIEW 1
+#include <signal.h>
+#include <sys/ioctl.h>
+#include <termios.h>
+#include <unistd.h>
+#endif
+
+#if !defined(__EMSCRIPTEN__) && !defined(_WIN32)
+#define HAS_LOCKSTEP 1
+#include <errno.h>
+#include <netdb.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <sys/socket.h>
+#endif
+
+#ifndef _WIN32
+#define HAS_MMAP 1
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+#ifdef __SSE2__
+#include <emmintrin.h>
+#endif
+
+#if SDL_VERSION_ATLEAST(2, 0, 18)
+#define HAS_RENDER_GEOMETRY 1
+#endif
+
+/* Window config (initial size; the sheet is laid out for it and stays centred when resized) */
 #define WINDOW_WIDTH 800
 #define WINDOW_HEIGHT 600
 #define WINDOW_TITLE "Dot Matrix Sheet"
 
-/* Grid config */
+/* Grid config (defaults, overridable with --grid ROWSxCOLS) */
 #define GRID_ROWS 30
 #define GRID_COLS 40
 #define DOT_RADIUS 2
 
-/* Physics constants */
+/* Physics constants; the last three are defaults for --stiffness, --damping and --restoring */
 #define SPRING_REST_LENGTH 15
 #define SPRING_STIFFNESS 0.2
 #define VELOCITY_DAMPING 0.9
 #define RESTORING_FORCE_STRENGTH 0.01
 
+/* Fixed-point physics config (--physics fixed) */
+#define FIXED_SHIFT 12                       /* Positions and velocities in 1/4096 px */
+#define FIXED_RANGE (1 << 29)                /* Largest position or velocity, 131072 px */
+#define FIXED_SPRING_SHIFT 8                 /* Spring lengths measured in 1/256 px */
+#define FIXED_SPRING_LIMIT (1 << 22)         /* Largest spring component, 16384 px */
+#define FIXED_FACTOR(value) ((Sint32)((value) * 65536.0 + 0.5)) /* Constant in 1/65536 */
+#define FIXED_ROW_BUFFERS 18                 /* Row buffers of the step, allocated as one block */
+
+/* Memory arena config */
+#define ARENA_ALIGNMENT 64          /* Cache line; every carved array starts on one */
+#define ARENA_MAX_ALLOCATIONS 128   /* Allocations whose alignment padding the estimate allows for */
+
+/* Time-sliced physics config (--step-budget) */
+#ifdef __EMSCRIPTEN__
+#define STEP_BUDGET_DEFAULT_MS 8.0f /* Physics time per frame before yielding to the browser */
+#else
+#define STEP_BUDGET_DEFAULT_MS 0.0f /* Native builds run every step whole */
+#endif
+#define STEP_SLICE_DOTS 16384       /* Dots stepped between checks of the budget */
+
+/* Power management config */
+#define POWER_MOVING_SPEED 0.01f     /* Speed in px/step above which a hidden sheet counts as moving */
+#define POWER_MOVING_DISTANCE 0.01f  /* Distance from rest in px above which it counts as moving */
+#define POWER_MAX_CATCH_UP (1 << 24) /* Most steps a fast-forward stands in for */
+#define POWER_HIDDEN_WAIT_MS 250     /* Longest native wait for an event while paused */
+
 /* Interaction constants */
 #define CLICK_DETECTION_RADIUS 10
 #define FRAME_DELAY_MS 16
@@ -38,6 +103,148 @@
 #define DOT_COLOR_B 203
 #define DOT_COLOR_A 255
 
+/* Dot rendering config */
+#define RENDER_BATCH_DOTS 65536     /* Dots per geometry submission */
+#define SPRITE_TEXTURE_SIZE 32      /* Texels across the antialiased dot sprite */
+#define RASTER_SUBPIXELS 4          /* Subpixel steps per axis for CPU rasterizer kernels */
+#define RASTER_KERNEL_SIZE (2 * DOT_RADIUS + 3)
+#define RENDER_TILE_DOTS 32         /* Dots per side of the tiles culled against each wall window */
+
+/* Video Wall Configuration */
+#define WALL_MAX_WINDOWS 16         /* Windows in a --wall layout, the main window included */
+
+/* Lockstep Configuration */
+#define LOCKSTEP_MAGIC 0x314B534Cu        /* "LSK1" */
+#define LOCKSTEP_MAX_NODES 16             /* Nodes a coordinator serves */
+#define LOCKSTEP_INPUTS_PER_FRAME 256     /* Input commands sent per frame; more forces a snapshot */
+#define LOCKSTEP_MAX_BACKLOG 262144       /* Unsent bytes beyond one snapshot before a node is resynced */
+
+/* Dynamic resolution config */
+#define DYNRES_DEFAULT_TARGET_MS 8.0f /* Render + present time aimed for with --dynamic-res */
+#define DYNRES_MIN_SCALE 0.25f        /* Smallest fraction of the output resolution rendered */
+#define DYNRES_STEP_DOWN 0.9f         /* Scale factor applied while over the target */
+#define DYNRES_STEP_UP 1.05f          /* Scale factor applied while well under the target */
+#define DYNRES_HEADROOM 0.75f         /* Fraction of the target below which the scale grows */
+#define DYNRES_SMOOTHING 0.2f         /* Weight of the newest frame in the smoothed render time */
+
+/* Colour mode config */
+#define COLOR_SPEED_FULL 8.0f       /* Speed in px/step shown at the top of the palette */
+#define COLOR_STRAIN_FULL 0.5f      /* Relative spring stretch shown at the top of the palette */
+#define COLOR_PALETTE_SIZE 256
+
+/* Flight recorder config */
+#define RECORDER_FRAMES 240                /* Frames of timing/input history kept */
+#define RECORDER_INPUTS_PER_FRAME 64       /* Input commands recorded per frame */
+#define RECORDER_KEYFRAME_INTERVAL 60      /* Frames between state keyframes */
+#define RECORDER_KEYFRAMES (RECORDER_FRAMES / RECORDER_KEYFRAME_INTERVAL + 1)
+#define RECORDER_POST_FRAMES 30            /* Frames captured after a slow frame before dumping */
+#define RECORDER_WARMUP_FRAMES 30          /* Startup frames never treated as slow */
+#define SLOW_FRAME_THRESHOLD_MS 33.0f
+#define RECORDER_DUMP_PATTERN "slow_frame_%06u.dmsrec"
+#define RECORDER_MAGIC 0x31524D44u /* "DMR1" */
+#define RECORDER_VERSION 9u
+
+/* Late latch config */
+#define LATCH_RADIUS 2        /* Grid distance of neighbours moved along with the dragged dot */
+#define LATCH_FALLOFF 0.5f    /* Fraction of the drag delta passed on per grid step */
+#define STATS_INTERVAL_MS 1000
+
+/* Input script config (--script) */
+#define SCRIPT_FRAME_RATE 60          /* Script frames per second; one plays per simulated frame */
+#define SCRIPT_MAX_LINE 256
+#define SCRIPT_MAX_TOKENS 64
+#define SCRIPT_MAX_DEPTH 8            /* Nested repeat and parallel blocks */
+#define SCRIPT_MAX_EVENTS (1 << 22)   /* Input commands one script may compile to */
+#define SCRIPT_MAX_FRAMES (1u << 28)  /* Longest script, about 52 days */
+#define SCRIPT_MAX_DURATION_MS 3600000.0 /* Longest single wait, move or brush stroke */
+#define TOUCH_MAX_POINTS 10           /* Scripted touches held at once, besides the mouse drag */
+
+/* Render benchmark config (--render-bench) */
+#define RENDER_BENCH_FRAMES 240       /* Frames captured when no flight recorder dump is given */
+#define RENDER_BENCH_MEMORY_MB 512    /* Most memory the captured frames take; later frames are dropped */
+#define RENDER_BENCH_DRAG_RADIUS 60   /* Radius of the circle the centre dot is dragged around */
+#define RENDER_BENCH_DRAG_PERIOD 60   /* Frames per turn of the drag circle */
+#define RENDER_BENCH_STAGES 3         /* Build, submit and present */
+
+/* Stress benchmark config (--stress-bench) */
+#define STRESS_DEFAULT_SEEDS 50       /* Seeds run when no count is given */
+#define STRESS_MAX_SEEDS 10000
+#define STRESS_SCRIPT_MS 5000         /* Frames run per seed, and the least a generated script lasts */
+#define STRESS_SCRIPT_BYTES 65536     /* Largest generated script */
+#define STRESS_SAVED_SEEDS 5          /* Worst seeds whose scripts are written out */
+#define STRESS_SEED_PATTERN "stress_seed_%u.dms"
+
+/* Scaling benchmark config (--scaling-bench) */
+#define SCALING_GRID 1024                 /* Sheet rows and columns when --grid is not given */
+#define SCALING_MAX_THREADS 64
+#define SCALING_TARGET_MS 250.0           /* Length of each one-thread run */
+#define SCALING_MAX_STEPS 100000.0
+#define SCALING_FLOPS_PER_DOT 78          /* 10 integrating, then 17 at each end of its 4 springs */
+#define SCALING_BYTES_PER_DOT (4 * sizeof(Dot)) /* Each of the two passes reads and writes every dot */
+#define SCALING_STREAM_FLOATS (1 << 24)   /* Floats per triad array, 64 MB, beyond the caches */
+#define SCALING_STREAM_RUNS 5             /* Triad runs per thread count; the fastest counts */
+#define SCALING_COMPUTE_CHAINS 16         /* Independent multiply-add chains per probe thread */
+#define SCALING_COMPUTE_REPEATS 20000000  /* Multiply-adds per chain */
+
+/* Parameter sweep config (--sweep) */
+#define SWEEP_MAX_THREADS 64
+#define SWEEP_SETTLE_MS 2000.0          /* Default longest settle time after the script (--settle-ms) */
+#define SWEEP_MAX_STRAIN 4.5            /* Default most a spring may stretch or compress (--max-strain) */
+#define SWEEP_SETTLE_LIMIT_MS 10000.0   /* Time simulated after the script while waiting for the sheet to settle */
+#define SWEEP_SETTLE_DISTANCE 0.5f      /* Farthest a settled dot is from rest, px */
+#define SWEEP_SETTLE_SPEED 0.05f        /* Fastest a settled dot moves, px per frame */
+#define SWEEP_BLOWUP_DISTANCE 10000.0f  /* A dot this far from rest means the step diverged */
+#define SWEEP_PULL 150                  /* Distance the default script pulls the centre dot, px */
+#define SWEEP_SHOWN 10                  /* Passing configurations listed */
+
+/* Browser stats config */
+#define TIMELINE_BATCH_FRAMES 8 /* Frames of performance.measure() entries passed to the page per call */
+#define STATS_SMOOTHING 0.1f    /* Weight of the newest frame in the smoothed stats shown by the page */
+
+/* Substep config (--substeps) */
+#define SUBSTEPS_MAX 16                 /* Physics steps per frame */
+#define DRAG_SAMPLES_PER_FRAME 256      /* Drag samples spread over a frame's substeps */
+#define POINTER_RING_SIZE 1024          /* Browser pointer samples queued between frames, a power of two */
+#define POINTER_COORDINATE_SCALE 65536  /* Ring coordinates are fractions of the canvas in 1/65536 */
+
+/* Latency measurement config */
+#define LATENCY_MAX_SAMPLES 8192       /* Presented drag samples kept for distributions */
+#define LATENCY_HISTOGRAM_BIN_MS 2.0f
+#define LATENCY_HISTOGRAM_BINS 25
+#define LATENCY_BENCH_FRAMES 300       /* Default frame count for --latency-bench */
+#define LATENCY_INJECT_HZ 1000         /* Synthetic mouse motion rate */
+#define LATENCY_INJECT_RADIUS 40       /* Radius of the synthetic drag circle in pixels */
+#define LATENCY_INJECT_QUEUE 4096      /* Injected events awaiting consumption */
+
+/* Frame source config */
+#define FRAME_RING_SIZE 4         /* Preallocated buffers for streamed frames */
+#define FRAME_DEFAULT_RATE 30     /* Frames per second, overridable with --frame-rate */
+
+/* Morph config */
+#define MORPH_DEFAULT_RATE 0.05f     /* Fraction of the remaining distance covered per step */
+#define MORPH_DISPLACEMENT 2.0f      /* Rest lengths moved per unit of brightness gradient */
+#define MORPH_BLUR_PASSES 2          /* 3x3 box blurs applied to a shape map before the gradient */
+#define MORPH_SETTLE_DISTANCE 0.01f  /* Rest positions this close to their target snap to it */
+
+/* Terminal view config */
+#define TERMINAL_DEFAULT_COLS 80
+#define TERMINAL_DEFAULT_ROWS 24
+#define TERMINAL_BRAILLE_BASE 0x2800 /* U+2800, the empty Braille pattern */
+#define TERMINAL_STATUS_INTERVAL_MS 500
+
+/* Rewind history config */
+#define HISTORY_MEMORY_MB 64             /* Default history budget, overridable with --history-mb */
+#define HISTORY_KEYFRAME_INTERVAL 30     /* Recorded frames between full keyframes */
+#define HISTORY_MAX_ENTRIES 8192         /* Upper bound on recorded frames */
+#define HISTORY_MAX_WORKERS 8            /* Delta encoder threads */
+#define HISTORY_CHUNKS_PER_WORKER 4      /* Work items per encoder thread per step */
+#define HISTORY_POSITION_SCALE 16.0f     /* Position deltas quantised to 1/16 px */
+#define HISTORY_VELOCITY_SCALE 256.0f    /* Velocity deltas quantised to 1/256 px/step */
+#define HISTORY_VALUES 6                 /* Quantised x, y, vx, vy, rest x, rest y per dot */
+#define HISTORY_KEYFRAME_DOT_BYTES 25    /* Six floats and the fixed flag */
+#define HISTORY_DELTA_DOT_BYTES 35       /* Worst case: a 5-byte varint per value and one run length */
+#define HISTORY_SCRUB_FAST_FRAMES 10     /* Frames per arrow key press with Shift held */
+
 /* Type Definitions */
 
 /**
@@ -55,343 +262,10166 @@ typedef struct
 } Dot;
 
 /**
- * Manages the state of mouse dragging interaction.
+ * Spring, damping and restoring constants the physics steps with.
+ */
+typedef struct
+{
+    double stiffness; /* Force per px of spring stretch */
+    double damping;   /* Fraction of its velocity a dot keeps per step */
+    double restoring; /* Pull toward the rest position per px of displacement */
+} PhysicsParams;
+
+/**
+ * A grid of dots, row-major. The float step works on any sheet: the live
+ * one in g_dots, or the separate sheets of the benchmarks.
+ */
+typedef struct
+{
+    Dot *dots;
+    int rows;
+    int cols;
+    const PhysicsParams *params;
+} Sheet;
+
+/**
+ * One block reserved at startup for the arrays whose size follows from the
+ * grid: dots, keyframes, row buffers, render batches and the history. Arrays
+ * are carved off in order and released together, so the heap does not grow
+ * while the sheet runs. Allocations that do not fit fall back to malloc.
+ */
+typedef struct
+{
+    Uint8 *base;
+    size_t capacity;
+    size_t used;
+    size_t last; /* Offset of the newest allocation, which arena_free() can take back */
+} Arena;
+
+/**
+ * A dot held by one scripted touch.
+ */
+typedef struct
+{
+    bool held;
+    int row;
+    int col;
+} TouchPoint;
+
+/**
+ * Manages the state of mouse dragging interaction, and of the scripted
+ * touches held alongside it.
  */
 typedef struct
 {
     bool is_dragging;
     int row;
     int col;
+    TouchPoint touches[TOUCH_MAX_POINTS];
 } DragState;
 
-/* Global State */
-static Dot g_dots[GRID_ROWS][GRID_COLS];
-static DragState g_drag_state = {false, -1, -1};
-static SDL_Window *g_window = NULL;
-static SDL_Renderer *g_renderer = NULL;
-static bool g_running = true;
+/**
+ * How dots are coloured: one colour (or the frame source's colours), or
+ * speed or spring strain mapped through the palette.
+ */
+typedef enum
+{
+    COLOR_SOLID,
+    COLOR_SPEED,
+    COLOR_STRAIN,
+    COLOR_MODE_COUNT
+} ColorMode;
 
-/* Function Prototypes */
-static void initialize_grid(void);
-static void apply_spring_force(Dot *dot_a, Dot *dot_b);
-static void apply_restoring_force(Dot *dot);
-static void update_physics(void);
-static void render_grid(SDL_Renderer *renderer);
-static void handle_mouse_event(const SDL_Event *event);
-static bool find_dot_at_position(int mouse_x, int mouse_y, int *row, int *col);
-static void draw_filled_circle(SDL_Renderer *renderer, int center_x, int center_y, int radius);
-static void main_loop(void);
+/**
+ * How the physics step is computed.
+ */
+typedef enum
+{
+    PHYSICS_FLOAT, /* Single-precision floats */
+    PHYSICS_FIXED, /* 32-bit fixed point, bit-identical on every target */
+    PHYSICS_MODE_COUNT
+} PhysicsMode;
 
 /**
- * Initializes the dot grid with evenly spaced dots centered in the window.
- * Sets the top-left and top-right corner dots as fixed anchor points.
+ * Row buffers of the fixed-point step. It makes one pass over the grid,
+ * keeping two rows of positions and the spring forces between them.
  */
-static void initialize_grid(void)
+typedef struct
 {
-    const float start_x = (WINDOW_WIDTH - (GRID_COLS - 1) * SPRING_REST_LENGTH) / 2.0f;
-    const float start_y = (WINDOW_HEIGHT - (GRID_ROWS - 1) * SPRING_REST_LENGTH) / 2.0f;
+    Sint32 *x[2];      /* Positions of the current and next row, 1/4096 px */
+    Sint32 *y[2];
+    Sint32 *vx[2];     /* Velocities after damping and the restoring force, 1/4096 px/step */
+    Sint32 *vy[2];
+    Sint32 *rest_x[2]; /* Rest positions, while a shape is shown */
+    Sint32 *rest_y[2];
+    Sint32 *across_x;  /* Force of each spring to the right neighbour in the current row, from index 1 */
+    Sint32 *across_y;
+    Sint32 *down_x[2]; /* Force of each spring to the row below, for the current and previous row */
+    Sint32 *down_y[2];
+    int capacity;      /* Columns the buffers hold; each has room for one more */
+    Sint32 stiffness;  /* g_physics_params in 1/65536, taken at the start of each step */
+    Sint32 damping;
+    Sint32 restoring;
+} FixedPhysics;
 
-    for (int row = 0; row < GRID_ROWS; row++)
-    {
-        for (int col = 0; col < GRID_COLS; col++)
+/**
+ * A physics step spread over several frames. While it is in progress, g_dots
+ * points at a copy of the last completed step, so everything outside the step
+ * sees a consistent state, and the step works on the live dots.
+ */
+typedef struct
+{
+    float budget_ms;   /* Physics time per frame, 0 to run every step whole */
+    bool active;       /* A step is in progress */
+    bool fixed;        /* It runs the fixed-point rows */
+    int pass;          /* Pass over the grid in progress: integration, then springs */
+    int row;           /* Next row of that pass */
+    Dot *live;         /* Dots being stepped */
+    Dot *snapshot;     /* The last completed step, shown meanwhile */
+    size_t capacity;   /* Dots the snapshot holds */
+    double step_ms;    /* Physics time of the last completed step */
+    double elapsed_ms; /* Physics time of the step in progress so far */
+} PhysicsSlicer;
+
+/**
+ * How dots are drawn.
+ */
+typedef enum
+{
+    RENDER_POINTS,   /* Integer-snapped filled circles, one point at a time */
+    RENDER_GEOMETRY, /* Flat squares in batched geometry */
+    RENDER_SPRITE,   /* Antialiased disc sprite in batched geometry */
+    RENDER_RASTER,   /* Antialiased discs splatted on the CPU and uploaded as one texture */
+    RENDER_BACKEND_COUNT
+} RenderBackend;
+
+/**
+ * Maps sheet coordinates, laid out for a WINDOW_WIDTH x WINDOW_HEIGHT window,
+ * into the current window. Resizing moves the view rather than the dots.
+ */
+typedef struct
+{
+    int width;           /* Window size in points */
+    int height;
+    int offset_x;        /* Added to sheet coordinates to get window points */
+    int offset_y;
+    float pixel_scale_x; /* Output pixels per window point, above 1 on HiDPI displays */
+    float pixel_scale_y;
+    int wall_col;        /* Position of the window in a --wall layout */
+    int wall_row;
+} View;
+
+/**
+ * Dynamic resolution: dots are rendered into an offscreen texture at a
+ * fraction of the output resolution and upscaled in one copy. The fraction
+ * follows the smoothed render + present time toward a target.
+ */
+typedef struct
+{
+    bool enabled;
+    float target_ms;
+    float scale;           /* Fraction of the output resolution rendered */
+    float render_ms;       /* Smoothed render + present time */
+    float reported_scale;  /* Scale in the last stats line */
+    Uint32 last_report;
+    SDL_Texture *texture;  /* Render target at the full output resolution */
+    SDL_Renderer *owner;
+    int width;
+    int height;
+} DynamicResolution;
+
+/**
+ * Reusable buffers and textures for drawing dots.
+ */
+typedef struct
+{
+    RenderBackend backend;
+    Uint8 *shades; /* Palette index per dot of the row being built */
+    int shade_capacity;
+    SDL_Renderer *texture_owner; /* Renderer the textures below belong to */
+#ifdef HAS_RENDER_GEOMETRY
+    SDL_Vertex *vertices; /* Four corners per dot */
+    int vertex_capacity;  /* Dots the vertex buffer holds */
+    int *indices;         /* Two triangles per dot, the same pattern for every batch */
+    SDL_Texture *sprite;  /* White disc with antialiased alpha, tinted by vertex colour */
+#endif
+    int batched; /* Dots built but not yet submitted */
+    SDL_Texture *raster_texture; /* Streaming texture the CPU rasterizer uploads to */
+    Uint32 *raster_pixels;
+    int raster_width;
+    int raster_height;
+    bool kernels_ready;
+    Uint8 kernels[RASTER_SUBPIXELS * RASTER_SUBPIXELS][RASTER_KERNEL_SIZE * RASTER_KERNEL_SIZE];
+} RenderState;
+
+/**
+ * Bounding box of the dot centres in one RENDER_TILE_DOTS square tile.
+ */
+typedef struct
+{
+    float min_x;
+    float min_y;
+    float max_x;
+    float max_y;
+} TileBounds;
+
+/**
+ * Per-frame tile bounds shared by all windows of a video wall.
+ */
+typedef struct
+{
+    TileBounds *bounds; /* rows * cols tiles, row-major */
+    int rows;
+    int cols;
+    bool valid; /* Bounds match the positions being drawn */
+} Tiles;
+
+/**
+ * One extra window of a video wall. Its render thread builds the window's
+ * dots from the shared positions while the main thread draws the main
+ * window; the main thread then submits and presents.
+ */
+typedef struct
+{
+    SDL_Window *window;
+    SDL_Renderer *renderer;
+    View view;
+    RenderState render;
+    SDL_Thread *thread;
+    SDL_sem *start;
+    SDL_sem *done;
+    bool ready;    /* Prepared for this frame */
+    bool building; /* Handed to the render thread this frame */
+} WallWindow;
+
+/**
+ * A sheet spanning a grid of windows. The main window is the top-left one
+ * and keeps g_window, g_renderer and g_view.
+ */
+typedef struct
+{
+    int cols;
+    int rows;
+    WallWindow windows[WALL_MAX_WINDOWS - 1];
+    int count; /* Extra windows in use */
+    bool quit;
+} VideoWall;
+
+/**
+ * Input command types. Raw SDL events are translated into these so the same
+ * stream can be recorded, replayed and applied to the grid.
+ */
+typedef enum
+{
+    INPUT_GRAB,         /* Pick up the dot under (x, y), if any */
+    INPUT_MOVE,         /* Move the dragged dot to (x, y) */
+    INPUT_RELEASE,      /* Let go of the dragged dot */
+    INPUT_LATCH,        /* Move the dragged dot and its neighbourhood to (x, y) after the physics step */
+    INPUT_MORPH,        /* Start morphing toward loaded shape x, or back to the lattice if x is -1 */
+    INPUT_STEP,         /* A physics step ran here; only in recordings and lockstep frames */
+    INPUT_FAST_FORWARD, /* Relax the sheet as x physics steps without input would */
+    INPUT_TOUCH_DOWN,   /* Touch `touch` picks up the dot under (x, y), if any */
+    INPUT_TOUCH_MOVE,   /* Move the dot held by touch `touch` to (x, y) */
+    INPUT_TOUCH_UP,     /* Touch `touch` lets go of its dot */
+} InputType;
+
+/**
+ * A single input command in window coordinates.
+ */
+typedef struct
+{
+    Sint32 type; /* InputType */
+    Sint32 x;
+    Sint32 y;
+    Sint32 touch; /* Touch slot of the INPUT_TOUCH_* commands */
+} InputCommand;
+
+/**
+ * One input command of a compiled script.
+ */
+typedef struct
+{
+    Uint32 frame; /* Script frame at whose start it applies */
+    Uint32 order; /* Position in the compiled output, keeping a frame's commands in order */
+    InputCommand command;
+} ScriptEvent;
+
+/**
+ * An input script compiled into input commands, and how far it has played.
+ */
+typedef struct
+{
+    const char *name;
+    ScriptEvent *events; /* Sorted by frame */
+    int count;
+    int capacity;
+    Uint32 frames; /* Frames the script lasts */
+    int next;      /* First event not played yet */
+    Uint32 frame;  /* Frame about to play */
+} Script;
+
+/**
+ * State of the script compiler while it walks the lines of a script.
+ */
+typedef struct
+{
+    const char *name;
+    char **lines;
+    int line_count;
+    int depth; /* Blocks open */
+    float x[TOUCH_MAX_POINTS + 1]; /* Last position of the mouse, then of every touch */
+    float y[TOUCH_MAX_POINTS + 1];
+} ScriptCompiler;
+
+/**
+ * A drag position waiting for the substep it belongs to.
+ */
+typedef struct
+{
+    Sint32 x;
+    Sint32 y;
+    Uint64 counter; /* Performance counter value when the sample was generated */
+} DragSample;
+
+/**
+ * Drag samples that arrived since the previous frame. They are spread over
+ * the frame's substeps by time: each substep first moves the dragged dot to
+ * the newest sample from its share of the interval between the two frames.
+ */
+typedef struct
+{
+    DragSample samples[DRAG_SAMPLES_PER_FRAME];
+    int count;
+    int next;            /* First sample not applied yet */
+    Uint64 window_start; /* Event stage of the previous frame */
+    Uint64 window_end;   /* Event stage of this frame */
+} DragSamples;
+
+/**
+ * Pointer sample types written by the page into the pointer ring.
+ */
+typedef enum
+{
+    POINTER_DOWN,
+    POINTER_MOVE,
+    POINTER_UP
+} PointerSampleType;
+
+/**
+ * One browser pointer sample, coalesced ones included.
+ */
+typedef struct
+{
+    Sint32 type;    /* PointerSampleType */
+    Sint32 x;       /* Position in 1/POINTER_COORDINATE_SCALE of the canvas size */
+    Sint32 y;
+    Sint32 reserved;
+    double time_ms; /* Event timestamp, on the performance.now() clock */
+} PointerSample;
+
+/**
+ * Ring of pointer samples in WebAssembly memory. The page writes samples and
+ * advances head (and tail, to drop the oldest when full); the engine reads
+ * them and advances tail at the start of each frame.
+ */
+typedef struct
+{
+    Uint32 head;
+    Uint32 tail;
+    Uint32 active; /* Set by the page; SDL's mouse events are ignored from then on */
+    Uint32 size;   /* POINTER_RING_SIZE */
+    PointerSample samples[POINTER_RING_SIZE];
+} PointerRing;
+
+/**
+ * Window visibility. While every window is hidden or minimised nothing is
+ * rendered, and the physics pauses unless lockstep peers depend on it.
+ */
+typedef struct
+{
+    Uint32 hidden_windows; /* Bit per window: the main window, then the wall's */
+    bool hidden;           /* Every window is hidden */
+    bool paused;           /* Physics paused while hidden */
+    bool moving;           /* The sheet was still moving when hidden, so it is fast-forwarded when shown */
+    Uint32 hidden_at;      /* SDL_GetTicks() value when the last window was hidden */
+} PowerState;
+
+/**
+ * Worst frame of one stress benchmark seed.
+ */
+typedef struct
+{
+    Uint32 seed;
+    int frame;
+    float worst_ms; /* Step plus render time */
+    float step_ms;
+    float render_ms;
+} StressResult;
+
+/**
+ * Work of one scaling benchmark thread.
+ */
+typedef enum
+{
+    SCALING_STEP,    /* Step a sheet */
+    SCALING_STREAM,  /* Triad over a slice of the probe arrays */
+    SCALING_COMPUTE  /* Multiply-add chains in registers */
+} ScalingKind;
+
+/**
+ * Start line for the threads of one scaling benchmark run.
+ */
+typedef struct
+{
+    SDL_atomic_t ready; /* Threads done preparing */
+    SDL_atomic_t go;    /* Set to start them all */
+} ScalingGate;
+
+/**
+ * One thread's share of a scaling benchmark run.
+ */
+typedef struct
+{
+    ScalingKind kind;
+    ScalingGate *gate;
+    Sheet sheet;     /* SCALING_STEP */
+    float *a;        /* SCALING_STREAM arrays */
+    float *b;
+    float *c;
+    size_t count;
+    float seed;      /* SCALING_COMPUTE start value, then its result */
+    int repeats;     /* Steps, triad passes or multiply-adds per chain */
+} ScalingTask;
+
+/**
+ * Roofline ceilings measured for one thread count.
+ */
+typedef struct
+{
+    double gbytes; /* Triad bandwidth, GB/s */
+    double gflops; /* Multiply-add throughput, GFLOP/s */
+} ScalingProbes;
+
+/**
+ * One configuration of a parameter sweep, and how it did.
+ */
+typedef struct
+{
+    PhysicsParams params;
+    int substeps;
+    bool stable;       /* No dot diverged */
+    int settle_frames; /* Frames after the script until the sheet was at rest, or -1 */
+    float peak_strain; /* Most any spring was stretched or compressed, as a fraction of its rest length */
+    double frame_ms;   /* Mean step time per frame */
+} SweepResult;
+
+/**
+ * Configurations shared by the threads of a parameter sweep.
+ */
+typedef struct
+{
+    const Script *script;
+    SweepResult *results;
+    int count;
+    SDL_atomic_t next; /* Next configuration to run */
+    SDL_atomic_t done; /* Configurations finished */
+} SweepQueue;
+
+/**
+ * Lockstep role: a coordinator simulates from live input and sends each
+ * frame's inputs to its nodes, which simulate the same steps themselves.
+ */
+typedef enum
+{
+    LOCKSTEP_OFF,
+    LOCKSTEP_COORDINATOR,
+    LOCKSTEP_NODE
+} LockstepRole;
+
+/**
+ * Lockstep message types.
+ */
+typedef enum
+{
+    LOCKSTEP_FRAME,    /* Coordinator to node: one frame's inputs and steps, and the checksum after */
+    LOCKSTEP_SNAPSHOT, /* Coordinator to node: the full state, on connect or when asked */
+    LOCKSTEP_RESYNC    /* Node to coordinator: checksums differ, send a snapshot */
+} LockstepMessageType;
+
+/**
+ * Header of every lockstep message, followed by payload_bytes of payload:
+ * input_count InputCommands for a frame, or a LockstepState and the dots
+ * for a snapshot. Both ends must be the same build on the same architecture.
+ */
+typedef struct
+{
+    Uint32 magic;
+    Uint32 type;          /* LockstepMessageType */
+    Uint32 step;          /* Steps simulated once the message is applied */
+    Uint32 checksum;      /* Checksum of the state once the message is applied */
+    Uint32 time_ms;       /* Coordinator clock when the frame was simulated */
+    Uint32 payload_bytes;
+    Uint16 input_count;   /* Inputs in the payload, with an INPUT_STEP for each physics step */
+    Uint16 reserved;
+} LockstepHeader;
+
+/**
+ * State besides the dots that a snapshot restores.
+ */
+typedef struct
+{
+    Sint32 rows;
+    Sint32 cols;
+    DragState drag;
+    Sint32 morph_shape;
+    Uint8 morph_settling;
+    Uint8 morph_shaped;
+} LockstepState;
+
+/**
+ * One end of a lockstep connection with its unparsed received bytes and
+ * the queued bytes the socket has not taken yet.
+ */
+typedef struct
+{
+    int socket;
+    Uint8 *buffer;
+    size_t length;
+    size_t capacity;
+    Uint8 *outbox;
+    size_t outbox_length;
+    size_t outbox_capacity;
+    bool wants_snapshot;
+} LockstepPeer;
+
+/**
+ * Lockstep synchronisation state.
+ */
+typedef struct
+{
+    LockstepRole role;
+    int listen_socket;                      /* Coordinator */
+    LockstepPeer nodes[LOCKSTEP_MAX_NODES]; /* Coordinator */
+    int node_count;
+    LockstepPeer coordinator; /* Node */
+    InputCommand inputs[LOCKSTEP_INPUTS_PER_FRAME]; /* Inputs of the current frame */
+    int input_count;
+    bool overflowed; /* Inputs were dropped, so nodes need a snapshot */
+    Uint32 step;
+    bool resync_pending; /* Node asked for a snapshot and ignores checksums until it arrives */
+    Uint64 frame_bytes;    /* Bytes of frame messages sent or received */
+    Uint64 snapshot_bytes;
+    Uint32 frames;
+    Uint32 snapshots;
+    Uint32 divergences;
+    Uint8 *message; /* Payload of the last parsed message */
+    size_t message_capacity;
+} Lockstep;
+
+/**
+ * Stages of a frame timed by the flight recorder.
+ */
+typedef enum
+{
+    STAGE_EVENTS,
+    STAGE_PHYSICS,
+    STAGE_RENDER,
+    STAGE_PRESENT,
+    STAGE_COUNT
+} FrameStage;
+
+/**
+ * Timings and input commands of one frame.
+ */
+typedef struct
+{
+    Uint32 frame;
+    float stage_ms[STAGE_COUNT];
+    float total_ms;
+    float latency_ms; /* Input-to-present latency of the newest drag sample, negative if none */
+    float render_scale; /* Fraction of the output resolution rendered */
+    Uint32 input_count; /* Commands, with an INPUT_STEP where each physics step completed */
+    Uint32 dropped_inputs; /* Commands past the limit, which a replay of the frame misses */
+    InputCommand inputs[RECORDER_INPUTS_PER_FRAME];
+} FrameRecord;
+
+/**
+ * Live statistics in WebAssembly memory, updated every frame and read by
+ * index.html for its stats readout.
+ */
+typedef struct
+{
+    Uint32 frame;                /* Frames run */
+    Uint32 steps;                /* Physics steps run */
+    Uint32 dots;
+    Uint32 substeps;
+    float fps;                   /* Frames per second, smoothed */
+    float frame_ms;              /* Frame time, smoothed */
+    float stage_ms[STAGE_COUNT]; /* Stage times, smoothed */
+    float latency_ms;            /* Newest input-to-present latency, or -1 before the first drag */
+    float render_scale;          /* Fraction of the output resolution rendered */
+} SharedStats;
+
+/**
+ * Stage times of recent frames on the page's performance.now() clock,
+ * passed to the page in batches as performance.measure() entries.
+ */
+typedef struct
+{
+    double times[TIMELINE_BATCH_FRAMES][2 + 2 * STAGE_COUNT]; /* Frame start and end, then each stage's; 0 if not run */
+    int count;                                                /* Frames buffered */
+    double offset_ms;                                         /* performance.now() minus the performance counter */
+    bool aligned;                                             /* offset_ms measured */
+    Uint64 last_frame_start;                                  /* For the frame rate */
+} Timeline;
+
+/**
+ * Full simulation state captured at the start of a frame.
+ */
+typedef struct
+{
+    Uint32 frame;
+    bool valid;
+    DragState drag;
+    Dot *dots;
+} StateKeyframe;
+
+/**
+ * Ring buffer of recent frames plus periodic state keyframes. When a frame
+ * exceeds the threshold, the window around it is dumped to disk once
+ * RECORDER_POST_FRAMES further frames have been captured.
+ */
+typedef struct
+{
+    FrameRecord frames[RECORDER_FRAMES];
+    StateKeyframe keyframes[RECORDER_KEYFRAMES];
+    Uint32 frame;         /* Frame currently being recorded */
+    Uint64 frame_start;   /* Performance counter at frame start */
+    Uint32 slow_frame;    /* Slow frame awaiting a dump */
+    bool dump_pending;
+    float threshold_ms;
+} FlightRecorder;
+
+/**
+ * Header of a flight recorder dump. Followed by the keyframe's DragState,
+ * rows * cols Dots, and frame_count FrameRecords.
+ */
+typedef struct
+{
+    Uint32 magic;
+    Uint32 version;
+    Sint32 rows;
+    Sint32 cols;
+    Uint32 first_frame; /* Frame of the keyframe the dump starts from */
+    Uint32 frame_count;
+    Uint32 slow_frame;
+    float threshold_ms;
+    Uint32 physics_mode; /* PhysicsMode the recording was made with */
+    PhysicsParams params;
+} RecordingHeader;
+
+/**
+ * One recorded frame in the history arena: the state after the frame's
+ * physics steps. Its data starts with
+ * one Uint32 byte count per chunk, followed by the encoded chunks.
+ */
+typedef struct
+{
+    Uint32 frame;
+    bool keyframe;       /* Full state rather than a delta to the previous frame */
+    bool rest;           /* Deltas include rest positions, which a morph may have moved */
+    DragState drag;      /* Drag state after the frame */
+    int morph_shape;     /* Morph state after the frame, to restore the targets */
+    bool morph_settling;
+    bool morph_shaped;
+    size_t offset;       /* Offset of the entry's data in the arena */
+    size_t size;         /* Size of the entry's data in bytes */
+} HistoryEntry;
+
+/**
+ * Bounded-memory rewind history. Each frame that completed a physics step is
+ * split into chunks of dots that worker threads encode while the frame
+ * renders: keyframes store exact state, other frames store zigzag varint deltas of quantised positions and velocities,
+ * and of rest positions while a morph may move them.
+ * The oldest entries are evicted when the arena is full.
+ */
+typedef struct
+{
+    bool enabled;
+    Uint8 *arena;
+    size_t capacity;
+    size_t head; /* Arena offset where the next entry is written */
+    HistoryEntry *entries;
+    int first; /* Index of the oldest entry in the entry ring */
+    int count;
+    int chunk_count;
+    size_t chunk_dots;      /* Dots per chunk (the last chunk may be shorter) */
+    Sint32 *reference;      /* Quantised x, y, vx, vy, rest x, rest y per dot as last encoded */
+    Uint8 **chunk_data;     /* Per-chunk encode buffers */
+    Uint32 *chunk_size;     /* Encoded bytes per chunk for the current job */
+    Uint32 next_frame;      /* Number of the next recorded frame */
+    bool force_keyframe;
+    /* Current encode job */
+    Uint32 job_frame;
+    bool job_keyframe;
+    bool job_rest;
+    bool rest_shaped; /* Rest positions were off the lattice at the last recorded frame */
+    DragState job_drag;
+    int job_morph_shape;
+    bool job_morph_settling;
+    bool job_morph_shaped;
+    bool job_active;
+    /* Encoder threads */
+    SDL_Thread *workers[HISTORY_MAX_WORKERS];
+    int worker_count;
+    SDL_sem *start;
+    SDL_sem *done;
+    SDL_atomic_t next_chunk;
+    SDL_atomic_t pending;
+    bool quit;
+    /* Scrubbing */
+    bool paused;
+    bool scrubbed; /* Grid shows a decoded frame instead of the live state */
+    Uint32 cursor; /* Frame shown while scrubbing */
+    /* Cost, reported at shutdown */
+    Uint32 recorded_frames;
+    double physics_ms;                         /* Physics stage time of the frames recorded */
+    double main_ms;                            /* Main thread time in history_submit() */
+    double wait_ms;                            /* Main thread time in history_wait(), encoders still busy */
+    double encode_ms[HISTORY_MAX_WORKERS + 1]; /* Encode and commit time per worker, then on the main thread */
+} History;
+
+/**
+ * Input-to-present latency of drag samples. Each presented frame contributes
+ * the newest drag sample it consumed; older samples it superseded are counted
+ * as coalesced. Times are performance counter values.
+ */
+typedef struct
+{
+    bool pending;           /* A drag sample is waiting to be presented */
+    Uint64 input_counter;   /* When that sample was generated */
+    Uint64 consume_counter; /* When the frame consumed it */
+    Uint32 consume_frame;   /* Frame that consumed it */
+    Sint32 x;               /* Where the sample put the dragged dot */
+    Sint32 y;
+    Uint32 coalesced;
+    float latency_ms[LATENCY_MAX_SAMPLES]; /* Input to present, ring of presented samples */
+    float queue_ms[LATENCY_MAX_SAMPLES];   /* Input to consume, same ring */
+    Uint32 samples;
+    bool verify_pixels; /* Read back the dragged dot's pixel after present */
+    Uint32 verified;
+    Uint32 missed;
+    bool periodic_report;
+    Uint32 last_report;
+} LatencyStats;
+
+/**
+ * Synthetic mouse input for the headless latency benchmark. A thread pushes
+ * motion events and records when each was generated, in queue order, so the
+ * consuming frame can match them up.
+ */
+typedef struct
+{
+    bool active;
+    SDL_Thread *thread;
+    SDL_mutex *lock;
+    Uint64 stamps[LATENCY_INJECT_QUEUE]; /* Guarded by lock */
+    Uint32 head;
+    Uint32 tail;
+    SDL_atomic_t quit;
+    int center_x;
+    int center_y;
+} LatencyInjector;
+
+/**
+ * Pixel layouts accepted from a frame source.
+ */
+typedef enum
+{
+    FRAME_GREY, /* 1 byte per pixel, modulates the dot colour */
+    FRAME_RGB,  /* 3 bytes per pixel, replaces the dot colour */
+} FrameFormat;
+
+/**
+ * Stream of raw frames driving per-dot colours. Regular files are memory
+ * mapped and read in place; pipes are read by a thread into a ring of
+ * preallocated buffers. Frames are resampled to the grid with nearest
+ * neighbour sampling.
+ */
+typedef struct
+{
+    bool active;
+    FrameFormat format;
+    int width;
+    int height;
+    int channels;
+    size_t frame_bytes;
+    Uint32 interval_ms;
+    Uint32 next_frame_ticks;
+    Uint32 frames_shown;
+    Sint32 *column_map; /* Source column of each grid column */
+    Uint8 *row_scratch; /* One grid row of gathered grey pixels */
+    /* Memory mapped file */
+    const Uint8 *mapping;
+    size_t mapping_size;
+    size_t frame_count;
+    size_t next_index;
+    /* Streamed pipe */
+    FILE *stream;
+    Uint8 *ring[FRAME_RING_SIZE];
+    int consume_slot;
+    SDL_Thread *reader;
+    SDL_sem *free_slots;
+    SDL_sem *full_slots;
+    SDL_atomic_t ended;
+} FrameSource;
+
+/**
+ * Rest-shape morphing: rest positions are blended toward a target each step,
+ * and the springs and restoring force carry the sheet after them. Targets are
+ * either the lattice or one of the shapes loaded from brightness maps, kept
+ * as displacements from the lattice.
+ */
+typedef struct
+{
+    float *target_x;  /* Rest position each dot is blended toward */
+    float *target_y;
+    float *shape_dx;  /* shape_count displacement fields, one per loaded shape */
+    float *shape_dy;
+    int shape_count;
+    int shape;        /* Shown shape, or -1 for the lattice */
+    float rate;
+    bool settling;    /* Whether some rest position has not reached its target yet */
+    bool shaped;      /* Whether rest positions may differ from the lattice */
+} Morph;
+
+/**
+ * Velocity changes queued as (index, fx, fy) float records, from JavaScript in
+ * the browser build. They are added to the dots between physics steps.
+ */
+typedef struct
+{
+    float *records;
+    int count;    /* Records queued */
+    int capacity; /* Records the buffer holds */
+} ForceQueue;
+
+#ifdef HAS_TERMINAL_VIEW
+/**
+ * Terminal backend: rasterizes dots into Unicode Braille cells (2x4 dots per
+ * character) and writes only the cells that changed since the previous frame,
+ * batched into a single write. Mouse input arrives as SGR mouse reports.
+ */
+typedef struct
+{
+    bool active;
+    int cols; /* Character cells used for the sheet */
+    int rows; /* Excludes the status line */
+    Uint8 *cells;    /* Braille dot bits per cell for the current frame */
+    Uint8 *previous; /* Cells as last written to the terminal */
+    char *output;
+    size_t output_capacity;
+    size_t output_length;
+    float scale; /* Braille dots per window pixel */
+    float offset_x;
+    float offset_y;
+    bool full_redraw;
+    struct termios saved_termios;
+    char input[64]; /* Unparsed tail of stdin */
+    size_t input_length;
+    Uint32 last_status;
+    Uint32 status_frames;
+    size_t status_bytes;
+} TerminalView;
+#endif
+
+/**
+ * Command line options.
+ */
+typedef struct
+{
+    int rows;
+    int cols;
+    float slow_ms;
+    size_t history_bytes;
+    const char *replay_path;
+    const char *script_path;
+    int latency_frames;
+    bool render_bench;
+    const char *render_bench_path; /* Flight recorder dump for --render-bench, or NULL */
+    int stress_seeds;    /* --stress-bench seed count, or 0 */
+    Uint32 stress_seed;  /* First --stress-bench seed */
+    int scaling_threads; /* --scaling-bench thread count, or 0 */
+    int sweep_threads;   /* --sweep thread count, or 0 */
+    double settle_ms;    /* --sweep quality constraint */
+    double max_strain;
+    bool grid_given;
+    bool terminal_view;
+    const char *frames_path;
+    int frame_width;
+    int frame_height;
+    FrameFormat frame_format;
+    int frame_rate;
+    const char *morph_path;
+    int morph_width;
+    int morph_height;
+    float morph_rate;
+    ColorMode color_mode;
+    RenderBackend render_backend;
+    PhysicsMode physics_mode;
+    PhysicsParams physics_params;
+    float step_budget_ms;   /* 0 runs every physics step whole */
+    int substeps;           /* Physics steps per frame */
+    float dynres_target_ms; /* 0 when dynamic resolution is off */
+    int wall_cols;
+    int wall_rows;
+    int wall_tile_col; /* Single window of the wall shown, or -1 for all */
+    int wall_tile_row;
+    int lockstep_port;           /* Serve lockstep nodes on this port, or 0 */
+    const char *lockstep_join;   /* Coordinator HOST:PORT to follow, or NULL */
+} Options;
+
+/* Global State */
+static int g_grid_rows = GRID_ROWS;
+static int g_grid_cols = GRID_COLS;
+static Dot *g_dots = NULL; /* g_grid_rows * g_grid_cols dots, row-major */
+static Arena g_arena;
+static DragState g_drag_state = {.is_dragging = false, .row = -1, .col = -1};
+static DragSamples g_drag_samples;
+static int g_substeps = 1; /* Physics steps per frame */
+static PhysicsParams g_physics_params = {SPRING_STIFFNESS, VELOCITY_DAMPING, RESTORING_FORCE_STRENGTH};
+#ifdef __EMSCRIPTEN__
+static PointerRing g_pointer_ring = {.size = POINTER_RING_SIZE};
+static SharedStats g_stats = {.latency_ms = -1.0f};
+static Timeline g_timeline;
+#endif
+static FlightRecorder g_recorder;
+static History g_history;
+static LatencyStats g_latency = {.periodic_report = true};
+static LatencyInjector g_injector;
+static FrameSource g_frames;
+static SDL_Color *g_dot_colors = NULL; /* Per-dot colours while a frame source is active */
+static Morph g_morph;
+static ColorMode g_color_mode = COLOR_SOLID;
+static PhysicsMode g_physics_mode = PHYSICS_FLOAT;
+static FixedPhysics g_fixed;
+static PhysicsSlicer g_slice;
+static ForceQueue g_forces;
+static Script g_script; /* --script input played in the live app and the render benchmark */
+static PowerState g_power;
+static SDL_Color g_palette[COLOR_PALETTE_SIZE];
+static RenderState g_render;
+static View g_view = {WINDOW_WIDTH, WINDOW_HEIGHT, 0, 0, 1.0f, 1.0f, 0, 0};
+static Tiles g_tiles;
+static VideoWall g_wall = {.cols = 1, .rows = 1};
+static Lockstep g_lockstep = {.listen_socket = -1, .coordinator = {.socket = -1}};
+static DynamicResolution g_dynres = {.scale = 1.0f, .reported_scale = 1.0f};
+#ifdef HAS_TERMINAL_VIEW
+static TerminalView g_terminal;
+static volatile sig_atomic_t g_terminal_resized = 0;
+static volatile sig_atomic_t g_terminal_interrupted = 0;
+#endif
+static bool g_late_latch = true;
+static SDL_Window *g_window = NULL;
+static SDL_Renderer *g_renderer = NULL;
+static bool g_running = true;
+
+static const char *const k_stage_names[STAGE_COUNT] = {"events", "physics", "render", "present"};
+static const char *const k_color_mode_names[COLOR_MODE_COUNT] = {"solid", "speed", "strain"};
+static const char *const k_render_backend_names[RENDER_BACKEND_COUNT] = {"points", "geometry", "sprite", "raster"};
+static const char *const k_physics_mode_names[PHYSICS_MODE_COUNT] = {"float", "fixed"};
+
+/* Values --sweep combines */
+static const double k_sweep_stiffness[] = {0.05, 0.1, 0.15, 0.2, 0.25, 0.3};
+static const double k_sweep_damping[] = {0.8, 0.85, 0.9, 0.95, 0.98};
+static const double k_sweep_restoring[] = {0.002, 0.005, 0.01, 0.02, 0.05};
+static const int k_sweep_substeps[] = {1, 2, 3, 4};
+
+/* Function Prototypes */
+static size_t arena_estimate(const Options *options);
+static bool arena_reserve(size_t bytes);
+static void *arena_alloc(size_t bytes);
+static void *arena_realloc(void *pointer, size_t old_bytes, size_t new_bytes);
+static bool arena_contains(const void *pointer);
+static void arena_free(void *pointer);
+static void arena_release(void);
+static bool allocate_grid(int rows, int cols);
+static void initialize_grid(void);
+static void sheet_rest(const Sheet *sheet);
+static void lattice_position(int row, int col, float *x, float *y);
+static float spring_rest_length(const Dot *dot_a, const Dot *dot_b);
+static void apply_spring_force(Dot *dot_a, Dot *dot_b, double stiffness);
+static void apply_restoring_force(Dot *dot, double strength);
+static void update_physics(void);
+static void physics_integrate_rows(const Sheet *sheet, int row_begin, int row_end);
+static void physics_spring_rows(const Sheet *sheet, int row_begin, int row_end);
+static bool fixed_reserve(int cols);
+static void fixed_shutdown(void);
+static void fixed_load_row(int row, int slot);
+static void fixed_store_row(int row, int slot);
+static void fixed_spring_row(const Sint32 *x_a, const Sint32 *y_a, const Sint32 *x_b, const Sint32 *y_b,
+                             const Sint32 *rest_x_a, const Sint32 *rest_y_a, const Sint32 *rest_x_b,
+                             const Sint32 *rest_y_b, Sint32 *force_x, Sint32 *force_y, int count);
+static void update_physics_fixed(void);
+static void fixed_step_begin(void);
+static void fixed_step_rows(int row_begin, int row_end);
+static bool physics_slice_begin(void);
+static bool physics_slice_advance(Uint64 start);
+static bool physics_step_frame(void);
+static void physics_slice_shutdown(void);
+static void build_palette(void);
+static void render_shade_speed(const Dot *dots, Uint8 *shades, int count);
+static void render_shade_strain(int row, int col_begin, int col_end, Uint8 *shades);
+static bool render_prepare(SDL_Renderer *renderer, RenderState *state, const View *view);
+static void render_raster_dot(RenderState *state, float x, float y, SDL_Color color);
+static bool tiles_update(void);
+static void render_build(RenderState *state, const View *view, SDL_Renderer *renderer);
+static void render_submit(SDL_Renderer *renderer, RenderState *state, const View *view);
+static void render_grid(SDL_Renderer *renderer);
+static void render_state_free(RenderState *state);
+static void render_shutdown(void);
+static bool dynres_begin(SDL_Renderer *renderer);
+static void dynres_end(SDL_Renderer *renderer);
+static void dynres_update(void);
+static void dynres_shutdown(void);
+static void handle_mouse_event(const SDL_Event *event);
+static void pointer_input(InputType type, Sint32 x, Sint32 y, Uint64 input_counter);
+static void drag_samples_begin_frame(void);
+static void drag_samples_apply(int substep, int substeps);
+static void drag_samples_flush(void);
+static void view_update(SDL_Window *window, SDL_Renderer *renderer, View *view);
+static View *view_for_window(Uint32 window_id);
+static bool wall_init(int cols, int rows, int tile_col, int tile_row);
+static int wall_worker(void *data);
+static void wall_begin(void);
+static void wall_end(void);
+static void wall_present(void);
+static void wall_shutdown(void);
+static void apply_input_command(const InputCommand *command);
+static void sheet_apply_input(const Sheet *sheet, DragState *drag, const InputCommand *command);
+static bool drag_state_valid(const DragState *drag, int rows, int cols);
+static bool recorder_init(float threshold_ms);
+static void recorder_shutdown(void);
+static void recorder_begin_frame(void);
+static Uint64 recorder_end_stage(FrameStage stage, Uint64 stage_start);
+static void recorder_log_input(const InputCommand *command);
+static void recorder_note_step(void);
+static void recorder_end_frame(void);
+static bool recorder_dump(void);
+static FrameRecord *recording_load(const char *path, RecordingHeader *header, bool keep_grid);
+static int run_replay_benchmark(const Options *options);
+static Uint32 script_frames(double ms);
+static bool script_error(const ScriptCompiler *compiler, int line, const char *message);
+static bool script_numbers(char *const *tokens, int count, double *values);
+static bool script_emit(Script *script, Uint32 frame, InputType type, int touch, float x, float y);
+static bool script_emit_path(ScriptCompiler *compiler, Script *script, Uint32 frame, Uint32 frames, int pointer,
+                             const double *points, int point_count);
+static bool script_compile_statement(ScriptCompiler *compiler, Script *script, int line, char **tokens, int count,
+                                     Uint32 frame, Uint32 *frames);
+static bool script_compile_block(ScriptCompiler *compiler, Script *script, int *line, Uint32 frame, bool parallel,
+                                 Uint32 *frames);
+static int compare_script_events(const void *a, const void *b);
+static bool script_compile(char *text, const char *name, Script *script);
+static bool script_load(const char *path, Script *script);
+static void script_free(Script *script);
+static void script_play_frame(Script *script);
+static FrameRecord *script_records(const Script *script);
+static bool history_init(size_t budget_bytes);
+static void history_shutdown(void);
+static int history_worker(void *data);
+static void history_encode_chunk(int chunk);
+static void history_commit(void);
+static void history_submit(void);
+static void history_wait(void);
+static bool history_seek(Uint32 frame);
+static void history_set_paused(bool paused);
+static void history_update_title(void);
+static void handle_key_event(const SDL_Event *event);
+static void late_latch_drag(void);
+static Uint64 latency_event_time(const SDL_Event *event, Uint32 queued_ahead, bool consume);
+static void latency_note_input(Uint64 input_counter, Sint32 x, Sint32 y);
+static void latency_record_present(void);
+static void latency_report(void);
+static void latency_print_distribution(const char *label, const float *values, Uint32 count, bool histogram);
+static int latency_injector_thread(void *data);
+static int run_latency_benchmark(int frames);
+static void render_bench_frame(SDL_Renderer *renderer, RenderState *state, const View *view,
+                               double stage_ms[RENDER_BENCH_STAGES]);
+static void render_bench_report(const char *name, const double stage_ms[RENDER_BENCH_STAGES], double max_ms,
+                                double cpu_ms, int frames, double dots);
+static int run_render_benchmark(const char *path);
+static Uint32 stress_random(Uint64 *state);
+static int stress_range(Uint64 *state, int low, int high);
+static bool stress_append(char *text, size_t *length, const char *format, ...);
+static bool stress_generate(Uint32 seed, char *text);
+static void stress_print_distribution(const char *label, float *values, size_t count);
+static int compare_stress_results(const void *a, const void *b);
+static int run_stress_benchmark(int seeds, Uint32 first_seed);
+static void sheet_init(const Sheet *sheet);
+static void sheet_step(const Sheet *sheet);
+static int scaling_worker(void *data);
+static double scaling_run(ScalingTask *tasks, int count);
+static double scaling_stream_probe(int threads);
+static double scaling_compute_probe(int threads);
+static double scaling_measure(int threads, int rows, int total_rows, int cols, int steps, double base_rate,
+                              const ScalingProbes *probes);
+static int run_scaling_benchmark(int max_threads, int rows, int cols);
+static void sheet_measure(const Sheet *sheet, float *distance, float *speed, float *strain);
+static void sweep_run(const Script *script, Dot *dots, SweepResult *result);
+static int sweep_worker(void *data);
+static int compare_sweep_results(const void *a, const void *b);
+static const char *sweep_verdict(const SweepResult *result, int settle_frames, double max_strain);
+static void sweep_print_result(const SweepResult *result, const char *verdict, const char *note);
+static int run_parameter_sweep(int threads, double settle_ms, double max_strain);
+static bool init_simulation(const Options *options);
+static void shutdown_simulation(void);
+static bool parse_options(int argc, char *argv[], Options *options);
+static bool frame_source_open(const char *path, int width, int height, FrameFormat format, int rate);
+static void frame_source_close(void);
+static int frame_source_reader(void *data);
+static void frame_source_update(void);
+static void frame_source_resample(const Uint8 *frame);
+static size_t morph_file_shapes(const char *path, int width, int height);
+static bool morph_load(const char *path, int width, int height, float rate);
+static void morph_shutdown(void);
+static void morph_show(int shape);
+static void morph_step(void);
+static void forces_apply(void);
+static void forces_shutdown(void);
+static void power_window_event(const SDL_WindowEvent *event);
+static bool power_sheet_moving(void);
+static Sint32 fixed_power(Sint32 factor, Uint32 exponent);
+static void power_fast_forward(Sint32 steps);
+#ifdef __EMSCRIPTEN__
+Dot *dms_dots(void);
+int dms_dot_count(void);
+int dms_dot_stride(void);
+int dms_grid_cols(void);
+float *dms_force_buffer(int count);
+int dms_apply_forces(int count);
+PointerRing *dms_pointer_ring(void);
+static void pointer_ring_drain(void);
+static Uint64 pointer_sample_convert(const PointerSample *sample, Sint32 *x, Sint32 *y);
+static bool pointer_ring_peek_move(Sint32 *x, Sint32 *y, Uint64 *input_counter);
+SharedStats *dms_stats(void);
+static double timeline_ms(Uint64 counter);
+static void timeline_note_stage(FrameStage stage, Uint64 stage_start, Uint64 stage_end);
+static void browser_end_frame(const FrameRecord *record, Uint64 frame_end);
+#endif
+#ifdef HAS_TERMINAL_VIEW
+static bool terminal_init(void);
+static void terminal_shutdown(void);
+static bool terminal_resize(void);
+static void terminal_poll_input(void);
+static void terminal_handle_sequence(const char *sequence, size_t length);
+static void terminal_render(void);
+static void terminal_present(void);
+static int run_terminal_view(void);
+#endif
+static void lockstep_log_input(const InputCommand *command);
+static void lockstep_note_step(void);
+#ifdef HAS_LOCKSTEP
+static Uint32 lockstep_checksum(void);
+static bool lockstep_serve(int port);
+static bool lockstep_join(const char *address);
+static bool lockstep_send(LockstepPeer *peer, const LockstepHeader *header, const void *payload, size_t payload_bytes,
+                          const void *extra, size_t extra_bytes);
+static bool lockstep_flush(LockstepPeer *peer);
+static bool lockstep_send_snapshot(LockstepPeer *peer);
+static bool lockstep_receive(LockstepPeer *peer);
+static size_t lockstep_payload_limit(Uint32 type);
+static bool lockstep_grid_matches(const LockstepState *state);
+static int lockstep_next_message(LockstepPeer *peer, LockstepHeader *header, Uint8 **payload);
+static void lockstep_drop_node(int node);
+static void lockstep_broadcast(void);
+static void lockstep_follow(void);
+static void lockstep_shutdown(void);
+#endif
+static bool sheet_find_dot(const Sheet *sheet, int mouse_x, int mouse_y, int *row, int *col);
+static void draw_filled_circle(SDL_Renderer *renderer, int center_x, int center_y, int radius);
+static void main_loop(void);
+
+/**
+ * Returns the dot at the given grid position.
+ */
+static inline Dot *dot_at(int row, int col)
+{
+    return &g_dots[row * g_grid_cols + col];
+}
+
+/**
+ * Returns the live sheet.
+ */
+static inline Sheet live_sheet(void)
+{
+    return (Sheet){g_dots, g_grid_rows, g_grid_cols, &g_physics_params};
+}
+
+/**
+ * Returns the dot at the given position of a sheet.
+ */
+static inline Dot *sheet_dot(const Sheet *sheet, int row, int col)
+{
+    return &sheet->dots[row * sheet->cols + col];
+}
+
+/**
+ * Computes the arena size for a run with the given options: the sum of the
+ * grid-sized arrays init_simulation() and the first frames allocate.
+ *
+ * @param options Parsed command line options
+ * @return Bytes to reserve
+ */
+static size_t arena_estimate(const Options *options)
+{
+    const size_t dot_count = (size_t)options->rows * (size_t)options->cols;
+    const size_t cols = (size_t)options->cols;
+    const size_t tiles = (((size_t)options->rows + RENDER_TILE_DOTS - 1) / RENDER_TILE_DOTS) *
+                         ((cols + RENDER_TILE_DOTS - 1) / RENDER_TILE_DOTS);
+
+    /* Grid, flight recorder keyframes, tile bounds and one row of palette indices */
+    size_t bytes = dot_count * sizeof(Dot) * (1 + RECORDER_KEYFRAMES) + tiles * sizeof(TileBounds) + cols;
+#ifdef HAS_RENDER_GEOMETRY
+    bytes += RENDER_BATCH_DOTS * (4 * sizeof(SDL_Vertex) + 6 * sizeof(int));
+#endif
+    if (options->render_backend == RENDER_RASTER || options->render_backend == RENDER_SPRITE)
+    {
+        /* The CPU raster at the initial window size; the sprite backend falls back to it */
+        bytes += (size_t)WINDOW_WIDTH * WINDOW_HEIGHT * sizeof(Uint32);
+    }
+    if (options->step_budget_ms > 0.0f)
+    {
+        bytes += dot_count * sizeof(Dot); /* Snapshot shown during sliced steps */
+    }
+    if (options->physics_mode == PHYSICS_FIXED)
+    {
+        bytes += (cols + 1) * FIXED_ROW_BUFFERS * sizeof(Sint32);
+    }
+    if (options->history_bytes > 0)
+    {
+        const size_t chunks = HISTORY_MAX_WORKERS * HISTORY_CHUNKS_PER_WORKER;
+        bytes += options->history_bytes + HISTORY_MAX_ENTRIES * sizeof(HistoryEntry) +
+                 dot_count * HISTORY_VALUES * sizeof(Sint32) + (dot_count + chunks) * HISTORY_DELTA_DOT_BYTES +
+                 chunks * (sizeof(Uint8 *) + 4);
+    }
+    if (options->frames_path)
+    {
+        bytes += dot_count * sizeof(SDL_Color) + cols * (sizeof(Sint32) + 1) + 16;
+    }
+    if (options->morph_path)
+    {
+        const size_t shapes = morph_file_shapes(options->morph_path, options->morph_width, options->morph_height);
+        bytes += dot_count * 2 * sizeof(float) * (1 + shapes); /* Targets and displacement fields */
+    }
+    return bytes + ARENA_MAX_ALLOCATIONS * ARENA_ALIGNMENT;
+}
+
+/**
+ * Reserves the arena. Without one, every allocation falls back to malloc.
+ *
+ * @param bytes Size of the arena
+ * @return true on success, false if the block could not be allocated
+ */
+static bool arena_reserve(size_t bytes)
+{
+    /* Zeroed up front, so carved arrays start zeroed like calloc */
+    Uint8 *block = calloc(1, bytes + ARENA_ALIGNMENT);
+    if (!block)
+    {
+        return false;
+    }
+
+    g_arena.base = block;
+    g_arena.capacity = bytes + ARENA_ALIGNMENT;
+    g_arena.used = (size_t)(-(uintptr_t)block & (ARENA_ALIGNMENT - 1));
+    g_arena.last = g_arena.used;
+    return true;
+}
+
+/**
+ * Carves a zeroed, ARENA_ALIGNMENT-aligned array off the arena, or allocates
+ * it with calloc when the arena is full or not reserved.
+ *
+ * @param bytes Size of the array
+ * @return The array, or NULL if allocation failed
+ */
+static void *arena_alloc(size_t bytes)
+{
+    const size_t padded = (bytes + ARENA_ALIGNMENT - 1) & ~(size_t)(ARENA_ALIGNMENT - 1);
+    if (g_arena.base && padded >= bytes && padded <= g_arena.capacity - g_arena.used)
+    {
+        g_arena.last = g_arena.used;
+        g_arena.used += padded;
+        return g_arena.base + g_arena.last;
+    }
+    return calloc(1, bytes ? bytes : 1);
+}
+
+/**
+ * Resizes an array from arena_alloc(), keeping its contents.
+ *
+ * @param pointer Array to resize, or NULL
+ * @param old_bytes Its current size
+ * @param new_bytes Size wanted
+ * @return The resized array, or NULL with the original left intact
+ */
+static void *arena_realloc(void *pointer, size_t old_bytes, size_t new_bytes)
+{
+    void *resized = arena_alloc(new_bytes);
+    if (resized && pointer)
+    {
+        memcpy(resized, pointer, old_bytes < new_bytes ? old_bytes : new_bytes);
+        arena_free(pointer);
+    }
+    return resized;
+}
+
+/**
+ * Tells whether an array was carved from the arena rather than allocated on
+ * the heap. Only reads the arena bounds, so threads may call it.
+ *
+ * @param pointer Array to check, or NULL
+ * @return true if the array lies in the arena
+ */
+static bool arena_contains(const void *pointer)
+{
+    const Uint8 *bytes = pointer;
+    return g_arena.base && bytes >= g_arena.base && bytes < g_arena.base + g_arena.capacity;
+}
+
+/**
+ * Releases an array from arena_alloc(). Arena space is only reclaimed for the
+ * newest allocation; the rest returns when the arena is released.
+ *
+ * @param pointer Array to release, or NULL
+ */
+static void arena_free(void *pointer)
+{
+    Uint8 *bytes = pointer;
+    if (!arena_contains(pointer))
+    {
+        free(pointer);
+        return;
+    }
+
+    if (bytes == g_arena.base + g_arena.last)
+    {
+        memset(bytes, 0, g_arena.used - g_arena.last);
+        g_arena.used = g_arena.last;
+    }
+}
+
+/**
+ * Frees the arena. Arrays carved from it must no longer be used.
+ */
+static void arena_release(void)
+{
+    free(g_arena.base);
+    g_arena = (Arena){0};
+}
+
+/**
+ * Allocates storage for a rows x cols grid, replacing any previous grid.
+ *
+ * @param rows Number of grid rows
+ * @param cols Number of grid columns
+ * @return true on success, false if allocation failed
+ */
+static bool allocate_grid(int rows, int cols)
+{
+    Dot *dots = arena_alloc((size_t)rows * (size_t)cols * sizeof(Dot));
+    if (!dots)
+    {
+        fprintf(stderr, "Failed to allocate %dx%d grid\n", rows, cols);
+        return false;
+    }
+
+    arena_free(g_dots);
+    g_dots = dots;
+    g_grid_rows = rows;
+    g_grid_cols = cols;
+    return true;
+}
+
+/**
+ * Initializes the dot grid with evenly spaced dots centered in the window.
+ * Sets the top-left and top-right corner dots as fixed anchor points.
+ */
+static void initialize_grid(void)
+{
+    const Sheet sheet = live_sheet();
+    sheet_rest(&sheet);
+}
+
+/**
+ * Fills a sheet the size of the live grid with the lattice initialize_grid()
+ * uses, anchors included.
+ *
+ * @param sheet Sheet to fill
+ */
+static void sheet_rest(const Sheet *sheet)
+{
+    for (int row = 0; row < sheet->rows; row++)
+    {
+        for (int col = 0; col < sheet->cols; col++)
+        {
+            float pos_x;
+            float pos_y;
+            lattice_position(row, col, &pos_x, &pos_y);
+
+            *sheet_dot(sheet, row, col) = (Dot){
+                .x = pos_x,
+                .y = pos_y,
+                .vx = 0.0f,
+                .vy = 0.0f,
+                .original_x = pos_x,
+                .original_y = pos_y,
+                .fixed = false};
+        }
+    }
+
+    /* Fix the top corners as anchor points */
+    sheet_dot(sheet, 0, 0)->fixed = true;
+    sheet_dot(sheet, 0, sheet->cols - 1)->fixed = true;
+}
+
+/**
+ * Computes a dot's position in the evenly spaced lattice centered in the window.
+ *
+ * @param row Grid row
+ * @param col Grid column
+ * @param x Output x position
+ * @param y Output y position
+ */
+static void lattice_position(int row, int col, float *x, float *y)
+{
+    *x = (WINDOW_WIDTH - (g_grid_cols - 1) * SPRING_REST_LENGTH) / 2.0f + col * SPRING_REST_LENGTH;
+    *y = (WINDOW_HEIGHT - (g_grid_rows - 1) * SPRING_REST_LENGTH) / 2.0f + row * SPRING_REST_LENGTH;
+}
+
+/**
+ * Returns the rest length of the spring between two neighbouring dots: the
+ * lattice spacing, or the distance between their rest positions once a shape
+ * has been morphed in.
+ *
+ * @param dot_a First dot
+ * @param dot_b Second dot connected to first dot
+ */
+static float spring_rest_length(const Dot *dot_a, const Dot *dot_b)
+{
+    if (!g_morph.shaped)
+    {
+        return SPRING_REST_LENGTH;
+    }
+
+    const float rest_dx = dot_b->original_x - dot_a->original_x;
+    const float rest_dy = dot_b->original_y - dot_a->original_y;
+    return sqrtf(rest_dx * rest_dx + rest_dy * rest_dy);
+}
+
+/**
+ * Applies spring force between two connected dots using Hooke's Law.
+ * The force is proportional to the displacement from the rest length.
+ *
+ * @param dot_a First dot
+ * @param dot_b Second dot connected to first dot
+ * @param stiffness Force per px of stretch
+ */
+static void apply_spring_force(Dot *dot_a, Dot *dot_b, double stiffness)
+{
+    const float dx = dot_b->x - dot_a->x;
+    const float dy = dot_b->y - dot_a->y;
+    const float distance = sqrtf(dx * dx + dy * dy);
+
+    if (distance < 0.001f)
+    {
+        return; /* Avoid division by zero */
+    }
+
+    const float displacement = distance - spring_rest_length(dot_a, dot_b);
+    const float force_magnitude = displacement * stiffness;
+    const float fx = force_magnitude * (dx / distance);
+    const float fy = force_magnitude * (dy / distance);
+
+    if (!dot_a->fixed)
+    {
+        dot_a->vx += fx;
+        dot_a->vy += fy;
+    }
+
+    if (!dot_b->fixed)
+    {
+        dot_b->vx -= fx;
+        dot_b->vy -= fy;
+    }
+}
+
+/**
+ * Applies a gentle force that pulls the dot back toward its original position.
+ * This helps the grid return to its rest state after being disturbed.
+ *
+ * @param dot The dot to apply restoring force to
+ * @param strength Pull per px of displacement
+ */
+static void apply_restoring_force(Dot *dot, double strength)
+{
+    if (dot->fixed)
+    {
+        return;
+    }
+
+    const float dx = dot->original_x - dot->x;
+    const float dy = dot->original_y - dot->y;
+
+    dot->vx += dx * strength;
+    dot->vy += dy * strength;
+}
+
+/**
+ * Updates all dots' positions and velocities based on physics simulation.
+ * First applies damping and integrates velocity, then applies spring and restoring forces.
+ */
+static void update_physics(void)
+{
+    if (g_physics_mode == PHYSICS_FIXED && fixed_reserve(g_grid_cols))
+    {
+        update_physics_fixed();
+        return;
+    }
+
+    const Sheet sheet = live_sheet();
+    physics_integrate_rows(&sheet, 0, sheet.rows);
+    physics_spring_rows(&sheet, 0, sheet.rows);
+}
+
+/**
+ * First pass of the float step: damps and integrates velocity and applies the
+ * restoring force for a band of rows.
+ *
+ * @param sheet Sheet to step
+ * @param row_begin First row of the band
+ * @param row_end Row after the last row of the band
+ */
+static void physics_integrate_rows(const Sheet *sheet, int row_begin, int row_end)
+{
+    const double damping = sheet->params->damping;
+    const double restoring = sheet->params->restoring;
+    for (int row = row_begin; row < row_end; row++)
+    {
+        for (int col = 0; col < sheet->cols; col++)
+        {
+            Dot *dot = sheet_dot(sheet, row, col);
+
+            if (!dot->fixed)
+            {
+                dot->vx *= damping;
+                dot->vy *= damping;
+                dot->x += dot->vx;
+                dot->y += dot->vy;
+                apply_restoring_force(dot, restoring);
+            }
+        }
+    }
+}
+
+/**
+ * Second pass of the float step: applies the spring forces of every dot in a
+ * band of rows. Springs read only positions, but each one adds to the
+ * velocities of both its dots, so a band also writes the rows either side of
+ * it: bands that touch must not run at the same time. Their order changes
+ * only the rounding of the sums; bands run in order so that sliced steps
+ * stay bit-identical to whole ones.
+ *
+ * @param sheet Sheet to step
+ * @param row_begin First row of the band
+ * @param row_end Row after the last row of the band
+ */
+static void physics_spring_rows(const Sheet *sheet, int row_begin, int row_end)
+{
+    const double stiffness = sheet->params->stiffness;
+    for (int row = row_begin; row < row_end; row++)
+    {
+        for (int col = 0; col < sheet->cols; col++)
+        {
+            Dot *current = sheet_dot(sheet, row, col);
+
+            /* Connect to neighboring dots (up, down, left, right) */
+            if (row > 0)
+            {
+                apply_spring_force(current, sheet_dot(sheet, row - 1, col), stiffness);
+            }
+            if (row < sheet->rows - 1)
+            {
+                apply_spring_force(current, sheet_dot(sheet, row + 1, col), stiffness);
+            }
+            if (col > 0)
+            {
+                apply_spring_force(current, sheet_dot(sheet, row, col - 1), stiffness);
+            }
+            if (col < sheet->cols - 1)
+            {
+                apply_spring_force(current, sheet_dot(sheet, row, col + 1), stiffness);
+            }
+        }
+    }
+}
+
+/**
+ * Clamps a fixed-point value to [-limit, limit].
+ */
+static inline Sint32 fixed_clamp(Sint32 value, Sint32 limit)
+{
+    return value < -limit ? -limit : value > limit ? limit : value;
+}
+
+/**
+ * Converts a position or velocity to 1/4096 px, rounding to nearest.
+ */
+static inline Sint32 fixed_from_float(float value)
+{
+    const float scaled = value * (float)(1 << FIXED_SHIFT);
+    return (Sint32)lrintf(scaled < -FIXED_RANGE ? -FIXED_RANGE : scaled > FIXED_RANGE ? FIXED_RANGE : scaled);
+}
+
+/**
+ * Converts 1/4096 px back to a float. Exact within 4096 px of the origin and
+ * correctly rounded beyond, so the floats in g_dots carry the fixed-point
+ * state from step to step identically on every target.
+ */
+static inline float fixed_to_float(Sint32 value)
+{
+    return (float)value * (1.0f / (1 << FIXED_SHIFT));
+}
+
+/**
+ * Multiplies a value by a factor below one, rounding toward zero so damped
+ * velocities and small offsets decay to exactly zero instead of drifting.
+ *
+ * @param value Fixed-point value, clamped to FIXED_RANGE
+ * @param factor Factor in 1/65536, from 0 to 65535
+ */
+static inline Sint32 fixed_scale(Sint32 value, Sint32 factor)
+{
+    return (Sint32)((Sint64)fixed_clamp(value, FIXED_RANGE) * factor / 65536);
+}
+
+/**
+ * Drops the low bits of a fixed-point value, rounding to nearest.
+ */
+static inline Sint32 fixed_round(Sint32 value, int bits)
+{
+    return (value + (1 << (bits - 1))) >> bits;
+}
+
+/**
+ * Computes the length of a spring in 1/256 px, rounded down. The squares
+ * are exact in double precision and the square root is correctly rounded,
+ * which makes the result the exact integer square root on every target.
+ *
+ * @param dx Spring x component in 1/4096 px
+ * @param dy Spring y component in 1/4096 px
+ * @param sx Output x component in 1/256 px, clamped to FIXED_SPRING_LIMIT
+ * @param sy Output y component in 1/256 px, clamped to FIXED_SPRING_LIMIT
+ */
+static inline Sint32 fixed_spring_length(Sint32 dx, Sint32 dy, Sint32 *sx, Sint32 *sy)
+{
+    *sx = fixed_clamp(fixed_round(dx, FIXED_SHIFT - FIXED_SPRING_SHIFT), FIXED_SPRING_LIMIT);
+    *sy = fixed_clamp(fixed_round(dy, FIXED_SHIFT - FIXED_SPRING_SHIFT), FIXED_SPRING_LIMIT);
+    return (Sint32)sqrt((double)*sx * *sx + (double)*sy * *sy);
+}
+
+/**
+ * Computes the force a spring applies to its first dot, in 1/4096 px/step.
+ * The second dot gets the negated force.
+ *
+ * @param dx Spring x component in 1/4096 px
+ * @param dy Spring y component in 1/4096 px
+ * @param rest Rest length in 1/256 px
+ * @param force_x Output force x component
+ * @param force_y Output force y component
+ */
+static inline void fixed_spring_force(Sint32 dx, Sint32 dy, Sint32 rest, Sint32 *force_x, Sint32 *force_y)
+{
+    Sint32 sx;
+    Sint32 sy;
+    const Sint32 length = fixed_spring_length(dx, dy, &sx, &sy);
+
+    if (length == 0)
+    {
+        *force_x = 0; /* Shorter than 1/256 px: no direction */
+        *force_y = 0;
+        return;
+    }
+
+    /* Stretch times stiffness, then along the spring. Each double operation
+       is exact or rounded once, so the result is the same everywhere too */
+    const Sint32 magnitude = fixed_scale(length - rest, g_fixed.stiffness) *
+                             (1 << (FIXED_SHIFT - FIXED_SPRING_SHIFT));
+    const double inverse = 1.0 / length;
+    *force_x = (Sint32)lrint((double)magnitude * sx * inverse);
+    *force_y = (Sint32)lrint((double)magnitude * sy * inverse);
+}
+
+#ifdef __SSE2__
+/**
+ * Multiplies four pairs of 32-bit lanes, keeping the low 32 bits of each
+ * product, which is the same for signed and unsigned lanes. SSE2 has no
+ * single instruction for it.
+ */
+static inline __m128i fixed_mullo_sse2(__m128i a, __m128i b)
+{
+    const __m128i even = _mm_mul_epu32(a, b);
+    const __m128i odd = _mm_mul_epu32(_mm_srli_epi64(a, 32), _mm_srli_epi64(b, 32));
+    return _mm_unpacklo_epi32(_mm_shuffle_epi32(even, _MM_SHUFFLE(0, 0, 2, 0)),
+                              _mm_shuffle_epi32(odd, _MM_SHUFFLE(0, 0, 2, 0)));
+}
+
+/**
+ * Clamps four lanes to [-limit, limit], as fixed_clamp().
+ */
+static inline __m128i fixed_clamp_sse2(__m128i value, __m128i limit)
+{
+    const __m128i negative_limit = _mm_sub_epi32(_mm_setzero_si128(), limit);
+    const __m128i above = _mm_cmpgt_epi32(value, limit);
+    value = _mm_or_si128(_mm_and_si128(above, limit), _mm_andnot_si128(above, value));
+    const __m128i below = _mm_cmpgt_epi32(negative_limit, value);
+    return _mm_or_si128(_mm_and_si128(below, negative_limit), _mm_andnot_si128(below, value));
+}
+
+/**
+ * Four lanes of fixed_scale(), on magnitudes split in two 32-bit products
+ * since SSE2 has no signed 64-bit multiply.
+ */
+static inline __m128i fixed_scale_sse2(__m128i value, __m128i factor)
+{
+    value = fixed_clamp_sse2(value, _mm_set1_epi32(FIXED_RANGE));
+    const __m128i sign = _mm_srai_epi32(value, 31);
+    const __m128i magnitude = _mm_sub_epi32(_mm_xor_si128(value, sign), sign);
+    const __m128i high = fixed_mullo_sse2(_mm_srai_epi32(magnitude, 16), factor);
+    const __m128i low = fixed_mullo_sse2(_mm_and_si128(magnitude, _mm_set1_epi32(0xFFFF)), factor);
+    const __m128i scaled = _mm_add_epi32(high, _mm_srli_epi32(low, 16));
+    return _mm_sub_epi32(_mm_xor_si128(scaled, sign), sign);
+}
+
+/**
+ * Four lanes of fixed_round().
+ */
+static inline __m128i fixed_round_sse2(__m128i value, int bits)
+{
+    return _mm_srai_epi32(_mm_add_epi32(value, _mm_set1_epi32(1 << (bits - 1))), bits);
+}
+
+/**
+ * Four lanes of fixed_from_float(). Converts with the current rounding mode,
+ * round to nearest like lrintf().
+ */
+static inline __m128i fixed_from_float_sse2(__m128 value)
+{
+    const __m128 scaled = _mm_mul_ps(value, _mm_set1_ps((float)(1 << FIXED_SHIFT)));
+    return _mm_cvtps_epi32(
+        _mm_min_ps(_mm_max_ps(scaled, _mm_set1_ps((float)-FIXED_RANGE)), _mm_set1_ps((float)FIXED_RANGE)));
+}
+
+/**
+ * Four lanes of fixed_spring_length(), two at a time in double precision.
+ */
+static inline __m128i fixed_spring_length_sse2(__m128i dx, __m128i dy, __m128i *sx, __m128i *sy)
+{
+    const __m128i limit = _mm_set1_epi32(FIXED_SPRING_LIMIT);
+    *sx = fixed_clamp_sse2(fixed_round_sse2(dx, FIXED_SHIFT - FIXED_SPRING_SHIFT), limit);
+    *sy = fixed_clamp_sse2(fixed_round_sse2(dy, FIXED_SHIFT - FIXED_SPRING_SHIFT), limit);
+
+    const __m128d low_x = _mm_cvtepi32_pd(*sx);
+    const __m128d low_y = _mm_cvtepi32_pd(*sy);
+    const __m128d high_x = _mm_cvtepi32_pd(_mm_shuffle_epi32(*sx, _MM_SHUFFLE(1, 0, 3, 2)));
+    const __m128d high_y = _mm_cvtepi32_pd(_mm_shuffle_epi32(*sy, _MM_SHUFFLE(1, 0, 3, 2)));
+    const __m128d low = _mm_sqrt_pd(_mm_add_pd(_mm_mul_pd(low_x, low_x), _mm_mul_pd(low_y, low_y)));
+    const __m128d high = _mm_sqrt_pd(_mm_add_pd(_mm_mul_pd(high_x, high_x), _mm_mul_pd(high_y, high_y)));
+    return _mm_unpacklo_epi64(_mm_cvttpd_epi32(low), _mm_cvttpd_epi32(high));
+}
+
+/**
+ * Two lanes of the force along a spring in fixed_spring_force(), rounded to
+ * nearest as lrint() does.
+ */
+static inline __m128i fixed_along_sse2(__m128i magnitude, __m128i component, __m128d inverse)
+{
+    return _mm_cvtpd_epi32(_mm_mul_pd(_mm_mul_pd(_mm_cvtepi32_pd(magnitude), _mm_cvtepi32_pd(component)), inverse));
+}
+
+/**
+ * Four lanes of fixed_spring_force().
+ */
+static inline void fixed_spring_force_sse2(__m128i dx, __m128i dy, __m128i rest, __m128i *force_x,
+                                           __m128i *force_y)
+{
+    __m128i sx;
+    __m128i sy;
+    const __m128i length = fixed_spring_length_sse2(dx, dy, &sx, &sy);
+    const __m128i empty = _mm_cmpeq_epi32(length, _mm_setzero_si128());
+    const __m128i divisor = _mm_or_si128(length, _mm_and_si128(empty, _mm_set1_epi32(1)));
+    __m128i magnitude = fixed_scale_sse2(_mm_sub_epi32(length, rest), _mm_set1_epi32(g_fixed.stiffness));
+    magnitude = _mm_andnot_si128(empty, _mm_slli_epi32(magnitude, FIXED_SHIFT - FIXED_SPRING_SHIFT));
+
+    /* The upper two lanes moved down for the two-lane conversions */
+    const __m128i magnitude_high = _mm_shuffle_epi32(magnitude, _MM_SHUFFLE(1, 0, 3, 2));
+    const __m128i sx_high = _mm_shuffle_epi32(sx, _MM_SHUFFLE(1, 0, 3, 2));
+    const __m128i sy_high = _mm_shuffle_epi32(sy, _MM_SHUFFLE(1, 0, 3, 2));
+    const __m128d one = _mm_set1_pd(1.0);
+    const __m128d inverse = _mm_div_pd(one, _mm_cvtepi32_pd(divisor));
+    const __m128d inverse_high = _mm_div_pd(one, _mm_cvtepi32_pd(_mm_shuffle_epi32(divisor, _MM_SHUFFLE(1, 0, 3, 2))));
+    *force_x = _mm_unpacklo_epi64(fixed_along_sse2(magnitude, sx, inverse),
+                                  fixed_along_sse2(magnitude_high, sx_high, inverse_high));
+    *force_y = _mm_unpacklo_epi64(fixed_along_sse2(magnitude, sy, inverse),
+                                  fixed_along_sse2(magnitude_high, sy_high, inverse_high));
+}
+#endif
+
+/**
+ * Allocates the fixed-point row buffers for a grid width.
+ *
+ * @param cols Number of grid columns
+ * @return true on success, false if allocation failed
+ */
+static bool fixed_reserve(int cols)
+{
+    if (cols <= g_fixed.capacity)
+    {
+        return true;
+    }
+
+    Sint32 **buffers[FIXED_ROW_BUFFERS] = {&g_fixed.x[0], &g_fixed.x[1], &g_fixed.y[0], &g_fixed.y[1],
+                                           &g_fixed.vx[0], &g_fixed.vx[1], &g_fixed.vy[0], &g_fixed.vy[1],
+                                           &g_fixed.rest_x[0], &g_fixed.rest_x[1], &g_fixed.rest_y[0],
+                                           &g_fixed.rest_y[1], &g_fixed.across_x, &g_fixed.across_y,
+                                           &g_fixed.down_x[0], &g_fixed.down_x[1], &g_fixed.down_y[0],
+                                           &g_fixed.down_y[1]};
+    const size_t buffer_count = SDL_arraysize(buffers);
+    const size_t stride = (size_t)cols + 1;
+    Sint32 *block = arena_alloc(stride * buffer_count * sizeof(Sint32));
+    if (!block)
+    {
+        fprintf(stderr, "Failed to allocate fixed-point buffers for %d columns\n", cols);
+        return false;
+    }
+
+    fixed_shutdown();
+    for (size_t i = 0; i < buffer_count; i++)
+    {
+        *buffers[i] = block + i * stride;
+    }
+    g_fixed.capacity = cols;
+    return true;
+}
+
+/**
+ * Releases the fixed-point row buffers.
+ */
+static void fixed_shutdown(void)
+{
+    arena_free(g_fixed.x[0]); /* First buffer of the block */
+    g_fixed = (FixedPhysics){0};
+}
+
+/**
+ * Converts one grid row to fixed point and integrates it: damping, the
+ * velocity step and the restoring force, as the first pass of
+ * update_physics().
+ *
+ * @param row Grid row
+ * @param slot Row buffer slot to fill, 0 or 1
+ */
+static void fixed_load_row(int row, int slot)
+{
+    const Sint32 damping = g_fixed.damping;
+    const Sint32 restoring = g_fixed.restoring;
+    const bool shaped = g_morph.shaped;
+    const Dot *dots = dot_at(row, 0);
+    Sint32 *x = g_fixed.x[slot];
+    Sint32 *y = g_fixed.y[slot];
+    Sint32 *vx = g_fixed.vx[slot];
+    Sint32 *vy = g_fixed.vy[slot];
+    int col = 0;
+#ifdef __SSE2__
+    const __m128i damping4 = _mm_set1_epi32(damping);
+    const __m128i restoring4 = _mm_set1_epi32(restoring);
+    const __m128i range = _mm_set1_epi32(FIXED_RANGE);
+
+    for (; col + 4 <= g_grid_cols; col += 4)
+    {
+        /* Load (x, y, vx, vy) of four dots and transpose, then pair up their rest positions */
+        __m128 state0 = _mm_loadu_ps(&dots[col].x);
+        __m128 state1 = _mm_loadu_ps(&dots[col + 1].x);
+        __m128 state2 = _mm_loadu_ps(&dots[col + 2].x);
+        __m128 state3 = _mm_loadu_ps(&dots[col + 3].x);
+        _MM_TRANSPOSE4_PS(state0, state1, state2, state3);
+        const __m128 rest0 = _mm_castsi128_ps(_mm_loadl_epi64((const __m128i *)&dots[col].original_x));
+        const __m128 rest1 = _mm_castsi128_ps(_mm_loadl_epi64((const __m128i *)&dots[col + 1].original_x));
+        const __m128 rest2 = _mm_castsi128_ps(_mm_loadl_epi64((const __m128i *)&dots[col + 2].original_x));
+        const __m128 rest3 = _mm_castsi128_ps(_mm_loadl_epi64((const __m128i *)&dots[col + 3].original_x));
+        const __m128 rest01 = _mm_unpacklo_ps(rest0, rest1);
+        const __m128 rest23 = _mm_unpacklo_ps(rest2, rest3);
+        const __m128i rest_x = fixed_from_float_sse2(_mm_movelh_ps(rest01, rest23));
+        const __m128i rest_y = fixed_from_float_sse2(_mm_movehl_ps(rest23, rest01));
+        const __m128i moving = _mm_cmpeq_epi32(
+            _mm_setr_epi32(dots[col].fixed, dots[col + 1].fixed, dots[col + 2].fixed, dots[col + 3].fixed),
+            _mm_setzero_si128());
+
+        const __m128i pos_x = fixed_from_float_sse2(state0);
+        const __m128i pos_y = fixed_from_float_sse2(state1);
+        const __m128i vel_x = fixed_from_float_sse2(state2);
+        const __m128i vel_y = fixed_from_float_sse2(state3);
+        const __m128i damped_x = fixed_scale_sse2(vel_x, damping4);
+        const __m128i damped_y = fixed_scale_sse2(vel_y, damping4);
+        const __m128i moved_x = fixed_clamp_sse2(_mm_add_epi32(pos_x, damped_x), range);
+        const __m128i moved_y = fixed_clamp_sse2(_mm_add_epi32(pos_y, damped_y), range);
+        const __m128i pulled_x = _mm_add_epi32(damped_x, fixed_scale_sse2(_mm_sub_epi32(rest_x, moved_x), restoring4));
+        const __m128i pulled_y = _mm_add_epi32(damped_y, fixed_scale_sse2(_mm_sub_epi32(rest_y, moved_y), restoring4));
+
+        _mm_storeu_si128((__m128i *)&x[col], _mm_or_si128(_mm_and_si128(moving, moved_x),
+                                                          _mm_andnot_si128(moving, pos_x)));
+        _mm_storeu_si128((__m128i *)&y[col], _mm_or_si128(_mm_and_si128(moving, moved_y),
+                                                          _mm_andnot_si128(moving, pos_y)));
+        _mm_storeu_si128((__m128i *)&vx[col], _mm_or_si128(_mm_and_si128(moving, pulled_x),
+                                                           _mm_andnot_si128(moving, vel_x)));
+        _mm_storeu_si128((__m128i *)&vy[col], _mm_or_si128(_mm_and_si128(moving, pulled_y),
+                                                           _mm_andnot_si128(moving, vel_y)));
+        if (shaped)
+        {
+            _mm_storeu_si128((__m128i *)&g_fixed.rest_x[slot][col], rest_x);
+            _mm_storeu_si128((__m128i *)&g_fixed.rest_y[slot][col], rest_y);
+        }
+    }
+#endif
+    for (; col < g_grid_cols; col++)
+    {
+        const Dot *dot = &dots[col];
+        Sint32 pos_x = fixed_from_float(dot->x);
+        Sint32 pos_y = fixed_from_float(dot->y);
+        Sint32 vel_x = fixed_from_float(dot->vx);
+        Sint32 vel_y = fixed_from_float(dot->vy);
+        const Sint32 rest_x = fixed_from_float(dot->original_x);
+        const Sint32 rest_y = fixed_from_float(dot->original_y);
+
+        if (!dot->fixed)
+        {
+            vel_x = fixed_scale(vel_x, damping);
+            vel_y = fixed_scale(vel_y, damping);
+            pos_x = fixed_clamp(pos_x + vel_x, FIXED_RANGE);
+            pos_y = fixed_clamp(pos_y + vel_y, FIXED_RANGE);
+            vel_x += fixed_scale(rest_x - pos_x, restoring);
+            vel_y += fixed_scale(rest_y - pos_y, restoring);
+        }
+
+        x[col] = pos_x;
+        y[col] = pos_y;
+        vx[col] = vel_x;
+        vy[col] = vel_y;
+        if (shaped)
+        {
+            g_fixed.rest_x[slot][col] = rest_x;
+            g_fixed.rest_y[slot][col] = rest_y;
+        }
+    }
+}
+
+/**
+ * Adds the spring forces to one grid row's velocities and writes its
+ * positions and velocities back to g_dots, leaving fixed dots untouched.
+ * Like update_physics(), every spring acts twice: once from each end.
+ *
+ * @param row Grid row
+ * @param slot Row buffer slot holding the row, 0 or 1
+ */
+static void fixed_store_row(int row, int slot)
+{
+    const int next = slot ^ 1;
+    Dot *dots = dot_at(row, 0);
+    int col = 0;
+#ifdef __SSE2__
+    const __m128 unit = _mm_set1_ps(1.0f / (1 << FIXED_SHIFT));
+
+    for (; col + 4 <= g_grid_cols; col += 4)
+    {
+        /* Force from the right spring minus the left one, plus the one below minus the one above */
+        const __m128i force_x = _mm_sub_epi32(
+            _mm_add_epi32(_mm_sub_epi32(_mm_loadu_si128((const __m128i *)&g_fixed.across_x[col + 1]),
+                                        _mm_loadu_si128((const __m128i *)&g_fixed.across_x[col])),
+                          _mm_loadu_si128((const __m128i *)&g_fixed.down_x[slot][col])),
+            _mm_loadu_si128((const __m128i *)&g_fixed.down_x[next][col]));
+        const __m128i force_y = _mm_sub_epi32(
+            _mm_add_epi32(_mm_sub_epi32(_mm_loadu_si128((const __m128i *)&g_fixed.across_y[col + 1]),
+                                        _mm_loadu_si128((const __m128i *)&g_fixed.across_y[col])),
+                          _mm_loadu_si128((const __m128i *)&g_fixed.down_y[slot][col])),
+            _mm_loadu_si128((const __m128i *)&g_fixed.down_y[next][col]));
+
+        __m128 state0 = _mm_mul_ps(_mm_cvtepi32_ps(_mm_loadu_si128((const __m128i *)&g_fixed.x[slot][col])), unit);
+        __m128 state1 = _mm_mul_ps(_mm_cvtepi32_ps(_mm_loadu_si128((const __m128i *)&g_fixed.y[slot][col])), unit);
+        __m128 state2 = _mm_mul_ps(_mm_cvtepi32_ps(_mm_add_epi32(
+                                       _mm_loadu_si128((const __m128i *)&g_fixed.vx[slot][col]),
+                                       _mm_add_epi32(force_x, force_x))), unit);
+        __m128 state3 = _mm_mul_ps(_mm_cvtepi32_ps(_mm_add_epi32(
+                                       _mm_loadu_si128((const __m128i *)&g_fixed.vy[slot][col]),
+                                       _mm_add_epi32(force_y, force_y))), unit);
+        _MM_TRANSPOSE4_PS(state0, state1, state2, state3);
+
+        const __m128 states[4] = {state0, state1, state2, state3};
+        for (int lane = 0; lane < 4; lane++)
+        {
+            if (!dots[col + lane].fixed)
+            {
+                _mm_storeu_ps(&dots[col + lane].x, states[lane]);
+            }
+        }
+    }
+#endif
+    for (; col < g_grid_cols; col++)
+    {
+        Dot *dot = &dots[col];
+        if (dot->fixed)
+        {
+            continue;
+        }
+
+        const Sint32 force_x = g_fixed.across_x[col + 1] - g_fixed.across_x[col] + g_fixed.down_x[slot][col] -
+                               g_fixed.down_x[next][col];
+        const Sint32 force_y = g_fixed.across_y[col + 1] - g_fixed.across_y[col] + g_fixed.down_y[slot][col] -
+                               g_fixed.down_y[next][col];
+        dot->x = fixed_to_float(g_fixed.x[slot][col]);
+        dot->y = fixed_to_float(g_fixed.y[slot][col]);
+        dot->vx = fixed_to_float(g_fixed.vx[slot][col] + 2 * force_x);
+        dot->vy = fixed_to_float(g_fixed.vy[slot][col] + 2 * force_y);
+    }
+}
+
+/**
+ * Computes the forces of count springs, each from a dot in the first arrays
+ * to the dot at the same index in the second arrays.
+ *
+ * @param x_a First dots' x positions in 1/4096 px
+ * @param y_a First dots' y positions
+ * @param x_b Second dots' x positions
+ * @param y_b Second dots' y positions
+ * @param rest_x_a First dots' rest x positions, or NULL for the lattice spacing
+ * @param rest_y_a First dots' rest y positions
+ * @param rest_x_b Second dots' rest x positions
+ * @param rest_y_b Second dots' rest y positions
+ * @param force_x Output force on each first dot, in 1/4096 px/step
+ * @param force_y Output force y component
+ * @param count Number of springs
+ */
+static void fixed_spring_row(const Sint32 *x_a, const Sint32 *y_a, const Sint32 *x_b, const Sint32 *y_b,
+                             const Sint32 *rest_x_a, const Sint32 *rest_y_a, const Sint32 *rest_x_b,
+                             const Sint32 *rest_y_b, Sint32 *force_x, Sint32 *force_y, int count)
+{
+    const Sint32 lattice_rest = SPRING_REST_LENGTH << FIXED_SPRING_SHIFT;
+    int i = 0;
+#ifdef __SSE2__
+    for (; i + 4 <= count; i += 4)
+    {
+        __m128i rest = _mm_set1_epi32(lattice_rest);
+        if (rest_x_a)
+        {
+            __m128i sx;
+            __m128i sy;
+            rest = fixed_spring_length_sse2(
+                _mm_sub_epi32(_mm_loadu_si128((const __m128i *)&rest_x_b[i]),
+                              _mm_loadu_si128((const __m128i *)&rest_x_a[i])),
+                _mm_sub_epi32(_mm_loadu_si128((const __m128i *)&rest_y_b[i]),
+                              _mm_loadu_si128((const __m128i *)&rest_y_a[i])),
+                &sx, &sy);
+        }
+
+        __m128i fx;
+        __m128i fy;
+        fixed_spring_force_sse2(
+            _mm_sub_epi32(_mm_loadu_si128((const __m128i *)&x_b[i]), _mm_loadu_si128((const __m128i *)&x_a[i])),
+            _mm_sub_epi32(_mm_loadu_si128((const __m128i *)&y_b[i]), _mm_loadu_si128((const __m128i *)&y_a[i])),
+            rest, &fx, &fy);
+        _mm_storeu_si128((__m128i *)&force_x[i], fx);
+        _mm_storeu_si128((__m128i *)&force_y[i], fy);
+    }
+#endif
+    for (; i < count; i++)
+    {
+        Sint32 rest = lattice_rest;
+        if (rest_x_a)
+        {
+            Sint32 sx;
+            Sint32 sy;
+            rest = fixed_spring_length(rest_x_b[i] - rest_x_a[i], rest_y_b[i] - rest_y_a[i], &sx, &sy);
+        }
+        fixed_spring_force(x_b[i] - x_a[i], y_b[i] - y_a[i], rest, &force_x[i], &force_y[i]);
+    }
+}
+
+/**
+ * The physics step of update_physics() in 32-bit fixed point. Positions and
+ * velocities are rounded to 1/4096 px on the way in and written back,
+ * so g_dots holds the fixed-point state between steps. Each spring's force
+ * is computed once and summed into both dots with integer adds, which do not
+ * depend on order, so the SIMD and scalar paths, native and WebAssembly
+ * builds all produce the same bits. Rows are integrated as they are loaded,
+ * which makes the whole step one pass over the grid.
+ */
+static void update_physics_fixed(void)
+{
+    fixed_step_begin();
+    fixed_step_rows(0, g_grid_rows);
+}
+
+/**
+ * Starts a fixed-point step: loads the first row, which has no springs above it.
+ */
+static void fixed_step_begin(void)
+{
+    const size_t row_bytes = (size_t)g_grid_cols * sizeof(Sint32);
+
+    g_fixed.stiffness = FIXED_FACTOR(g_physics_params.stiffness);
+    g_fixed.damping = FIXED_FACTOR(g_physics_params.damping);
+    g_fixed.restoring = FIXED_FACTOR(g_physics_params.restoring);
+
+    memset(g_fixed.down_x[1], 0, row_bytes);
+    memset(g_fixed.down_y[1], 0, row_bytes);
+    fixed_load_row(0, 0);
+}
+
+/**
+ * Integrates a band of rows of the fixed-point step started by
+ * fixed_step_begin(). Bands must follow each other in order, as the row
+ * buffers carry the previous row's springs.
+ *
+ * @param row_begin First row of the band
+ * @param row_end Row after the last row of the band
+ */
+static void fixed_step_rows(int row_begin, int row_end)
+{
+    const int rows = g_grid_rows;
+    const int cols = g_grid_cols;
+    const bool shaped = g_morph.shaped;
+    const size_t row_bytes = (size_t)cols * sizeof(Sint32);
+
+    for (int row = row_begin; row < row_end; row++)
+    {
+        const int slot = row & 1;
+        const int next = slot ^ 1;
+
+        /* Springs to the row below, whose slot then holds row + 1 */
+        if (row + 1 < rows)
+        {
+            fixed_load_row(row + 1, next);
+            fixed_spring_row(g_fixed.x[slot], g_fixed.y[slot], g_fixed.x[next], g_fixed.y[next],
+                             shaped ? g_fixed.rest_x[slot] : NULL, g_fixed.rest_y[slot],
+                             g_fixed.rest_x[next], g_fixed.rest_y[next], g_fixed.down_x[slot], g_fixed.down_y[slot],
+                             cols);
+        }
+        else
+        {
+            memset(g_fixed.down_x[slot], 0, row_bytes);
+            memset(g_fixed.down_y[slot], 0, row_bytes);
+        }
+
+        /* Springs to the right neighbour, stored from index 1 so both row ends read zero */
+        fixed_spring_row(g_fixed.x[slot], g_fixed.y[slot], g_fixed.x[slot] + 1, g_fixed.y[slot] + 1,
+                         shaped ? g_fixed.rest_x[slot] : NULL, g_fixed.rest_y[slot],
+                         g_fixed.rest_x[slot] + 1, g_fixed.rest_y[slot] + 1, g_fixed.across_x + 1,
+                         g_fixed.across_y + 1, cols - 1);
+        g_fixed.across_x[0] = g_fixed.across_y[0] = 0;
+        g_fixed.across_x[cols] = g_fixed.across_y[cols] = 0;
+
+        fixed_store_row(row, slot);
+    }
+}
+
+/**
+ * Starts a step that is spread over frames, if the last step took longer than
+ * the budget: copies the dots for display while the live dots are stepped.
+ *
+ * @return true if the step was started, false to run it whole
+ */
+static bool physics_slice_begin(void)
+{
+    if (g_slice.budget_ms <= 0.0f || g_slice.step_ms <= g_slice.budget_ms)
+    {
+        return false;
+    }
+
+    const size_t dot_count = (size_t)g_grid_rows * (size_t)g_grid_cols;
+    if (g_slice.capacity < dot_count)
+    {
+        arena_free(g_slice.snapshot);
+        g_slice.snapshot = arena_alloc(dot_count * sizeof(Dot));
+        g_slice.capacity = 0;
+        if (!g_slice.snapshot)
+        {
+            return false;
+        }
+        g_slice.capacity = dot_count;
+    }
+
+    memcpy(g_slice.snapshot, g_dots, dot_count * sizeof(Dot));
+    g_slice.live = g_dots;
+    g_dots = g_slice.snapshot;
+    g_slice.fixed = g_physics_mode == PHYSICS_FIXED && fixed_reserve(g_grid_cols);
+    g_slice.pass = 0;
+    g_slice.row = 0;
+    g_slice.elapsed_ms = 0.0;
+    g_slice.active = true;
+    return true;
+}
+
+/**
+ * Continues the step in progress in bands of rows until it completes or the
+ * frame's budget runs out. The result is the same as running it whole.
+ *
+ * @param start Performance counter value when the frame's physics began
+ * @return true if the step completed
+ */
+static bool physics_slice_advance(Uint64 start)
+{
+    const Uint64 frequency = SDL_GetPerformanceFrequency();
+    const Uint64 deadline = start + (Uint64)((double)g_slice.budget_ms * (double)frequency / 1000.0);
+    const int passes = g_slice.fixed ? 1 : 2;
+    const int band = SDL_max(1, STEP_SLICE_DOTS / g_grid_cols);
+
+    g_dots = g_slice.live;
+    const Sheet sheet = live_sheet();
+    do
+    {
+        const int row_end = SDL_min(g_slice.row + band, g_grid_rows);
+        if (g_slice.fixed)
+        {
+            if (g_slice.row == 0)
+            {
+                fixed_step_begin();
+            }
+            fixed_step_rows(g_slice.row, row_end);
+        }
+        else if (g_slice.pass == 0)
+        {
+            physics_integrate_rows(&sheet, g_slice.row, row_end);
+        }
+        else
+        {
+            physics_spring_rows(&sheet, g_slice.row, row_end);
+        }
+
+        g_slice.row = row_end;
+        if (g_slice.row == g_grid_rows)
+        {
+            g_slice.row = 0;
+            g_slice.pass++;
+        }
+    } while (g_slice.pass < passes && SDL_GetPerformanceCounter() < deadline);
+
+    g_slice.elapsed_ms += (double)(SDL_GetPerformanceCounter() - start) * 1000.0 / (double)frequency;
+    if (g_slice.pass < passes)
+    {
+        g_dots = g_slice.snapshot;
+        return false;
+    }
+
+    g_slice.active = false;
+    g_slice.step_ms = g_slice.elapsed_ms;
+    return true;
+}
+
+/**
+ * Runs this frame's share of the physics: starts a step, including the morph
+ * blend, unless one is in progress, and runs it whole or within the budget.
+ *
+ * @return true if a step completed this frame
+ */
+static bool physics_step_frame(void)
+{
+    const Uint64 start = SDL_GetPerformanceCounter();
+
+    if (!g_slice.active)
+    {
+        forces_apply();
+        morph_step();
+        if (!physics_slice_begin())
+        {
+            update_physics();
+            g_slice.step_ms = (double)(SDL_GetPerformanceCounter() - start) * 1000.0 /
+                              (double)SDL_GetPerformanceFrequency();
+            return true;
+        }
+    }
+    return physics_slice_advance(start);
+}
+
+/**
+ * Abandons any step in progress, restoring the last completed one, and frees
+ * the snapshot.
+ */
+static void physics_slice_shutdown(void)
+{
+    if (g_slice.active)
+    {
+        memcpy(g_slice.live, g_slice.snapshot, (size_t)g_grid_rows * (size_t)g_grid_cols * sizeof(Dot));
+        g_dots = g_slice.live;
+        g_slice.active = false;
+    }
+    arena_free(g_slice.snapshot);
+    g_slice.snapshot = NULL;
+    g_slice.capacity = 0;
+}
+
+/**
+ * Draws a filled circle using the midpoint circle algorithm.
+ *
+ * @param renderer SDL renderer to draw with
+ * @param center_x X coordinate of circle center
+ * @param center_y Y coordinate of circle center
+ * @param radius Radius of the circle in pixels
+ */
+static void draw_filled_circle(SDL_Renderer *renderer, int center_x, int center_y, int radius)
+{
+    for (int w = 0; w < radius * 2; w++)
+    {
+        for (int h = 0; h < radius * 2; h++)
+        {
+            const int dx = radius - w;
+            const int dy = radius - h;
+            if ((dx * dx + dy * dy) <= (radius * radius))
+            {
+                SDL_RenderDrawPoint(renderer, center_x + dx, center_y + dy);
+            }
+        }
+    }
+}
+
+/**
+ * Builds the palette used by the speed and strain colour modes: from the dot
+ * colour at rest through orange to pale yellow at full scale.
+ */
+static void build_palette(void)
+{
+    static const SDL_Color stops[] = {
+        {DOT_COLOR_R, DOT_COLOR_G, DOT_COLOR_B, DOT_COLOR_A},
+        {255, 140, 40, DOT_COLOR_A},
+        {255, 250, 190, DOT_COLOR_A}};
+    const int segments = (int)SDL_arraysize(stops) - 1;
+
+    for (int i = 0; i < COLOR_PALETTE_SIZE; i++)
+    {
+        const float position = (float)i * segments / (COLOR_PALETTE_SIZE - 1);
+        const int segment = position < segments ? (int)position : segments - 1;
+        const float t = position - segment;
+        const SDL_Color *from = &stops[segment];
+        const SDL_Color *to = &stops[segment + 1];
+
+        g_palette[i] = (SDL_Color){
+            (Uint8)(from->r + (to->r - from->r) * t + 0.5f),
+            (Uint8)(from->g + (to->g - from->g) * t + 0.5f),
+            (Uint8)(from->b + (to->b - from->b) * t + 0.5f),
+            DOT_COLOR_A};
+    }
+}
+
+/**
+ * Maps dot speeds to palette indices.
+ *
+ * @param dots Consecutive dots
+ * @param shades Output palette index per dot
+ * @param count Number of dots
+ */
+static void render_shade_speed(const Dot *dots, Uint8 *shades, int count)
+{
+    const float scale = (COLOR_PALETTE_SIZE - 1) / COLOR_SPEED_FULL;
+    int i = 0;
+#ifdef __SSE2__
+    const __m128 factor = _mm_set1_ps(scale);
+    const __m128 top = _mm_set1_ps(COLOR_PALETTE_SIZE - 1);
+    const __m128i zero = _mm_setzero_si128();
+
+    for (; i + 4 <= count; i += 4)
+    {
+        /* Load (vx, vy, original_x, original_y) of four dots and transpose so
+           the first two registers hold four vx and four vy */
+        __m128 vx = _mm_loadu_ps(&dots[i].vx);
+        __m128 vy = _mm_loadu_ps(&dots[i + 1].vx);
+        __m128 unused_x = _mm_loadu_ps(&dots[i + 2].vx);
+        __m128 unused_y = _mm_loadu_ps(&dots[i + 3].vx);
+        _MM_TRANSPOSE4_PS(vx, vy, unused_x, unused_y);
+
+        const __m128 speed = _mm_sqrt_ps(_mm_add_ps(_mm_mul_ps(vx, vx), _mm_mul_ps(vy, vy)));
+        const __m128i index = _mm_cvttps_epi32(_mm_min_ps(_mm_mul_ps(speed, factor), top));
+        const int packed = _mm_cvtsi128_si32(_mm_packus_epi16(_mm_packs_epi32(index, zero), zero));
+        memcpy(shades + i, &packed, sizeof(packed));
+    }
+#endif
+
+    for (; i < count; i++)
+    {
+        const float speed = sqrtf(dots[i].vx * dots[i].vx + dots[i].vy * dots[i].vy);
+        shades[i] = (Uint8)fminf(speed * scale, COLOR_PALETTE_SIZE - 1);
+    }
+}
+
+/**
+ * Maps each dot's largest relative spring stretch or compression to a
+ * palette index, for a span of one grid row.
+ *
+ * @param row Grid row
+ * @param col_begin First column of the span
+ * @param col_end Column after the span
+ * @param shades Output palette index per dot of the span
+ */
+static void render_shade_strain(int row, int col_begin, int col_end, Uint8 *shades)
+{
+    const float scale = (COLOR_PALETTE_SIZE - 1) / COLOR_STRAIN_FULL;
+
+    for (int col = col_begin; col < col_end; col++)
+    {
+        const Dot *dot = dot_at(row, col);
+        const Dot *neighbours[4] = {
+            row > 0 ? dot_at(row - 1, col) : NULL,
+            row < g_grid_rows - 1 ? dot_at(row + 1, col) : NULL,
+            col > 0 ? dot_at(row, col - 1) : NULL,
+            col < g_grid_cols - 1 ? dot_at(row, col + 1) : NULL};
+        float strain = 0.0f;
+
+        for (int i = 0; i < 4; i++)
+        {
+            if (neighbours[i])
+            {
+                const float dx = neighbours[i]->x - dot->x;
+                const float dy = neighbours[i]->y - dot->y;
+                const float rest_length = spring_rest_length(dot, neighbours[i]);
+                if (rest_length > 0.001f)
+                {
+                    strain = fmaxf(strain, fabsf(sqrtf(dx * dx + dy * dy) / rest_length - 1.0f));
+                }
+            }
+        }
+
+        shades[col - col_begin] = (Uint8)fminf(strain * scale, COLOR_PALETTE_SIZE - 1);
+    }
+}
+
+/**
+ * Coverage of a pixel by a dot whose centre is the given distance away: one
+ * inside, zero outside, and a one pixel wide ramp across the edge.
+ *
+ * @param distance Distance from the dot centre in pixels
+ * @return Coverage from 0 to 255
+ */
+static Uint8 dot_coverage(float distance)
+{
+    const float coverage = DOT_RADIUS + 0.5f - distance;
+    return (Uint8)(255.0f * (coverage < 0.0f ? 0.0f : coverage > 1.0f ? 1.0f : coverage) + 0.5f);
+}
+
+/**
+ * Creates the textures and buffers a window's backend needs on first use,
+ * or again when drawing with a different renderer. Falls back to the CPU
+ * rasterizer if the sprite cannot be created.
+ *
+ * @param renderer SDL renderer to draw with
+ * @param state Buffers and textures of the window
+ * @param view View of the window
+ * @return true if the backend is ready
+ */
+static bool render_prepare(SDL_Renderer *renderer, RenderState *state, const View *view)
+{
+    if (state->shade_capacity < g_grid_cols)
+    {
+        arena_free(state->shades);
+        state->shades = arena_alloc((size_t)g_grid_cols);
+        state->shade_capacity = state->shades ? g_grid_cols : 0;
+        if (!state->shades)
+        {
+            return false;
+        }
+    }
+
+    if (state->texture_owner != renderer)
+    {
+#ifdef HAS_RENDER_GEOMETRY
+        SDL_DestroyTexture(state->sprite);
+        state->sprite = NULL;
+#endif
+        SDL_DestroyTexture(state->raster_texture);
+        state->raster_texture = NULL;
+        state->texture_owner = renderer;
+    }
+
+#ifdef HAS_RENDER_GEOMETRY
+    if ((state->backend == RENDER_GEOMETRY || state->backend == RENDER_SPRITE) && !state->vertices)
+    {
+        state->vertices = arena_alloc(RENDER_BATCH_DOTS * 4 * sizeof(SDL_Vertex));
+        state->indices = arena_alloc(RENDER_BATCH_DOTS * 6 * sizeof(int));
+        if (!state->vertices || !state->indices)
+        {
+            return false;
+        }
+        state->vertex_capacity = RENDER_BATCH_DOTS;
+
+        static const int quad[6] = {0, 1, 2, 2, 1, 3};
+        for (int i = 0; i < RENDER_BATCH_DOTS * 6; i++)
+        {
+            state->indices[i] = i / 6 * 4 + quad[i % 6];
+        }
+    }
+
+    if (state->backend == RENDER_SPRITE && !state->sprite)
+    {
+        /* The quad spans DOT_RADIUS + 1 pixels each way so the edge ramp fits */
+        static Uint32 texels[SPRITE_TEXTURE_SIZE * SPRITE_TEXTURE_SIZE];
+        const float pixels_per_texel = 2.0f * (DOT_RADIUS + 1) / SPRITE_TEXTURE_SIZE;
+        for (int y = 0; y < SPRITE_TEXTURE_SIZE; y++)
+        {
+            for (int x = 0; x < SPRITE_TEXTURE_SIZE; x++)
+            {
+                const float dx = (x + 0.5f - SPRITE_TEXTURE_SIZE / 2.0f) * pixels_per_texel;
+                const float dy = (y + 0.5f - SPRITE_TEXTURE_SIZE / 2.0f) * pixels_per_texel;
+                texels[y * SPRITE_TEXTURE_SIZE + x] = (Uint32)dot_coverage(sqrtf(dx * dx + dy * dy)) << 24 | 0xFFFFFFu;
+            }
+        }
+
+        state->sprite = SDL_CreateTexture(renderer, SDL_PIXELFORMAT_ARGB8888, SDL_TEXTUREACCESS_STATIC,
+                                          SPRITE_TEXTURE_SIZE, SPRITE_TEXTURE_SIZE);
+        if (!state->sprite || SDL_UpdateTexture(state->sprite, NULL, texels, SPRITE_TEXTURE_SIZE * 4) < 0)
+        {
+            fprintf(stderr, "Dot sprite creation failed, using the CPU rasterizer: %s\n", SDL_GetError());
+            SDL_DestroyTexture(state->sprite);
+            state->sprite = NULL;
+            state->backend = RENDER_RASTER;
+        }
+        else
+        {
+            SDL_SetTextureBlendMode(state->sprite, SDL_BLENDMODE_BLEND);
+            SDL_SetTextureScaleMode(state->sprite, SDL_ScaleModeLinear);
+        }
+    }
+#endif
+
+    if (state->backend == RENDER_RASTER)
+    {
+        if (!state->kernels_ready)
+        {
+            /* One coverage kernel per subpixel offset; the dot centre sits at
+               the left edge of kernel pixel DOT_RADIUS + 1 plus the offset */
+            for (int sub_y = 0; sub_y < RASTER_SUBPIXELS; sub_y++)
+            {
+                for (int sub_x = 0; sub_x < RASTER_SUBPIXELS; sub_x++)
+                {
+                    Uint8 *kernel = state->kernels[sub_y * RASTER_SUBPIXELS + sub_x];
+                    const float center_x = DOT_RADIUS + 1 + (float)sub_x / RASTER_SUBPIXELS;
+                    const float center_y = DOT_RADIUS + 1 + (float)sub_y / RASTER_SUBPIXELS;
+                    for (int y = 0; y < RASTER_KERNEL_SIZE; y++)
+                    {
+                        for (int x = 0; x < RASTER_KERNEL_SIZE; x++)
+                        {
+                            const float dx = x + 0.5f - center_x;
+                            const float dy = y + 0.5f - center_y;
+                            kernel[y * RASTER_KERNEL_SIZE + x] = dot_coverage(sqrtf(dx * dx + dy * dy));
+                        }
+                    }
+                }
+            }
+            state->kernels_ready = true;
+        }
+
+        /* The raster covers the window in points and follows it when resized */
+        if (state->raster_width != view->width || state->raster_height != view->height)
+        {
+            arena_free(state->raster_pixels);
+            SDL_DestroyTexture(state->raster_texture);
+            state->raster_texture = NULL;
+            state->raster_width = view->width;
+            state->raster_height = view->height;
+            state->raster_pixels = arena_alloc((size_t)state->raster_width * state->raster_height * sizeof(Uint32));
+            if (!state->raster_pixels)
+            {
+                state->raster_width = 0;
+                state->raster_height = 0;
+                return false;
+            }
+        }
+
+        if (!state->raster_texture)
+        {
+            state->raster_texture = SDL_CreateTexture(renderer, SDL_PIXELFORMAT_ARGB8888,
+                                                      SDL_TEXTUREACCESS_STREAMING, state->raster_width,
+                                                      state->raster_height);
+            if (!state->raster_texture)
+            {
+                fprintf(stderr, "Raster texture creation failed: %s\n", SDL_GetError());
+                return false;
+            }
+        }
+    }
+
+    return true;
+}
+
+/**
+ * Blends one antialiased dot into a window's CPU raster, using the
+ * precomputed kernel for the dot's subpixel offset.
+ *
+ * @param state Buffers of the window
+ * @param x Dot centre in window points
+ * @param y Dot centre in window points
+ * @param color Dot colour
+ */
+static void render_raster_dot(RenderState *state, float x, float y, SDL_Color color)
+{
+    /* Round the centre to the nearest subpixel step */
+    const int steps_x = (int)floorf(x * RASTER_SUBPIXELS + 0.5f);
+    const int steps_y = (int)floorf(y * RASTER_SUBPIXELS + 0.5f);
+    const int sub_x = (steps_x % RASTER_SUBPIXELS + RASTER_SUBPIXELS) % RASTER_SUBPIXELS;
+    const int sub_y = (steps_y % RASTER_SUBPIXELS + RASTER_SUBPIXELS) % RASTER_SUBPIXELS;
+    const Uint8 *kernel = state->kernels[sub_y * RASTER_SUBPIXELS + sub_x];
+    const int left = (steps_x - sub_x) / RASTER_SUBPIXELS - DOT_RADIUS - 1;
+    const int top = (steps_y - sub_y) / RASTER_SUBPIXELS - DOT_RADIUS - 1;
+
+    for (int y = 0; y < RASTER_KERNEL_SIZE; y++)
+    {
+        if (top + y < 0 || top + y >= state->raster_height)
+        {
+            continue;
+        }
+
+        Uint32 *line = state->raster_pixels + (size_t)(top + y) * state->raster_width;
+        for (int x = 0; x < RASTER_KERNEL_SIZE; x++)
+        {
+            const Uint32 alpha = kernel[y * RASTER_KERNEL_SIZE + x];
+            if (alpha == 0 || left + x < 0 || left + x >= state->raster_width)
+            {
+                continue;
+            }
+
+            const Uint32 under = line[left + x];
+            const Uint32 r = (color.r * alpha + ((under >> 16) & 0xFF) * (255 - alpha)) / 255;
+            const Uint32 g = (color.g * alpha + ((under >> 8) & 0xFF) * (255 - alpha)) / 255;
+            const Uint32 b = (color.b * alpha + (under & 0xFF) * (255 - alpha)) / 255;
+            line[left + x] = 0xFF000000u | r << 16 | g << 8 | b;
+        }
+    }
+}
+
+#ifdef HAS_RENDER_GEOMETRY
+/**
+ * Submits batched dots in geometry calls of at most RENDER_BATCH_DOTS dots,
+ * the length of the shared index pattern.
+ *
+ * @param renderer SDL renderer to draw with
+ * @param state Buffers and textures of the window
+ * @param count Dots in the batch
+ */
+static void render_flush_batch(SDL_Renderer *renderer, const RenderState *state, int count)
+{
+    SDL_Texture *texture = state->backend == RENDER_SPRITE ? state->sprite : NULL;
+    for (int first = 0; first < count; first += RENDER_BATCH_DOTS)
+    {
+        const int dots = SDL_min(count - first, RENDER_BATCH_DOTS);
+        SDL_RenderGeometry(renderer, texture, state->vertices + first * 4, dots * 4, state->indices, dots * 6);
+    }
+}
+#endif
+
+/**
+ * Recomputes the bounding box of every tile of dots. Called once per frame
+ * while the sheet spans several windows, so each window can skip whole
+ * tiles outside it.
+ *
+ * @return true if the tile bounds are ready
+ */
+static bool tiles_update(void)
+{
+    const int rows = (g_grid_rows + RENDER_TILE_DOTS - 1) / RENDER_TILE_DOTS;
+    const int cols = (g_grid_cols + RENDER_TILE_DOTS - 1) / RENDER_TILE_DOTS;
+    if (g_tiles.rows != rows || g_tiles.cols != cols)
+    {
+        arena_free(g_tiles.bounds);
+        g_tiles.bounds = arena_alloc((size_t)rows * cols * sizeof(TileBounds));
+        g_tiles.rows = g_tiles.bounds ? rows : 0;
+        g_tiles.cols = g_tiles.bounds ? cols : 0;
+        if (!g_tiles.bounds)
+        {
+            return false;
+        }
+    }
+
+    for (int i = 0; i < rows * cols; i++)
+    {
+        g_tiles.bounds[i] = (TileBounds){INFINITY, INFINITY, -INFINITY, -INFINITY};
+    }
+
+    /* One pass over the grid in memory order */
+    for (int row = 0; row < g_grid_rows; row++)
+    {
+        const Dot *line = dot_at(row, 0);
+        TileBounds *tiles = &g_tiles.bounds[row / RENDER_TILE_DOTS * cols];
+        for (int col = 0; col < g_grid_cols; col++)
+        {
+            TileBounds *tile = &tiles[col / RENDER_TILE_DOTS];
+            tile->min_x = fminf(tile->min_x, line[col].x);
+            tile->min_y = fminf(tile->min_y, line[col].y);
+            tile->max_x = fmaxf(tile->max_x, line[col].x);
+            tile->max_y = fmaxf(tile->max_y, line[col].y);
+        }
+    }
+    return true;
+}
+
+/**
+ * Builds the dots visible in a window into its vertex batch or raster, or
+ * draws them directly with the points backend. With a renderer, full
+ * batches are submitted as they fill; without one (on a wall render thread)
+ * the whole batch is kept for render_submit(), and the points backend does
+ * nothing. When the tile bounds are valid, tiles outside the window are
+ * skipped without looking at their dots.
+ *
+ * @param state Buffers and textures of the window
+ * @param view View of the window
+ * @param renderer SDL renderer to draw with, or NULL to only build
+ */
+static void render_build(RenderState *state, const View *view, SDL_Renderer *renderer)
+{
+    const SDL_Color solid = {DOT_COLOR_R, DOT_COLOR_G, DOT_COLOR_B, DOT_COLOR_A};
+    const bool shaded = g_color_mode != COLOR_SOLID;
+    const RenderBackend backend = state->backend;
+    const float offset_x = (float)view->offset_x;
+    const float offset_y = (float)view->offset_y;
+    const float margin = DOT_RADIUS + 1.0f;
+#ifdef HAS_RENDER_GEOMETRY
+    const float extent = backend == RENDER_SPRITE ? DOT_RADIUS + 1.0f : DOT_RADIUS;
+#endif
+
+    state->batched = 0;
+    if (backend == RENDER_POINTS)
+    {
+        if (!renderer)
+        {
+            return;
+        }
+        SDL_SetRenderDrawColor(renderer, solid.r, solid.g, solid.b, solid.a);
+    }
+    else if (backend == RENDER_RASTER)
+    {
+        const Uint32 background = 0xFF000000u | BACKGROUND_COLOR_R << 16 | BACKGROUND_COLOR_G << 8 | BACKGROUND_COLOR_B;
+        const size_t pixel_count = (size_t)state->raster_width * state->raster_height;
+        for (size_t i = 0; i < pixel_count; i++)
+        {
+            state->raster_pixels[i] = background;
+        }
+    }
+
+    /* Without tile bounds the whole grid is one tile */
+    const bool tiled = g_tiles.valid;
+    const int tile_height = tiled ? RENDER_TILE_DOTS : g_grid_rows;
+    const int tile_width = tiled ? RENDER_TILE_DOTS : g_grid_cols;
+
+    for (int row_begin = 0; row_begin < g_grid_rows; row_begin += tile_height)
+    {
+        for (int col_begin = 0; col_begin < g_grid_cols; col_begin += tile_width)
+        {
+            if (tiled)
+            {
+                const TileBounds *tile =
+                    &g_tiles.bounds[row_begin / RENDER_TILE_DOTS * g_tiles.cols + col_begin / RENDER_TILE_DOTS];
+                if (tile->max_x + offset_x < -margin || tile->min_x + offset_x > view->width + margin ||
+                    tile->max_y + offset_y < -margin || tile->min_y + offset_y > view->height + margin)
+                {
+                    continue;
+                }
+            }
+
+            const int row_end = SDL_min(row_begin + tile_height, g_grid_rows);
+            const int col_end = SDL_min(col_begin + tile_width, g_grid_cols);
+            for (int row = row_begin; row < row_end; row++)
+            {
+                const Dot *line = dot_at(row, 0);
+                if (g_color_mode == COLOR_SPEED)
+                {
+                    render_shade_speed(line + col_begin, state->shades, col_end - col_begin);
+                }
+                else if (g_color_mode == COLOR_STRAIN)
+                {
+                    render_shade_strain(row, col_begin, col_end, state->shades);
+                }
+
+                for (int col = col_begin; col < col_end; col++)
+                {
+                    const Dot *dot = &line[col];
+                    const float x = dot->x + offset_x;
+                    const float y = dot->y + offset_y;
+
+                    /* Skip dots entirely outside the window */
+                    if (x < -margin || x > view->width + margin || y < -margin || y > view->height + margin)
+                    {
+                        continue;
+                    }
+
+                    SDL_Color color = solid;
+                    if (shaded)
+                    {
+                        color = g_palette[state->shades[col - col_begin]];
+                    }
+                    else if (g_dot_colors)
+                    {
+                        color = g_dot_colors[row * g_grid_cols + col];
+                        if (color.r == BACKGROUND_COLOR_R && color.g == BACKGROUND_COLOR_G &&
+                            color.b == BACKGROUND_COLOR_B)
+                        {
+                            continue; /* Unlit dot */
+                        }
+                    }
+
+                    switch (backend)
+                    {
+#ifdef HAS_RENDER_GEOMETRY
+                    case RENDER_GEOMETRY:
+                    case RENDER_SPRITE:
+                    {
+                        if (state->batched == state->vertex_capacity)
+                        {
+                            if (renderer)
+                            {
+                                render_flush_batch(renderer, state, state->batched);
+                                state->batched = 0;
+                            }
+                            else
+                            {
+                                /* Wall threads must not touch the arena: grow on the heap. The
+                                   first arena block stays carved until arena_release() */
+                                const size_t bytes = (size_t)state->vertex_capacity * 4 * sizeof(SDL_Vertex);
+                                const bool carved = arena_contains(state->vertices);
+                                SDL_Vertex *vertices = carved ? malloc(bytes * 2) : realloc(state->vertices, bytes * 2);
+                                if (!vertices)
+                                {
+                                    return; /* Draw what fits */
+                                }
+                                if (carved)
+                                {
+                                    memcpy(vertices, state->vertices, bytes);
+                                }
+                                state->vertices = vertices;
+                                state->vertex_capacity *= 2;
+                            }
+                        }
+
+                        const float left = x - extent;
+                        const float top = y - extent;
+                        const float right = x + extent;
+                        const float bottom = y + extent;
+                        SDL_Vertex *corner = &state->vertices[state->batched++ * 4];
+                        corner[0] = (SDL_Vertex){{left, top}, color, {0.0f, 0.0f}};
+                        corner[1] = (SDL_Vertex){{right, top}, color, {1.0f, 0.0f}};
+                        corner[2] = (SDL_Vertex){{left, bottom}, color, {0.0f, 1.0f}};
+                        corner[3] = (SDL_Vertex){{right, bottom}, color, {1.0f, 1.0f}};
+                        break;
+                    }
+#endif
+                    case RENDER_RASTER:
+                        render_raster_dot(state, x, y, color);
+                        break;
+
+                    default:
+                        if (shaded || g_dot_colors)
+                        {
+                            SDL_SetRenderDrawColor(renderer, color.r, color.g, color.b, color.a);
+                        }
+                        draw_filled_circle(renderer, (int)dot->x + view->offset_x, (int)dot->y + view->offset_y,
+                                           DOT_RADIUS);
+                        break;
+                    }
+                }
+            }
+        }
+    }
+}
+
+/**
+ * Submits what render_build() left for the renderer: the batched dots, or
+ * the CPU raster as one texture copy.
+ *
+ * @param renderer SDL renderer to draw with
+ * @param state Buffers and textures of the window
+ * @param view View of the window
+ */
+static void render_submit(SDL_Renderer *renderer, RenderState *state, const View *view)
+{
+#ifdef HAS_RENDER_GEOMETRY
+    if (state->backend == RENDER_GEOMETRY || state->backend == RENDER_SPRITE)
+    {
+        render_flush_batch(renderer, state, state->batched);
+        state->batched = 0;
+    }
+#endif
+    if (state->backend == RENDER_RASTER)
+    {
+        const SDL_Rect window = {0, 0, view->width, view->height};
+        SDL_UpdateTexture(state->raster_texture, NULL, state->raster_pixels, state->raster_width * 4);
+        SDL_RenderCopy(renderer, state->raster_texture, NULL, &window);
+    }
+}
+
+/**
+ * Renders the dots visible in the main window with the selected backend.
+ * The batched backends send per-dot colours as vertex colours, so colour
+ * modes cost no extra draw calls. The sprite and raster backends draw
+ * antialiased dots at their subpixel positions.
+ *
+ * @param renderer SDL renderer to draw with
+ */
+static void render_grid(SDL_Renderer *renderer)
+{
+    if (render_prepare(renderer, &g_render, &g_view))
+    {
+        render_build(&g_render, &g_view, renderer);
+        render_submit(renderer, &g_render, &g_view);
+    }
+}
+
+/**
+ * Frees a window's dot rendering buffers and textures, keeping its backend.
+ *
+ * @param state Buffers and textures to free
+ */
+static void render_state_free(RenderState *state)
+{
+    const RenderBackend backend = state->backend;
+    arena_free(state->shades);
+#ifdef HAS_RENDER_GEOMETRY
+    arena_free(state->vertices);
+    arena_free(state->indices);
+    SDL_DestroyTexture(state->sprite);
+#endif
+    SDL_DestroyTexture(state->raster_texture);
+    arena_free(state->raster_pixels);
+    *state = (RenderState){.backend = backend};
+}
+
+/**
+ * Frees the main window's dot rendering buffers and textures.
+ */
+static void render_shutdown(void)
+{
+    render_state_free(&g_render);
+}
+
+/**
+ * Redirects rendering into the dynamic resolution texture, scaled so window
+ * coordinates land in its top-left scale-sized region. The texture is
+ * recreated when the output size or renderer changes.
+ *
+ * @param renderer SDL renderer to draw with
+ * @return true if rendering was redirected
+ */
+static bool dynres_begin(SDL_Renderer *renderer)
+{
+    if (!g_dynres.enabled)
+    {
+        return false;
+    }
+
+    int width, height;
+    if (SDL_GetRendererOutputSize(renderer, &width, &height) < 0)
+    {
+        return false;
+    }
+
+    if (!g_dynres.texture || g_dynres.owner != renderer || g_dynres.width != width || g_dynres.height != height)
+    {
+        SDL_DestroyTexture(g_dynres.texture);
+        g_dynres.texture = SDL_CreateTexture(renderer, SDL_PIXELFORMAT_ARGB8888, SDL_TEXTUREACCESS_TARGET, width, height);
+        if (!g_dynres.texture)
+        {
+            fprintf(stderr, "Dynamic resolution disabled, render target creation failed: %s\n", SDL_GetError());
+            g_dynres.enabled = false;
+            return false;
+        }
+        SDL_SetTextureScaleMode(g_dynres.texture, SDL_ScaleModeLinear);
+        g_dynres.owner = renderer;
+        g_dynres.width = width;
+        g_dynres.height = height;
+    }
+
+    SDL_SetRenderTarget(renderer, g_dynres.texture);
+    SDL_RenderSetScale(renderer, g_dynres.scale * width / g_view.width, g_dynres.scale * height / g_view.height);
+    return true;
+}
+
+/**
+ * Restores the default render target and upscales the rendered region of
+ * the dynamic resolution texture onto it.
+ *
+ * @param renderer SDL renderer to draw with
+ */
+static void dynres_end(SDL_Renderer *renderer)
+{
+    const SDL_Rect source = {
+        0,
+        0,
+        SDL_max(1, (int)(g_dynres.width * g_dynres.scale + 0.5f)),
+        SDL_max(1, (int)(g_dynres.height * g_dynres.scale + 0.5f))};
+
+    SDL_SetRenderTarget(renderer, NULL);
+    SDL_RenderSetScale(renderer, g_view.pixel_scale_x, g_view.pixel_scale_y);
+    SDL_RenderCopy(renderer, g_dynres.texture, &source, NULL);
+}
+
+/**
+ * Adjusts the render scale from the frame's render and present times, and
+ * prints the scale once per STATS_INTERVAL_MS when it has changed.
+ */
+static void dynres_update(void)
+{
+    if (!g_dynres.enabled)
+    {
+        return;
+    }
+
+    FrameRecord *record = &g_recorder.frames[g_recorder.frame % RECORDER_FRAMES];
+    record->render_scale = g_dynres.scale;
+
+    const float frame_ms = record->stage_ms[STAGE_RENDER] + record->stage_ms[STAGE_PRESENT];
+    g_dynres.render_ms += (frame_ms - g_dynres.render_ms) * DYNRES_SMOOTHING;
+
+    if (g_dynres.render_ms > g_dynres.target_ms)
+    {
+        g_dynres.scale = fmaxf(g_dynres.scale * DYNRES_STEP_DOWN, DYNRES_MIN_SCALE);
+    }
+    else if (g_dynres.render_ms < g_dynres.target_ms * DYNRES_HEADROOM)
+    {
+        g_dynres.scale = fminf(g_dynres.scale * DYNRES_STEP_UP, 1.0f);
+    }
+
+    const Uint32 now = SDL_GetTicks();
+    if (now - g_dynres.last_report >= STATS_INTERVAL_MS && fabsf(g_dynres.scale - g_dynres.reported_scale) >= 0.01f)
+    {
+        printf("Render scale %.2f (%dx%d), render + present %.2f ms, target %.2f ms\n", g_dynres.scale,
+               (int)(g_dynres.width * g_dynres.scale + 0.5f), (int)(g_dynres.height * g_dynres.scale + 0.5f),
+               g_dynres.render_ms, g_dynres.target_ms);
+        g_dynres.reported_scale = g_dynres.scale;
+        g_dynres.last_report = now;
+    }
+}
+
+/**
+ * Frees the dynamic resolution texture.
+ */
+static void dynres_shutdown(void)
+{
+    SDL_DestroyTexture(g_dynres.texture);
+    g_dynres.texture = NULL;
+    g_dynres.owner = NULL;
+}
+
+/**
+ * Finds the dot closest to the given mouse position within the click radius.
+ *
+ * @param sheet Sheet to search, the live one for the mouse
+ * @param mouse_x Mouse X coordinate
+ * @param mouse_y Mouse Y coordinate
+ * @param row Output parameter for the row of the found dot
+ * @param col Output parameter for the column of the found dot
+ * @return true if a dot was found, false otherwise
+ */
+static bool sheet_find_dot(const Sheet *sheet, int mouse_x, int mouse_y, int *row, int *col)
+{
+    for (int r = 0; r < sheet->rows; r++)
+    {
+        for (int c = 0; c < sheet->cols; c++)
+        {
+            const float dx = mouse_x - sheet_dot(sheet, r, c)->x;
+            const float dy = mouse_y - sheet_dot(sheet, r, c)->y;
+            const float distance = sqrtf(dx * dx + dy * dy);
+
+            if (distance < CLICK_DETECTION_RADIUS)
+            {
+                *row = r;
+                *col = c;
+                return true;
+            }
+        }
+    }
+    return false;
+}
+
+/**
+ * Re-reads the window and output sizes after a resize or a move between
+ * displays. The sheet stays centred on the wall by moving the view offset,
+ * so neither the grid nor the rest lattice is touched; render targets
+ * follow lazily on the next frame.
+ *
+ * @param window Window to measure, or NULL to use the output size
+ * @param renderer Renderer drawing into it
+ * @param view View of the window
+ */
+static void view_update(SDL_Window *window, SDL_Renderer *renderer, View *view)
+{
+    int pixel_width, pixel_height;
+    if (SDL_GetRendererOutputSize(renderer, &pixel_width, &pixel_height) < 0)
+    {
+        return;
+    }
+
+    int width = pixel_width;
+    int height = pixel_height;
+    if (window)
+    {
+        SDL_GetWindowSize(window, &width, &height);
+    }
+    if (width < 1 || height < 1 || pixel_width < 1 || pixel_height < 1)
+    {
+        return; /* Minimized */
+    }
+
+    /* Wall windows are taken to be the size of this one */
+    view->width = width;
+    view->height = height;
+    view->offset_x = (g_wall.cols * width - WINDOW_WIDTH) / 2 - view->wall_col * width;
+    view->offset_y = (g_wall.rows * height - WINDOW_HEIGHT) / 2 - view->wall_row * height;
+    view->pixel_scale_x = (float)pixel_width / width;
+    view->pixel_scale_y = (float)pixel_height / height;
+
+    /* Draw in window points; the renderer maps them to output pixels */
+    SDL_RenderSetScale(renderer, view->pixel_scale_x, view->pixel_scale_y);
+}
+
+/**
+ * Returns the view of the window an event belongs to.
+ *
+ * @param window_id SDL window ID from the event
+ * @return The wall window's view, or the main view for any other ID
+ */
+static View *view_for_window(Uint32 window_id)
+{
+    for (int i = 0; i < g_wall.count; i++)
+    {
+        if (SDL_GetWindowID(g_wall.windows[i].window) == window_id)
+        {
+            return &g_wall.windows[i].view;
+        }
+    }
+    return &g_view;
+}
+
+/**
+ * Opens the extra windows of a COLS x ROWS video wall, each with its own
+ * renderer and render thread. Windows go one per display when there are
+ * enough displays, and side by side from the main window otherwise. With a
+ * tile given, the main window shows just that part of the wall instead.
+ *
+ * @param cols Windows across
+ * @param rows Windows down
+ * @param tile_col Column of the single window to show, or -1 for all
+ * @param tile_row Row of the single window to show, or -1 for all
+ * @return true on success, false on error
+ */
+static bool wall_init(int cols, int rows, int tile_col, int tile_row)
+{
+    g_wall.cols = cols;
+    g_wall.rows = rows;
+    if (tile_col >= 0 && tile_row >= 0)
+    {
+        g_view.wall_col = tile_col;
+        g_view.wall_row = tile_row;
+        view_update(g_window, g_renderer, &g_view);
+        return true;
+    }
+    if (cols * rows == 1)
+    {
+        return true;
+    }
+
+    const bool per_display = SDL_GetNumVideoDisplays() >= cols * rows;
+    int origin_x, origin_y;
+    if (per_display)
+    {
+        SDL_SetWindowPosition(g_window, SDL_WINDOWPOS_CENTERED_DISPLAY(0), SDL_WINDOWPOS_CENTERED_DISPLAY(0));
+    }
+    SDL_GetWindowPosition(g_window, &origin_x, &origin_y);
+
+    for (int index = 1; index < cols * rows; index++)
+    {
+        WallWindow *wall_window = &g_wall.windows[g_wall.count];
+        const int col = index % cols;
+        const int row = index / cols;
+        char title[64];
+        snprintf(title, sizeof(title), "%s (%d, %d)", WINDOW_TITLE, col, row);
+
+        wall_window->window = SDL_CreateWindow(
+            title,
+            per_display ? (int)SDL_WINDOWPOS_CENTERED_DISPLAY(index) : origin_x + col * WINDOW_WIDTH,
+            per_display ? (int)SDL_WINDOWPOS_CENTERED_DISPLAY(index) : origin_y + row * WINDOW_HEIGHT,
+            WINDOW_WIDTH,
+            WINDOW_HEIGHT,
+            SDL_WINDOW_SHOWN | SDL_WINDOW_RESIZABLE | SDL_WINDOW_ALLOW_HIGHDPI);
+        if (wall_window->window)
+        {
+            wall_window->renderer = SDL_CreateRenderer(wall_window->window, -1, SDL_RENDERER_ACCELERATED);
+        }
+        if (!wall_window->renderer)
+        {
+            fprintf(stderr, "Wall window creation failed: %s\n", SDL_GetError());
+            SDL_DestroyWindow(wall_window->window);
+            wall_window->window = NULL;
+            return false;
+        }
+        g_wall.count++;
+
+        wall_window->view.wall_col = col;
+        wall_window->view.wall_row = row;
+        wall_window->render.backend = g_render.backend;
+
+        /* Without a thread the window is built on the main thread */
+        wall_window->start = SDL_CreateSemaphore(0);
+        wall_window->done = SDL_CreateSemaphore(0);
+        if (wall_window->start && wall_window->done)
+        {
+            wall_window->thread = SDL_CreateThread(wall_worker, "wall", wall_window);
+        }
+        if (!wall_window->thread)
+        {
+            printf("Wall window (%d, %d): building on the main thread (%s)\n", col, row, SDL_GetError());
+        }
+    }
+
+    view_update(g_window, g_renderer, &g_view);
+    for (int i = 0; i < g_wall.count; i++)
+    {
+        view_update(g_wall.windows[i].window, g_wall.windows[i].renderer, &g_wall.windows[i].view);
+    }
+    printf("Video wall: %dx%d windows%s\n", cols, rows, per_display ? ", one per display" : "");
+    return true;
+}
+
+/**
+ * Render thread of a wall window: builds the window's dots each time the
+ * main thread starts a frame.
+ *
+ * @param data The WallWindow to build
+ * @return 0
+ */
+static int wall_worker(void *data)
+{
+    WallWindow *wall_window = data;
+
+    for (;;)
+    {
+        SDL_SemWait(wall_window->start);
+        if (g_wall.quit)
+        {
+            return 0;
+        }
+
+        render_build(&wall_window->render, &wall_window->view, NULL);
+        SDL_SemPost(wall_window->done);
+    }
+}
+
+/**
+ * Starts building the wall windows from the current positions: updates the
+ * tile bounds, prepares each window's textures on the main thread and
+ * wakes its render thread. The points backend draws as it goes, so it
+ * stays on the main thread.
+ */
+static void wall_begin(void)
+{
+    if (g_wall.count == 0)
+    {
+        return;
+    }
+
+    g_tiles.valid = tiles_update();
+    for (int i = 0; i < g_wall.count; i++)
+    {
+        WallWindow *wall_window = &g_wall.windows[i];
+        wall_window->ready = render_prepare(wall_window->renderer, &wall_window->render, &wall_window->view);
+        wall_window->building = wall_window->ready && wall_window->thread &&
+                                wall_window->render.backend != RENDER_POINTS;
+        if (wall_window->building)
+        {
+            SDL_SemPost(wall_window->start);
+        }
+    }
+}
+
+/**
+ * Waits for each wall window's render thread, or builds the window here,
+ * and submits it to the window's renderer.
+ */
+static void wall_end(void)
+{
+    for (int i = 0; i < g_wall.count; i++)
+    {
+        WallWindow *wall_window = &g_wall.windows[i];
+        if (wall_window->building)
+        {
+            SDL_SemWait(wall_window->done);
+            wall_window->building = false;
+        }
+
+        SDL_SetRenderDrawColor(
+            wall_window->renderer,
+            BACKGROUND_COLOR_R,
+            BACKGROUND_COLOR_G,
+            BACKGROUND_COLOR_B,
+            BACKGROUND_COLOR_A);
+        SDL_RenderClear(wall_window->renderer);
+        if (!wall_window->ready)
+        {
+            continue;
+        }
+
+        if (!wall_window->thread || wall_window->render.backend == RENDER_POINTS)
+        {
+            render_build(&wall_window->render, &wall_window->view, wall_window->renderer);
+        }
+        render_submit(wall_window->renderer, &wall_window->render, &wall_window->view);
+    }
+}
+
+/**
+ * Presents the wall windows.
+ */
+static void wall_present(void)
+{
+    for (int i = 0; i < g_wall.count; i++)
+    {
+        SDL_RenderPresent(g_wall.windows[i].renderer);
+    }
+}
+
+/**
+ * Stops the render threads and closes the wall windows.
+ */
+static void wall_shutdown(void)
+{
+    g_wall.quit = true;
+    for (int i = 0; i < g_wall.count; i++)
+    {
+        WallWindow *wall_window = &g_wall.windows[i];
+        if (wall_window->thread)
+        {
+            SDL_SemPost(wall_window->start);
+            SDL_WaitThread(wall_window->thread, NULL);
+        }
+        if (wall_window->start)
+        {
+            SDL_DestroySemaphore(wall_window->start);
+        }
+        if (wall_window->done)
+        {
+            SDL_DestroySemaphore(wall_window->done);
+        }
+
+        /* Textures go before their renderer */
+        render_state_free(&wall_window->render);
+        SDL_DestroyRenderer(wall_window->renderer);
+        SDL_DestroyWindow(wall_window->window);
+    }
+
+    arena_free(g_tiles.bounds);
+    g_tiles = (Tiles){0};
+    g_wall = (VideoWall){.cols = 1, .rows = 1};
+}
+
+/**
+ * Handles mouse events for dragging dots.
+ * Users can click and drag dots to move them, creating wave effects in the grid.
+ * Events are translated into input commands in sheet coordinates, recorded,
+ * then applied.
+ *
+ * @param event SDL event to process
+ */
+static void handle_mouse_event(const SDL_Event *event)
+{
+    const View *view;
+
+#ifdef __EMSCRIPTEN__
+    if (g_pointer_ring.active)
+    {
+        return; /* The page delivers pointer input through the pointer ring instead */
+    }
+#endif
+
+    switch (event->type)
+    {
+    case SDL_MOUSEBUTTONDOWN:
+        view = view_for_window(event->button.windowID);
+        pointer_input(INPUT_GRAB, event->button.x - view->offset_x, event->button.y - view->offset_y, 0);
+        break;
+
+    case SDL_MOUSEBUTTONUP:
+        view = view_for_window(event->button.windowID);
+        pointer_input(INPUT_RELEASE, event->button.x - view->offset_x, event->button.y - view->offset_y, 0);
+        break;
+
+    case SDL_MOUSEMOTION:
+    {
+        const Uint64 input_counter = latency_event_time(event, 0, true);
+        view = view_for_window(event->motion.windowID);
+        pointer_input(INPUT_MOVE, event->motion.x - view->offset_x, event->motion.y - view->offset_y, input_counter);
+        break;
+    }
+
+    default:
+        break;
+    }
+}
+
+/**
+ * Handles pointer input from SDL or the browser's pointer ring. Grabs and
+ * releases apply at once, after any drag samples before them; drag motion is
+ * queued for the frame's substeps.
+ *
+ * @param type INPUT_GRAB, INPUT_MOVE or INPUT_RELEASE
+ * @param x Position in sheet coordinates
+ * @param y Position in sheet coordinates
+ * @param input_counter Performance counter value when the input was generated (moves only)
+ */
+static void pointer_input(InputType type, Sint32 x, Sint32 y, Uint64 input_counter)
+{
+    if (type == INPUT_MOVE)
+    {
+        if (!g_drag_state.is_dragging)
+        {
+            return; /* Hover motion has no effect on the grid */
+        }
+
+        /* When full, the newest sample replaces the last one */
+        if (g_drag_samples.count == DRAG_SAMPLES_PER_FRAME)
+        {
+            g_drag_samples.count--;
+        }
+        g_drag_samples.samples[g_drag_samples.count++] = (DragSample){x, y, input_counter};
+        return;
+    }
+
+    drag_samples_flush();
+    const InputCommand command = {type, x, y, 0};
+    recorder_log_input(&command);
+    lockstep_log_input(&command);
+    apply_input_command(&command);
+}
+
+/**
+ * Starts collecting the drag samples of a frame.
+ */
+static void drag_samples_begin_frame(void)
+{
+    const Uint64 now = SDL_GetPerformanceCounter();
+    g_drag_samples.window_start = g_drag_samples.window_end ? g_drag_samples.window_end : now;
+    g_drag_samples.window_end = now;
+}
+
+/**
+ * Moves the dragged dot to the newest sample generated in a substep's share
+ * of the interval since the previous frame. The last substep takes every
+ * sample left.
+ *
+ * @param substep Substep about to run
+ * @param substeps Substeps in the frame
+ */
+static void drag_samples_apply(int substep, int substeps)
+{
+    const Uint64 span = g_drag_samples.window_end - g_drag_samples.window_start;
+    const Uint64 cutoff = g_drag_samples.window_start + span * (Uint64)(substep + 1) / (Uint64)substeps;
+
+    int newest = -1;
+    for (int i = g_drag_samples.next; i < g_drag_samples.count; i++)
+    {
+        if (substep == substeps - 1 || g_drag_samples.samples[i].counter <= cutoff)
+        {
+            newest = i;
+        }
+    }
+    if (newest < 0)
+    {
+        return;
+    }
+
+    const DragSample *sample = &g_drag_samples.samples[newest];
+    const InputCommand command = {INPUT_MOVE, sample->x, sample->y, 0};
+    recorder_log_input(&command);
+    lockstep_log_input(&command);
+    apply_input_command(&command);
+    latency_note_input(sample->counter, sample->x, sample->y);
+    g_drag_samples.next = newest + 1;
+}
+
+/**
+ * Applies the newest drag sample not applied yet, if any, and empties the
+ * queue.
+ */
+static void drag_samples_flush(void)
+{
+    drag_samples_apply(0, 1);
+    g_drag_samples.count = 0;
+    g_drag_samples.next = 0;
+}
+
+/**
+ * Applies an input command to the grid and drag state.
+ *
+ * @param command Input command to apply
+ */
+static void apply_input_command(const InputCommand *command)
+{
+    switch (command->type)
+    {
+    case INPUT_LATCH:
+        if (g_drag_state.is_dragging)
+        {
+            Dot *dragged = dot_at(g_drag_state.row, g_drag_state.col);
+            const float delta_x = command->x - dragged->x;
+            const float delta_y = command->y - dragged->y;
+
+            /* Carry nearby dots part of the way, as the springs would next step */
+            for (int row = g_drag_state.row - LATCH_RADIUS; row <= g_drag_state.row + LATCH_RADIUS; row++)
+            {
+                for (int col = g_drag_state.col - LATCH_RADIUS; col <= g_drag_state.col + LATCH_RADIUS; col++)
+                {
+                    if (row < 0 || row >= g_grid_rows || col < 0 || col >= g_grid_cols)
+                    {
+                        continue;
+                    }
+
+                    Dot *dot = dot_at(row, col);
+                    const int distance = SDL_max(abs(row - g_drag_state.row), abs(col - g_drag_state.col));
+                    if (distance > 0 && !dot->fixed)
+                    {
+                        const float weight = powf(LATCH_FALLOFF, (float)distance);
+                        dot->x += delta_x * weight;
+                        dot->y += delta_y * weight;
+                    }
+                }
+            }
+
+            dragged->x = command->x;
+            dragged->y = command->y;
+        }
+        break;
+
+    case INPUT_MORPH:
+        if (command->x >= -1 && command->x < g_morph.shape_count)
+        {
+            morph_show(command->x);
+        }
+        break;
+
+    case INPUT_FAST_FORWARD:
+        power_fast_forward(command->x);
+        break;
+
+    default:
+    {
+        const Sheet sheet = live_sheet();
+        sheet_apply_input(&sheet, &g_drag_state, command);
+        break;
+    }
+    }
+}
+
+/**
+ * Applies a mouse or touch command to a sheet: grabs, moves and releases the
+ * dots the pointers hold. Releasing frees the dot, so touches only grab free
+ * dots and the mouse leaves dots held by touches alone. Other commands are
+ * ignored.
+ *
+ * @param sheet Sheet the pointers act on
+ * @param drag Dots the mouse and the touches hold on the sheet
+ * @param command Input command to apply
+ */
+static void sheet_apply_input(const Sheet *sheet, DragState *drag, const InputCommand *command)
+{
+    switch (command->type)
+    {
+    case INPUT_GRAB:
+    {
+        int row, col;
+        if (!sheet_find_dot(sheet, command->x, command->y, &row, &col))
+        {
+            break;
+        }
+        bool touched = false;
+        for (int touch = 0; touch < TOUCH_MAX_POINTS; touch++)
+        {
+            touched |= drag->touches[touch].held && drag->touches[touch].row == row && drag->touches[touch].col == col;
+        }
+        if (!touched)
+        {
+            drag->is_dragging = true;
+            drag->row = row;
+            drag->col = col;
+            sheet_dot(sheet, row, col)->fixed = true;
+        }
+        break;
+    }
+
+    case INPUT_RELEASE:
+        if (drag->is_dragging)
+        {
+            sheet_dot(sheet, drag->row, drag->col)->fixed = false;
+            drag->is_dragging = false;
+        }
+        break;
+
+    case INPUT_MOVE:
+        if (drag->is_dragging)
+        {
+            sheet_dot(sheet, drag->row, drag->col)->x = command->x;
+            sheet_dot(sheet, drag->row, drag->col)->y = command->y;
+        }
+        break;
+
+    case INPUT_TOUCH_DOWN:
+    {
+        int row, col;
+        if (command->touch >= 0 && command->touch < TOUCH_MAX_POINTS && !drag->touches[command->touch].held &&
+            sheet_find_dot(sheet, command->x, command->y, &row, &col) && !sheet_dot(sheet, row, col)->fixed)
+        {
+            drag->touches[command->touch] = (TouchPoint){true, row, col};
+            sheet_dot(sheet, row, col)->fixed = true;
+        }
+        break;
+    }
+
+    case INPUT_TOUCH_MOVE:
+        if (command->touch >= 0 && command->touch < TOUCH_MAX_POINTS && drag->touches[command->touch].held)
+        {
+            const TouchPoint *touch = &drag->touches[command->touch];
+            sheet_dot(sheet, touch->row, touch->col)->x = command->x;
+            sheet_dot(sheet, touch->row, touch->col)->y = command->y;
+        }
+        break;
+
+    case INPUT_TOUCH_UP:
+        if (command->touch >= 0 && command->touch < TOUCH_MAX_POINTS && drag->touches[command->touch].held)
+        {
+            TouchPoint *touch = &drag->touches[command->touch];
+            sheet_dot(sheet, touch->row, touch->col)->fixed = false;
+            touch->held = false;
+        }
+        break;
+
+    default:
+        break;
+    }
+}
+
+/**
+ * Checks that every dot a drag state holds lies on a grid, for drag states
+ * read from a file or the network.
+ *
+ * @param drag Drag state to check
+ * @param rows Grid rows
+ * @param cols Grid columns
+ * @return true if every held dot is on the grid
+ */
+static bool drag_state_valid(const DragState *drag, int rows, int cols)
+{
+    if (drag->is_dragging && (drag->row < 0 || drag->row >= rows || drag->col < 0 || drag->col >= cols))
+    {
+        return false;
+    }
+    for (int touch = 0; touch < TOUCH_MAX_POINTS; touch++)
+    {
+        const TouchPoint *point = &drag->touches[touch];
+        if (point->held && (point->row < 0 || point->row >= rows || point->col < 0 || point->col >= cols))
+        {
+            return false;
+        }
+    }
+    return true;
+}
+
+/**
+ * Allocates keyframe storage for the flight recorder.
+ * Must be called after the grid has been allocated.
+ *
+ * @param threshold_ms Frame time above which a frame counts as slow
+ * @return true on success, false if allocation failed
+ */
+static bool recorder_init(float threshold_ms)
+{
+    memset(&g_recorder, 0, sizeof(g_recorder));
+    g_recorder.threshold_ms = threshold_ms;
+
+    const size_t dot_count = (size_t)g_grid_rows * (size_t)g_grid_cols;
+    for (int i = 0; i < RECORDER_KEYFRAMES; i++)
+    {
+        g_recorder.keyframes[i].dots = arena_alloc(dot_count * sizeof(Dot));
+        if (!g_recorder.keyframes[i].dots)
+        {
+            fprintf(stderr, "Failed to allocate flight recorder keyframes\n");
+            return false;
+        }
+    }
+    return true;
+}
+
+/**
+ * Frees the keyframes.
+ */
+static void recorder_shutdown(void)
+{
+    for (int i = 0; i < RECORDER_KEYFRAMES; i++)
+    {
+        arena_free(g_recorder.keyframes[i].dots);
+        g_recorder.keyframes[i].dots = NULL;
+    }
+}
+
+/**
+ * Starts recording a new frame, capturing a state keyframe if one is due.
+ */
+static void recorder_begin_frame(void)
+{
+    FrameRecord *record = &g_recorder.frames[g_recorder.frame % RECORDER_FRAMES];
+    memset(record, 0, sizeof(*record));
+    record->frame = g_recorder.frame;
+    record->latency_ms = -1.0f;
+    record->render_scale = 1.0f;
+
+    if (g_recorder.frame % RECORDER_KEYFRAME_INTERVAL == 0)
+    {
+        StateKeyframe *keyframe =
+            &g_recorder.keyframes[(g_recorder.frame / RECORDER_KEYFRAME_INTERVAL) % RECORDER_KEYFRAMES];
+        keyframe->frame = g_recorder.frame;
+        keyframe->valid = true;
+        keyframe->drag = g_drag_state;
+        memcpy(keyframe->dots, g_dots, (size_t)g_grid_rows * (size_t)g_grid_cols * sizeof(Dot));
+    }
+
+    g_recorder.frame_start = SDL_GetPerformanceCounter();
+}
+
+/**
+ * Records the duration of a frame stage.
+ *
+ * @param stage Stage that just finished
+ * @param stage_start Performance counter value when the stage started
+ * @return Current performance counter value, to be used as the next stage's start
+ */
+static Uint64 recorder_end_stage(FrameStage stage, Uint64 stage_start)
+{
+    const Uint64 now = SDL_GetPerformanceCounter();
+    FrameRecord *record = &g_recorder.frames[g_recorder.frame % RECORDER_FRAMES];
+    record->stage_ms[stage] = (float)((double)(now - stage_start) * 1000.0 / (double)SDL_GetPerformanceFrequency());
+#ifdef __EMSCRIPTEN__
+    timeline_note_stage(stage, stage_start, now);
+#endif
+    return now;
+}
+
+/**
+ * Records an input command in the current frame.
+ * Consecutive moves are coalesced since only the last one affects the grid.
+ * Commands past the per-frame limit are counted, so a replay can flag the
+ * frame.
+ *
+ * @param command Input command to record
+ */
+static void recorder_log_input(const InputCommand *command)
+{
+    FrameRecord *record = &g_recorder.frames[g_recorder.frame % RECORDER_FRAMES];
+
+    /* Only the newest of consecutive moves of the same pointer matters */
+    const InputCommand *last = record->input_count > 0 ? &record->inputs[record->input_count - 1] : NULL;
+    if (last && (command->type == INPUT_MOVE || command->type == INPUT_TOUCH_MOVE) && last->type == command->type &&
+        last->touch == command->touch)
+    {
+        record->inputs[record->input_count - 1] = *command;
+        return;
+    }
+
+    /* Steps are always recorded; other commands stop short of the limit to leave them room */
+    const Uint32 limit = command->type == INPUT_STEP ? RECORDER_INPUTS_PER_FRAME
+                                                     : RECORDER_INPUTS_PER_FRAME - SUBSTEPS_MAX;
+    if (record->input_count < limit)
+    {
+        record->inputs[record->input_count++] = *command;
+    }
+    else
+    {
+        record->dropped_inputs++;
+    }
+}
+
+/**
+ * Records that a physics step completed after the inputs recorded so far.
+ */
+static void recorder_note_step(void)
+{
+    const InputCommand command = {.type = INPUT_STEP};
+    recorder_log_input(&command);
+}
+
+/**
+ * Finishes the current frame: checks it against the slow-frame threshold and
+ * writes a pending dump once enough frames after the slow one are recorded.
+ */
+static void recorder_end_frame(void)
+{
+    FrameRecord *record = &g_recorder.frames[g_recorder.frame % RECORDER_FRAMES];
+    const Uint64 frame_end = SDL_GetPerformanceCounter();
+    record->total_ms = (float)((double)(frame_end - g_recorder.frame_start) * 1000.0 /
+                               (double)SDL_GetPerformanceFrequency());
+#ifdef __EMSCRIPTEN__
+    browser_end_frame(record, frame_end);
+#endif
+
+    if (!g_recorder.dump_pending && g_recorder.frame >= RECORDER_WARMUP_FRAMES &&
+        record->total_ms > g_recorder.threshold_ms)
+    {
+        g_recorder.dump_pending = true;
+        g_recorder.slow_frame = g_recorder.frame;
+    }
+
+    if (g_recorder.dump_pending && g_recorder.frame >= g_recorder.slow_frame + RECORDER_POST_FRAMES)
+    {
+        recorder_dump();
+        g_recorder.dump_pending = false;
+    }
+
+    g_recorder.frame++;
+}
+
+/**
+ * Writes the oldest keyframe still covered by the frame ring, followed by all
+ * frames recorded since, to a file named after the slow frame.
+ *
+ * @return true if the dump was written, false otherwise
+ */
+static bool recorder_dump(void)
+{
+    const Uint32 last_frame = g_recorder.frame;
+    const Uint32 oldest_frame = last_frame >= RECORDER_FRAMES - 1 ? last_frame - (RECORDER_FRAMES - 1) : 0;
+
+    /* Pick the oldest keyframe whose following frames are all still in the ring */
+    const StateKeyframe *start = NULL;
+    for (int i = 0; i < RECORDER_KEYFRAMES; i++)
+    {
+        const StateKeyframe *keyframe = &g_recorder.keyframes[i];
+        if (keyframe->valid && keyframe->frame >= oldest_frame && keyframe->frame <= last_frame &&
+            (!start || keyframe->frame < start->frame))
+        {
+            start = keyframe;
+        }
+    }
+
+    if (!start)
+    {
+        return false;
+    }
+
+    char path[64];
+    snprintf(path, sizeof(path), RECORDER_DUMP_PATTERN, g_recorder.slow_frame);
+
+    FILE *file = fopen(path, "wb");
+    if (!file)
+    {
+        fprintf(stderr, "Failed to open %s for writing\n", path);
+        return false;
+    }
+
+    const size_t dot_count = (size_t)g_grid_rows * (size_t)g_grid_cols;
+    const RecordingHeader header = {
+        .magic = RECORDER_MAGIC,
+        .version = RECORDER_VERSION,
+        .rows = g_grid_rows,
+        .cols = g_grid_cols,
+        .first_frame = start->frame,
+        .frame_count = last_frame - start->frame + 1,
+        .slow_frame = g_recorder.slow_frame,
+        .threshold_ms = g_recorder.threshold_ms,
+        .physics_mode = g_physics_mode,
+        .params = g_physics_params};
+
+    bool ok = fwrite(&header, sizeof(header), 1, file) == 1 &&
+              fwrite(&start->drag, sizeof(start->drag), 1, file) == 1 &&
+              fwrite(start->dots, sizeof(Dot), dot_count, file) == dot_count;
+
+    for (Uint32 frame = start->frame; ok && frame <= last_frame; frame++)
+    {
+        ok = fwrite(&g_recorder.frames[frame % RECORDER_FRAMES], sizeof(FrameRecord), 1, file) == 1;
+    }
+
+    fclose(file);
+
+    if (!ok)
+    {
+        fprintf(stderr, "Failed to write %s\n", path);
+        return false;
+    }
+
+    printf("Slow frame %u (%.2f ms): wrote %u frames to %s\n",
+           g_recorder.slow_frame,
+           g_recorder.frames[g_recorder.slow_frame % RECORDER_FRAMES].total_ms,
+           header.frame_count,
+           path);
+    return true;
+}
+
+/**
+ * Reads a flight recorder dump: replaces the grid with the keyframe's dots,
+ * restores its drag state and switches to the physics mode it was recorded
+ * with. Dumps with no frames, more frames than the recorder keeps or more
+ * inputs in a frame than it records are rejected; a drag off the grid is
+ * dropped.
+ *
+ * @param path Path of the dump
+ * @param header Output, the dump's header
+ * @param keep_grid Read into the current grid, whose size the dump must match, instead of allocating one;
+ *                  for callers that have already sized other buffers for it
+ * @return The header->frame_count recorded frames, to be freed by the caller, or NULL on error
+ */
+static FrameRecord *recording_load(const char *path, RecordingHeader *header, bool keep_grid)
+{
+    FILE *file = fopen(path, "rb");
+    if (!file)
+    {
+        fprintf(stderr, "Failed to open %s\n", path);
+        return NULL;
+    }
+
+    if (fread(header, sizeof(*header), 1, file) != 1 || header->magic != RECORDER_MAGIC ||
+        header->version != RECORDER_VERSION || header->rows < 1 || header->cols < 1 ||
+        header->frame_count < 1 || header->frame_count > RECORDER_FRAMES || header->physics_mode >= PHYSICS_MODE_COUNT)
+    {
+        fprintf(stderr, "%s is not a flight recorder dump\n", path);
+        fclose(file);
+        return NULL;
+    }
+    if (keep_grid && (header->rows != g_grid_rows || header->cols != g_grid_cols))
+    {
+        fprintf(stderr, "%s was recorded on a %dx%d grid, run with --grid %dx%d\n", path, header->rows, header->cols,
+                header->rows, header->cols);
+        fclose(file);
+        return NULL;
+    }
+
+    const size_t dot_count = (size_t)header->rows * (size_t)header->cols;
+    FrameRecord *frames = malloc(header->frame_count * sizeof(FrameRecord));
+    if (!frames || (!keep_grid && !allocate_grid(header->rows, header->cols)) ||
+        fread(&g_drag_state, sizeof(g_drag_state), 1, file) != 1 ||
+        fread(g_dots, sizeof(Dot), dot_count, file) != dot_count ||
+        fread(frames, sizeof(FrameRecord), header->frame_count, file) != header->frame_count)
+    {
+        fprintf(stderr, "Failed to read %s\n", path);
+        free(frames);
+        fclose(file);
+        return NULL;
+    }
+    fclose(file);
+
+    for (Uint32 i = 0; i < header->frame_count; i++)
+    {
+        if (frames[i].input_count > RECORDER_INPUTS_PER_FRAME)
+        {
+            fprintf(stderr, "%s is corrupt: frame %u has %u inputs\n", path, frames[i].frame, frames[i].input_count);
+            free(frames);
+            return NULL;
+        }
+    }
+    if (!drag_state_valid(&g_drag_state, header->rows, header->cols))
+    {
+        g_drag_state = (DragState){0};
+    }
+
+    /* Steps are only reproduced with the arithmetic they were recorded with */
+    g_physics_mode = (PhysicsMode)header->physics_mode;
+    g_physics_params = header->params;
+    return frames;
+}
+
+/**
+ * Replays a flight recorder dump headlessly: restores the keyframe, re-applies
+ * the recorded inputs and times each physics step against the recorded one.
+ * An input script is replayed the same way from the rest lattice of the
+ * --grid sheet, with --substeps steps per frame.
+ *
+ * @param options Command line options, naming the dump or script in replay_path
+ * @return EXIT_SUCCESS on success, EXIT_FAILURE on error
+ */
+static int run_replay_benchmark(const Options *options)
+{
+    const char *path = options->replay_path;
+
+    /* Anything that is not a flight recorder dump is taken for an input script */
+    Uint32 magic = 0;
+    FILE *file = fopen(path, "rb");
+    if (file)
+    {
+        if (fread(&magic, sizeof(magic), 1, file) != 1)
+        {
+            magic = 0;
+        }
+        fclose(file);
+    }
+    const bool recorded = magic == RECORDER_MAGIC;
+
+    RecordingHeader header = {0};
+    FrameRecord *frames = NULL;
+    Script script = {0};
+    if (recorded)
+    {
+        frames = recording_load(path, &header, false);
+    }
+    else if (script_load(path, &script) && allocate_grid(options->rows, options->cols))
+    {
+        initialize_grid();
+        g_physics_mode = options->physics_mode;
+        g_substeps = options->substeps;
+        header = (RecordingHeader){.rows = options->rows, .cols = options->cols, .frame_count = script.frames};
+        frames = script_records(&script);
+    }
+    script_free(&script);
+    if (!frames)
+    {
+        return EXIT_FAILURE;
+    }
+
+    if (recorded)
+    {
+        printf("Replaying %s: %dx%d grid, frames %u-%u, slow frame %u, %s physics\n",
+               path, header.rows, header.cols, header.first_frame,
+               header.first_frame + header.frame_count - 1, header.slow_frame, k_physics_mode_names[g_physics_mode]);
+    }
+    else
+    {
+        printf("Replaying script %s: %dx%d grid, %u frames, %d steps per frame, %s physics\n", path, header.rows,
+               header.cols, header.frame_count, g_substeps, k_physics_mode_names[g_physics_mode]);
+    }
+    printf("%8s %8s %5s", "frame", "inputs", "steps");
+    for (int stage = 0; recorded && stage < STAGE_COUNT; stage++)
+    {
+        printf(" %9s", k_stage_names[stage]);
+    }
+    if (recorded)
+    {
+        printf(" %9s %9s %6s", "total", "latency", "scale");
+    }
+    printf(" %9s\n", "replayed");
+
+    const double ms_per_tick = 1000.0 / (double)SDL_GetPerformanceFrequency();
+    double replay_total_ms = 0.0;
+    Uint32 truncated_frames = 0;
+
+    for (Uint32 i = 0; i < header.frame_count; i++)
+    {
+        const FrameRecord *record = &frames[i];
+
+        /* Inputs and steps in the order they happened; a sliced step only completes in its last frame */
+        double replay_ms = 0.0;
+        Uint32 steps = 0;
+        for (Uint32 input = 0; input < record->input_count; input++)
+        {
+            if (record->inputs[input].type == INPUT_STEP)
+            {
+                const Uint64 start = SDL_GetPerformanceCounter();
+                update_physics();
+                replay_ms += (double)(SDL_GetPerformanceCounter() - start) * ms_per_tick;
+                steps++;
+            }
+            else
+            {
+                apply_input_command(&record->inputs[input]);
+            }
+        }
+        replay_total_ms += replay_ms;
+
+        printf("%8u %8u %5u", record->frame, record->input_count - steps, steps);
+        if (recorded)
+        {
+            for (int stage = 0; stage < STAGE_COUNT; stage++)
+            {
+                printf(" %9.3f", record->stage_ms[stage]);
+            }
+            printf(" %9.3f", record->total_ms);
+            if (record->latency_ms >= 0.0f)
+            {
+                printf(" %9.1f", record->latency_ms);
+            }
+            else
+            {
+                printf(" %9s", "-");
+            }
+            printf(" %6.2f", record->render_scale);
+        }
+        printf(" %9.3f%s", replay_ms, recorded && record->frame == header.slow_frame ? "  <- slow" : "");
+        if (record->dropped_inputs > 0)
+        {
+            printf("  <- %u inputs dropped", record->dropped_inputs);
+            truncated_frames++;
+        }
+        printf("\n");
+    }
+
+    printf("Replayed physics: %.3f ms total, %.3f ms/frame\n",
+           replay_total_ms, header.frame_count ? replay_total_ms / header.frame_count : 0.0);
+    if (truncated_frames > 0)
+    {
+        printf("Warning: inputs past %d per frame were dropped in %u of the frames; the replay diverges there\n",
+               RECORDER_INPUTS_PER_FRAME - SUBSTEPS_MAX, truncated_frames);
+    }
+
+    free(frames);
+    fixed_shutdown();
+    return EXIT_SUCCESS;
+}
+
+/**
+ * Converts a script duration to script frames, rounding to the nearest.
+ *
+ * @param ms Duration in milliseconds
+ * @return Frames
+ */
+static Uint32 script_frames(double ms)
+{
+    return (Uint32)floor(ms * SCRIPT_FRAME_RATE / 1000.0 + 0.5);
+}
+
+/**
+ * Reports a script error at the line being compiled.
+ *
+ * @param compiler Script compiler
+ * @param line Line index
+ * @param message What is wrong
+ * @return false, for returning directly
+ */
+static bool script_error(const ScriptCompiler *compiler, int line, const char *message)
+{
+    fprintf(stderr, "%s:%d: %s\n", compiler->name, line + 1, message);
+    return false;
+}
+
+/**
+ * Parses the numbers in tokens, failing on anything that is not a finite
+ * number.
+ *
+ * @param tokens Tokens to parse
+ * @param count Number of tokens
+ * @param values Output, one value per token
+ * @return true if every token is a number
+ */
+static bool script_numbers(char *const *tokens, int count, double *values)
+{
+    for (int i = 0; i < count; i++)
+    {
+        char *end;
+        values[i] = strtod(tokens[i], &end);
+        if (end == tokens[i] || *end != '\0' || !isfinite(values[i]))
+        {
+            return false;
+        }
+    }
+    return true;
+}
+
+/**
+ * Appends an input command to a compiled script.
+ *
+ * @param script Script being compiled
+ * @param frame Frame the command applies in
+ * @param type Input type
+ * @param touch Touch slot, used by the INPUT_TOUCH_* types
+ * @param x Position in window coordinates
+ * @param y Position in window coordinates
+ * @return true on success, false if the script grew too large
+ */
+static bool script_emit(Script *script, Uint32 frame, InputType type, int touch, float x, float y)
+{
+    if (script->count == script->capacity)
+    {
+        if (script->capacity >= SCRIPT_MAX_EVENTS)
+        {
+            return false;
+        }
+        const int capacity = script->capacity ? script->capacity * 2 : 1024;
+        ScriptEvent *events = realloc(script->events, (size_t)capacity * sizeof(ScriptEvent));
+        if (!events)
+        {
+            return false;
+        }
+        script->events = events;
+        script->capacity = capacity;
+    }
+
+    const Sint32 slot = type == INPUT_TOUCH_DOWN || type == INPUT_TOUCH_MOVE || type == INPUT_TOUCH_UP ? touch : 0;
+    script->events[script->count] = (ScriptEvent){
+        frame, (Uint32)script->count, {type, (Sint32)floorf(x + 0.5f), (Sint32)floorf(y + 0.5f), slot}};
+    script->count++;
+    script->frames = SDL_max(script->frames, frame + 1);
+    return true;
+}
+
+/**
+ * Moves a pointer at constant speed along a polyline starting from its last
+ * position, with one move per frame; the last one lands on the final point.
+ *
+ * @param compiler Script compiler holding the pointer's position
+ * @param script Script being compiled
+ * @param frame First frame of the path
+ * @param frames Frames the path takes; 0 moves straight to the end at once
+ * @param pointer 0 for the mouse, 1 + slot for a touch
+ * @param points Polyline corners as x, y pairs
+ * @param point_count Number of corners
+ * @return true on success, false if the script grew too large
+ */
+static bool script_emit_path(ScriptCompiler *compiler, Script *script, Uint32 frame, Uint32 frames, int pointer,
+                             const double *points, int point_count)
+{
+    const InputType type = pointer == 0 ? INPUT_MOVE : INPUT_TOUCH_MOVE;
+    double length = 0.0;
+    double from_x = compiler->x[pointer];
+    double from_y = compiler->y[pointer];
+    for (int i = 0; i < point_count; i++)
+    {
+        length += hypot(points[i * 2] - from_x, points[i * 2 + 1] - from_y);
+        from_x = points[i * 2];
+        from_y = points[i * 2 + 1];
+    }
+
+    /* Walk the polyline once, one frame's share of its length at a time */
+    const Uint32 moves = SDL_max(frames, 1u);
+    int corner = 0;
+    double travelled = 0.0; /* Length up to the start of the current segment */
+    double start_x = compiler->x[pointer];
+    double start_y = compiler->y[pointer];
+    for (Uint32 move = 1; move <= moves; move++)
+    {
+        const double target = length * move / moves;
+        double segment = hypot(points[corner * 2] - start_x, points[corner * 2 + 1] - start_y);
+        while (corner < point_count - 1 && travelled + segment < target)
+        {
+            travelled += segment;
+            start_x = points[corner * 2];
+            start_y = points[corner * 2 + 1];
+            corner++;
+            segment = hypot(points[corner * 2] - start_x, points[corner * 2 + 1] - start_y);
+        }
+
+        /* The last move lands exactly on the final point */
+        const double t = segment <= 0.0 ? 1.0 : SDL_min((target - travelled) / segment, 1.0);
+        const bool last = move == moves;
+        const float x = (float)(last ? points[point_count * 2 - 2] : start_x + (points[corner * 2] - start_x) * t);
+        const float y = (float)(last ? points[point_count * 2 - 1] : start_y + (points[corner * 2 + 1] - start_y) * t);
+        if (!script_emit(script, frame + move - 1, type, pointer - 1, x, y))
+        {
+            return false;
+        }
+    }
+
+    compiler->x[pointer] = (float)points[point_count * 2 - 2];
+    compiler->y[pointer] = (float)points[point_count * 2 - 1];
+    return true;
+}
+
+/**
+ * Compiles one statement that is not a block.
+ *
+ * @param compiler Script compiler
+ * @param script Script being compiled
+ * @param line Line index, for errors
+ * @param tokens Tokens of the line
+ * @param count Number of tokens
+ * @param frame Frame the statement starts in
+ * @param frames Output, frames the statement takes
+ * @return true on success, false on an error, which has been reported
+ */
+static bool script_compile_statement(ScriptCompiler *compiler, Script *script, int line, char **tokens, int count,
+                                     Uint32 frame, Uint32 *frames)
+{
+    double values[SCRIPT_MAX_TOKENS];
+    const char *command = tokens[0];
+    int pointer = 0;
+    *frames = 0;
+
+    /* "touch N ..." addresses touch N with the mouse verbs below */
+    if (strcmp(command, "touch") == 0)
+    {
+        if (count < 3 || !script_numbers(&tokens[1], 1, values) || values[0] < 0 || values[0] >= TOUCH_MAX_POINTS ||
+            values[0] != floor(values[0]))
+        {
+            return script_error(compiler, line, "expected touch 0-9 followed by down, move or up");
+        }
+        pointer = 1 + (int)values[0];
+        tokens += 2;
+        count -= 2;
+        if (strcmp(tokens[0], "down") == 0)
+        {
+            command = "grab";
+        }
+        else if (strcmp(tokens[0], "up") == 0)
+        {
+            command = "release";
+        }
+        else if (strcmp(tokens[0], "move") == 0)
+        {
+            command = "move";
+        }
+        else
+        {
+            return script_error(compiler, line, "expected down, move or up after touch N");
+        }
+    }
+
+    const bool numeric = script_numbers(&tokens[1], count - 1, values);
+    if (strcmp(command, "wait") == 0)
+    {
+        if (count != 2 || !numeric || values[0] < 0.0 || values[0] > SCRIPT_MAX_DURATION_MS)
+        {
+            return script_error(compiler, line, "expected wait MS");
+        }
+        *frames = script_frames(values[0]);
+        return true;
+    }
+
+    if (strcmp(command, "grab") == 0)
+    {
+        if (count != 3 || !numeric)
+        {
+            return script_error(compiler, line, pointer ? "expected touch N down X Y" : "expected grab X Y");
+        }
+        compiler->x[pointer] = (float)values[0];
+        compiler->y[pointer] = (float)values[1];
+        return script_emit(script, frame, pointer ? INPUT_TOUCH_DOWN : INPUT_GRAB, pointer - 1, compiler->x[pointer],
+                           compiler->y[pointer]) ||
+               script_error(compiler, line, "script too long");
+    }
+
+    if (strcmp(command, "release") == 0)
+    {
+        if (count != 1)
+        {
+            return script_error(compiler, line, pointer ? "expected touch N up" : "expected release");
+        }
+        return script_emit(script, frame, pointer ? INPUT_TOUCH_UP : INPUT_RELEASE, pointer - 1,
+                           compiler->x[pointer], compiler->y[pointer]) ||
+               script_error(compiler, line, "script too long");
+    }
+
+    if (strcmp(command, "move") == 0)
+    {
+        if ((count != 3 && count != 4) || !numeric ||
+            (count == 4 && (values[2] < 0.0 || values[2] > SCRIPT_MAX_DURATION_MS)))
+        {
+            return script_error(compiler, line, pointer ? "expected touch N move X Y [MS]" : "expected move X Y [MS]");
+        }
+        *frames = count == 4 ? script_frames(values[2]) : 0;
+        return script_emit_path(compiler, script, frame, *frames, pointer, values, 1) ||
+               script_error(compiler, line, "script too long");
+    }
+
+    if (strcmp(command, "brush") == 0)
+    {
+        /* Grab at the first point, drag through the rest, let go at the end */
+        if (count < 6 || count % 2 != 0 || !numeric || values[0] < 0.0 || values[0] > SCRIPT_MAX_DURATION_MS)
+        {
+            return script_error(compiler, line, "expected brush MS X1 Y1 X2 Y2 [X3 Y3 ...]");
+        }
+        *frames = script_frames(values[0]);
+        compiler->x[0] = (float)values[1];
+        compiler->y[0] = (float)values[2];
+        return (script_emit(script, frame, INPUT_GRAB, -1, compiler->x[0], compiler->y[0]) &&
+                script_emit_path(compiler, script, frame, *frames, 0, &values[3], (count - 4) / 2) &&
+                script_emit(script, frame + *frames, INPUT_RELEASE, -1, compiler->x[0], compiler->y[0])) ||
+               script_error(compiler, line, "script too long");
+    }
+
+    return script_error(compiler, line, "unknown command");
+}
+
+/**
+ * Compiles lines up to the end of the script or of the enclosing block.
+ * Statements run one after another, or all from the same frame inside a
+ * parallel block, which then lasts as long as its longest statement.
+ *
+ * @param compiler Script compiler
+ * @param script Script being compiled
+ * @param line In: first line of the block; out: the line after its "end"
+ * @param frame Frame the block starts in
+ * @param parallel Whether the block is a parallel block
+ * @param frames Output, frames the block takes
+ * @return true on success, false on an error, which has been reported
+ */
+static bool script_compile_block(ScriptCompiler *compiler, Script *script, int *line, Uint32 frame, bool parallel,
+                                 Uint32 *frames)
+{
+    const int depth = compiler->depth;
+    const int first_line = *line;
+    Uint64 length = 0; /* Frames taken so far */
+
+    while (*line < compiler->line_count)
+    {
+        char text[SCRIPT_MAX_LINE];
+        char *tokens[SCRIPT_MAX_TOKENS];
+        int count = 0;
+        const int current = (*line)++;
+        if (strlen(compiler->lines[current]) >= sizeof(text))
+        {
+            return script_error(compiler, current, "line too long");
+        }
+        strcpy(text, compiler->lines[current]);
+
+        /* Split on whitespace, up to a comment */
+        char *cursor = text;
+        while (*cursor && *cursor != '#')
+        {
+            if (isspace((unsigned char)*cursor))
+            {
+                cursor++;
+                continue;
+            }
+            if (count == SCRIPT_MAX_TOKENS)
+            {
+                return script_error(compiler, current, "too many values");
+            }
+            tokens[count++] = cursor;
+            while (*cursor && *cursor != '#' && !isspace((unsigned char)*cursor))
+            {
+                cursor++;
+            }
+            const char next = *cursor;
+            *cursor = '\0';
+            if (next != '#' && next != '\0')
+            {
+                cursor++;
+            }
+            else
+            {
+                break;
+            }
+        }
+        if (count == 0)
+        {
+            continue;
+        }
+
+        if (strcmp(tokens[0], "end") == 0)
+        {
+            if (depth == 0 || count != 1)
+            {
+                return script_error(compiler, current, "end without repeat or parallel");
+            }
+            *frames = (Uint32)length;
+            return true;
+        }
+
+        const Uint32 start = frame + (parallel ? 0 : (Uint32)length);
+        Uint64 taken = 0;
+        if (strcmp(tokens[0], "repeat") == 0 || strcmp(tokens[0], "parallel") == 0)
+        {
+            const bool repeat = tokens[0][0] == 'r';
+            double repeats = 1.0;
+            if (depth == SCRIPT_MAX_DEPTH)
+            {
+                return script_error(compiler, current, "blocks nested too deeply");
+            }
+            if (repeat ? count != 2 || !script_numbers(&tokens[1], 1, &repeats) || repeats < 1.0 ||
+                             repeats != floor(repeats) || repeats > SCRIPT_MAX_EVENTS
+                       : count != 1)
+            {
+                return script_error(compiler, current, repeat ? "expected repeat COUNT" : "expected parallel");
+            }
+
+            /* Each pass compiles the body again, moving on from where the last one left the pointers */
+            const int body = *line;
+            compiler->depth = depth + 1;
+            for (int pass = 0; pass < (int)repeats && taken <= SCRIPT_MAX_FRAMES; pass++)
+            {
+                Uint32 pass_frames;
+                *line = body;
+                if (!script_compile_block(compiler, script, line, (Uint32)(start + taken), !repeat, &pass_frames))
+                {
+                    return false;
+                }
+                taken += pass_frames;
+            }
+            compiler->depth = depth;
+        }
+        else
+        {
+            Uint32 statement_frames;
+            if (!script_compile_statement(compiler, script, current, tokens, count, start, &statement_frames))
+            {
+                return false;
+            }
+            taken = statement_frames;
+        }
+
+        length = parallel ? SDL_max(length, taken) : length + taken;
+        if ((Uint64)frame + length > SCRIPT_MAX_FRAMES)
+        {
+            return script_error(compiler, current, "script too long");
+        }
+    }
+
+    if (depth > 0)
+    {
+        return script_error(compiler, first_line - 1, "repeat or parallel without end");
+    }
+    *frames = (Uint32)length;
+    return true;
+}
+
+/**
+ * Orders script events by frame, keeping the compiled order within a frame.
+ */
+static int compare_script_events(const void *a, const void *b)
+{
+    const ScriptEvent *event_a = a;
+    const ScriptEvent *event_b = b;
+    if (event_a->frame != event_b->frame)
+    {
+        return event_a->frame < event_b->frame ? -1 : 1;
+    }
+    return event_a->order < event_b->order ? -1 : event_a->order > event_b->order;
+}
+
+/**
+ * Compiles an input script into input commands. Pointer positions are in
+ * window coordinates and start at the centre of the window; durations are
+ * in milliseconds, played at SCRIPT_FRAME_RATE frames per second.
+ *
+ * @param text Script text; modified
+ * @param name Name used in error messages
+ * @param script Output, the compiled script ready to play
+ * @return true on success, false on an error, which has been reported
+ */
+static bool script_compile(char *text, const char *name, Script *script)
+{
+    ScriptCompiler compiler = {.name = name};
+    for (int i = 0; i <= TOUCH_MAX_POINTS; i++)
+    {
+        compiler.x[i] = WINDOW_WIDTH / 2.0f;
+        compiler.y[i] = WINDOW_HEIGHT / 2.0f;
+    }
+
+    /* Split into lines in place */
+    int capacity = 1;
+    for (const char *c = text; *c; c++)
+    {
+        capacity += *c == '\n';
+    }
+    compiler.lines = malloc((size_t)capacity * sizeof(char *));
+    if (!compiler.lines)
+    {
+        return false;
+    }
+    for (char *start = text; start;)
+    {
+        char *end = strchr(start, '\n');
+        if (end)
+        {
+            *end = '\0';
+            if (end > start && end[-1] == '\r')
+            {
+                end[-1] = '\0';
+            }
+        }
+        compiler.lines[compiler.line_count++] = start;
+        start = end ? end + 1 : NULL;
+    }
+
+    *script = (Script){.name = name};
+    int line = 0;
+    Uint32 frames;
+    const bool ok = script_compile_block(&compiler, script, &line, 0, false, &frames);
+    free(compiler.lines);
+    if (!ok)
+    {
+        script_free(script);
+        return false;
+    }
+
+    if (script->count > 0)
+    {
+        qsort(script->events, (size_t)script->count, sizeof(ScriptEvent), compare_script_events);
+    }
+    script->frames = SDL_max(script->frames, frames);
+    return true;
+}
+
+/**
+ * Reads and compiles an input script file.
+ *
+ * @param path Path of the script
+ * @param script Output, the compiled script ready to play
+ * @return true on success, false on an error, which has been reported
+ */
+static bool script_load(const char *path, Script *script)
+{
+    FILE *file = fopen(path, "rb");
+    if (!file)
+    {
+        fprintf(stderr, "Failed to open %s\n", path);
+        return false;
+    }
+
+    /* Read in chunks, so scripts can come from pipes too */
+    size_t length = 0;
+    size_t capacity = 4096;
+    char *text = malloc(capacity + 1);
+    while (text)
+    {
+        length += fread(text + length, 1, capacity - length, file);
+        if (length < capacity)
+        {
+            break;
+        }
+        capacity *= 2;
+        char *grown = realloc(text, capacity + 1);
+        if (!grown)
+        {
+            free(text);
+        }
+        text = grown;
+    }
+    const bool read_ok = text && !ferror(file);
+    fclose(file);
+    if (!read_ok)
+    {
+        fprintf(stderr, "Failed to read %s\n", path);
+        free(text);
+        return false;
+    }
+
+    text[length] = '\0';
+    const bool ok = script_compile(text, path, script);
+    free(text);
+    return ok;
+}
+
+/**
+ * Frees a compiled script.
+ *
+ * @param script Script to free
+ */
+static void script_free(Script *script)
+{
+    free(script->events);
+    *script = (Script){0};
+}
+
+/**
+ * Applies, records and forwards to lockstep nodes the commands of the
+ * script's next frame, like live input, and moves on to the frame after.
+ *
+ * @param script Script to play
+ */
+static void script_play_frame(Script *script)
+{
+    while (script->next < script->count && script->events[script->next].frame <= script->frame)
+    {
+        const InputCommand *command = &script->events[script->next++].command;
+        recorder_log_input(command);
+        lockstep_log_input(command);
+        apply_input_command(command);
+    }
+    script->frame++;
+}
+
+/**
+ * Lays a compiled script out as recorded frames, each followed by g_substeps
+ * physics steps, so it can be replayed like a flight recorder dump.
+ *
+ * @param script Compiled script
+ * @return script->frames frames, to be freed by the caller, or NULL on error
+ */
+static FrameRecord *script_records(const Script *script)
+{
+    FrameRecord *frames = calloc(SDL_max(script->frames, 1u), sizeof(FrameRecord));
+    if (!frames)
+    {
+        return NULL;
+    }
+
+    int next = 0;
+    for (Uint32 frame = 0; frame < script->frames; frame++)
+    {
+        FrameRecord *record = &frames[frame];
+        record->frame = frame;
+        record->latency_ms = -1.0f;
+        record->render_scale = 1.0f;
+        for (; next < script->count && script->events[next].frame == frame; next++)
+        {
+            if (record->input_count == RECORDER_INPUTS_PER_FRAME - SUBSTEPS_MAX)
+            {
+                fprintf(stderr, "%s: more than %d commands in frame %u\n", script->name,
+                        RECORDER_INPUTS_PER_FRAME - SUBSTEPS_MAX, frame);
+                free(frames);
+                return NULL;
+            }
+            record->inputs[record->input_count++] = script->events[next].command;
+        }
+        for (int substep = 0; substep < g_substeps; substep++)
+        {
+            record->inputs[record->input_count++] = (InputCommand){.type = INPUT_STEP};
+        }
+    }
+    return frames;
+}
+
+/**
+ * Writes a signed value as a zigzag varint.
+ *
+ * @param out Output buffer with room for at least 5 bytes
+ * @param value Value to encode
+ * @return Pointer past the last byte written
+ */
+static inline Uint8 *write_varint(Uint8 *out, Sint32 value)
+{
+    Uint32 zigzag = ((Uint32)value << 1) ^ (Uint32)(value >> 31);
+    while (zigzag >= 0x80)
+    {
+        *out++ = (Uint8)(zigzag | 0x80);
+        zigzag >>= 7;
+    }
+    *out++ = (Uint8)zigzag;
+    return out;
+}
+
+/**
+ * Reads a zigzag varint written by write_varint.
+ *
+ * @param in Input cursor, advanced past the value
+ * @return Decoded value
+ */
+static inline Sint32 read_varint(const Uint8 **in)
+{
+    Uint32 zigzag = 0;
+    int shift = 0;
+    Uint8 byte;
+    do
+    {
+        byte = *(*in)++;
+        zigzag |= (Uint32)(byte & 0x7F) << shift;
+        shift += 7;
+    } while (byte & 0x80);
+    return (Sint32)(zigzag >> 1) ^ -(Sint32)(zigzag & 1);
+}
+
+/**
+ * Quantises a dot's position, velocity and rest position for delta encoding.
+ *
+ * @param dot Dot to quantise
+ * @param out Output for quantised x, y, vx, vy, rest x, rest y
+ */
+static inline void history_quantise(const Dot *dot, Sint32 out[HISTORY_VALUES])
+{
+#ifdef __SSE2__
+    /* x, y, vx, vy are adjacent; the conversion rounds to nearest like lrintf() */
+    const __m128 scale = _mm_setr_ps(HISTORY_POSITION_SCALE, HISTORY_POSITION_SCALE, HISTORY_VELOCITY_SCALE,
+                                     HISTORY_VELOCITY_SCALE);
+    _mm_storeu_si128((__m128i *)out, _mm_cvtps_epi32(_mm_mul_ps(_mm_loadu_ps(&dot->x), scale)));
+    const __m128 rest = _mm_setr_ps(dot->original_x, dot->original_y, 0.0f, 0.0f);
+    _mm_storel_epi64((__m128i *)(out + 4), _mm_cvtps_epi32(_mm_mul_ps(rest, scale)));
+#else
+    out[0] = (Sint32)lrintf(dot->x * HISTORY_POSITION_SCALE);
+    out[1] = (Sint32)lrintf(dot->y * HISTORY_POSITION_SCALE);
+    out[2] = (Sint32)lrintf(dot->vx * HISTORY_VELOCITY_SCALE);
+    out[3] = (Sint32)lrintf(dot->vy * HISTORY_VELOCITY_SCALE);
+    out[4] = (Sint32)lrintf(dot->original_x * HISTORY_POSITION_SCALE);
+    out[5] = (Sint32)lrintf(dot->original_y * HISTORY_POSITION_SCALE);
+#endif
+}
+
+/**
+ * Allocates the history arena and starts the encoder threads. Without thread
+ * support, frames are encoded on the calling thread instead.
+ * Must be called after the grid has been allocated.
+ *
+ * @param budget_bytes Memory budget for recorded frames, 0 to disable history
+ * @return true on success, false if allocation failed
+ */
+static bool history_init(size_t budget_bytes)
+{
+    memset(&g_history, 0, sizeof(g_history));
+    if (budget_bytes == 0)
+    {
+        return true;
+    }
+
+    const size_t dot_count = (size_t)g_grid_rows * (size_t)g_grid_cols;
+    const int cpu_count = SDL_GetCPUCount();
+    int worker_count = cpu_count > 1 ? cpu_count - 1 : 1;
+    if (worker_count > HISTORY_MAX_WORKERS)
+    {
+        worker_count = HISTORY_MAX_WORKERS;
+    }
+
+    g_history.chunk_count = worker_count * HISTORY_CHUNKS_PER_WORKER;
+    g_history.chunk_dots = (dot_count + g_history.chunk_count - 1) / g_history.chunk_count;
+    g_history.capacity = budget_bytes;
+    g_history.arena = arena_alloc(budget_bytes);
+    g_history.entries = arena_alloc(HISTORY_MAX_ENTRIES * sizeof(HistoryEntry));
+    g_history.reference = arena_alloc(dot_count * HISTORY_VALUES * sizeof(Sint32));
+    g_history.chunk_data = arena_alloc(g_history.chunk_count * sizeof(Uint8 *));
+    g_history.chunk_size = arena_alloc(g_history.chunk_count * sizeof(Uint32));
+
+    if (!g_history.arena || !g_history.entries || !g_history.reference || !g_history.chunk_data ||
+        !g_history.chunk_size)
+    {
+        fprintf(stderr, "Failed to allocate rewind history\n");
+        history_shutdown();
+        return false;
+    }
+
+    /* A worst-case delta is larger than a keyframe; the trailing run length fits in the last dot's share */
+    for (int chunk = 0; chunk < g_history.chunk_count; chunk++)
+    {
+        g_history.chunk_data[chunk] = arena_alloc(g_history.chunk_dots * HISTORY_DELTA_DOT_BYTES);
+        if (!g_history.chunk_data[chunk])
+        {
+            fprintf(stderr, "Failed to allocate rewind history\n");
+            history_shutdown();
+            return false;
+        }
+    }
+
+    g_history.enabled = true;
+    g_history.force_keyframe = true;
+
+    g_history.start = SDL_CreateSemaphore(0);
+    g_history.done = SDL_CreateSemaphore(0);
+    if (g_history.start && g_history.done)
+    {
+        for (int i = 0; i < worker_count; i++)
+        {
+            g_history.workers[g_history.worker_count] =
+                SDL_CreateThread(history_worker, "history", (void *)(intptr_t)g_history.worker_count);
+            if (!g_history.workers[g_history.worker_count])
+            {
+                break;
+            }
+            g_history.worker_count++;
+        }
+    }
+
+    if (g_history.worker_count == 0)
+    {
+        printf("Rewind history: encoding on the main thread (%s)\n", SDL_GetError());
+    }
+    return true;
+}
+
+/**
+ * Stops the encoder threads, reports what recording cost against the physics
+ * and frees the history.
+ */
+static void history_shutdown(void)
+{
+    history_wait();
+
+    if (g_history.recorded_frames > 0 && g_history.physics_ms > 0.0)
+    {
+        double encode_ms = 0.0;
+        for (int i = 0; i <= HISTORY_MAX_WORKERS; i++)
+        {
+            encode_ms += g_history.encode_ms[i];
+        }
+        printf("Rewind history: %u frames; main thread %.3f ms per frame, %.1f%% of physics time, "
+               "and %.3f ms, %.1f%%, waiting for encoders; encoding %.3f ms CPU per frame, %.1f%%, on %d threads\n",
+               g_history.recorded_frames, g_history.main_ms / g_history.recorded_frames,
+               100.0 * g_history.main_ms / g_history.physics_ms, g_history.wait_ms / g_history.recorded_frames,
+               100.0 * g_history.wait_ms / g_history.physics_ms, encode_ms / g_history.recorded_frames,
+               100.0 * encode_ms / g_history.physics_ms, g_history.worker_count);
+    }
+
+    g_history.quit = true;
+    for (int i = 0; i < g_history.worker_count; i++)
+    {
+        SDL_SemPost(g_history.start);
+    }
+    for (int i = 0; i < g_history.worker_count; i++)
+    {
+        SDL_WaitThread(g_history.workers[i], NULL);
+    }
+
+    if (g_history.start)
+    {
+        SDL_DestroySemaphore(g_history.start);
+    }
+    if (g_history.done)
+    {
+        SDL_DestroySemaphore(g_history.done);
+    }
+    for (int chunk = 0; g_history.chunk_data && chunk < g_history.chunk_count; chunk++)
+    {
+        arena_free(g_history.chunk_data[chunk]);
+    }
+    arena_free(g_history.chunk_data);
+    arena_free(g_history.chunk_size);
+    arena_free(g_history.reference);
+    arena_free(g_history.entries);
+    arena_free(g_history.arena);
+    memset(&g_history, 0, sizeof(g_history));
+}
+
+/**
+ * Encoder thread: encodes chunks of each submitted frame until none are left.
+ * The last worker to finish commits the frame to the arena.
+ *
+ * @param data Worker index, for its share of the encode time
+ * @return 0
+ */
+static int history_worker(void *data)
+{
+    const int worker = (int)(intptr_t)data;
+
+    for (;;)
+    {
+        SDL_SemWait(g_history.start);
+        if (g_history.quit)
+        {
+            return 0;
+        }
+
+        const Uint64 start = SDL_GetPerformanceCounter();
+
+        for (;;)
+        {
+            const int chunk = SDL_AtomicAdd(&g_history.next_chunk, 1);
+            if (chunk >= g_history.chunk_count)
+            {
+                break;
+            }
+            history_encode_chunk(chunk);
+        }
+
+        /* Each worker adds its time before the frame can count as done */
+        const double frequency = (double)SDL_GetPerformanceFrequency();
+        g_history.encode_ms[worker] += (double)(SDL_GetPerformanceCounter() - start) * 1000.0 / frequency;
+        if (SDL_AtomicAdd(&g_history.pending, -1) == 1)
+        {
+            const Uint64 commit_start = SDL_GetPerformanceCounter();
+            history_commit();
+            g_history.encode_ms[worker] += (double)(SDL_GetPerformanceCounter() - commit_start) * 1000.0 / frequency;
+            SDL_SemPost(g_history.done);
+        }
+    }
+}
+
+/**
+ * Encodes one chunk of the current frame into its chunk buffer and updates the
+ * quantised reference the next delta is taken against.
+ *
+ * @param chunk Chunk index
+ */
+static void history_encode_chunk(int chunk)
+{
+    const size_t dot_count = (size_t)g_grid_rows * (size_t)g_grid_cols;
+    const size_t begin = (size_t)chunk * g_history.chunk_dots;
+    const size_t end = begin + g_history.chunk_dots < dot_count ? begin + g_history.chunk_dots : dot_count;
+    Uint8 *out = g_history.chunk_data[chunk];
+
+    /* Without a morph under way rest positions stay put, so deltas leave them out */
+    const int values = g_history.job_rest ? HISTORY_VALUES : 4;
+    Uint32 unchanged = 0; /* Dots since the last one written whose deltas are all zero */
+
+    for (size_t i = begin; i < end; i++)
+    {
+        const Dot *dot = &g_dots[i];
+        Sint32 *reference = &g_history.reference[i * HISTORY_VALUES];
+        Sint32 quantised[HISTORY_VALUES];
+        history_quantise(dot, quantised);
+
+        if (g_history.job_keyframe)
+        {
+            memcpy(out, &dot->x, 6 * sizeof(float)); /* x, y, vx, vy and the rest position are adjacent */
+            out[24] = dot->fixed;
+            out += HISTORY_KEYFRAME_DOT_BYTES;
+        }
+        else
+        {
+            /* A settled sheet is mostly zero deltas, written as run lengths instead */
+            Sint32 changed = 0;
+            for (int value = 0; value < values; value++)
+            {
+                changed |= quantised[value] ^ reference[value];
+            }
+            if (!changed)
+            {
+                unchanged++;
+                continue;
+            }
+
+            out = write_varint(out, (Sint32)unchanged);
+            unchanged = 0;
+            for (int value = 0; value < values; value++)
+            {
+                out = write_varint(out, quantised[value] - reference[value]);
+            }
+        }
+
+        memcpy(reference, quantised, sizeof(quantised));
+    }
+    if (unchanged > 0)
+    {
+        out = write_varint(out, (Sint32)unchanged);
+    }
+
+    g_history.chunk_size[chunk] = (Uint32)(out - g_history.chunk_data[chunk]);
+}
+
+/**
+ * Appends the encoded chunks of the current frame to the arena, evicting the
+ * oldest entries it overlaps along with any deltas orphaned by that.
+ */
+static void history_commit(void)
+{
+    size_t size = (size_t)g_history.chunk_count * sizeof(Uint32);
+    for (int chunk = 0; chunk < g_history.chunk_count; chunk++)
+    {
+        size += g_history.chunk_size[chunk];
+    }
+
+    if (size > g_history.capacity)
+    {
+        fprintf(stderr, "Rewind history: frame needs %zu bytes, budget is %zu; disabling\n", size, g_history.capacity);
+        g_history.enabled = false;
+        return;
+    }
+
+    /* Entries past the head predate the last wrap and are the oldest ones */
+    const size_t tail_start = g_history.head;
+    size_t offset = g_history.head;
+    bool wrapped = false;
+    if (offset + size > g_history.capacity)
+    {
+        offset = 0;
+        wrapped = true;
+    }
+
+    while (g_history.count > 0)
+    {
+        const HistoryEntry *oldest = &g_history.entries[g_history.first];
+        const bool overlaps = oldest->offset < offset + size && offset < oldest->offset + oldest->size;
+        const bool in_tail = wrapped && oldest->offset >= tail_start;
+        const bool orphaned = !oldest->keyframe;
+        if (!overlaps && !in_tail && !orphaned && g_history.count < HISTORY_MAX_ENTRIES)
+        {
+            break;
+        }
+        g_history.first = (g_history.first + 1) % HISTORY_MAX_ENTRIES;
+        g_history.count--;
+    }
+
+    if (g_history.count == 0 && !g_history.job_keyframe)
+    {
+        /* A delta with nothing to apply it to; the next frame becomes a keyframe */
+        g_history.head = 0;
+        g_history.force_keyframe = true;
+        return;
+    }
+
+    Uint8 *data = g_history.arena + offset;
+    memcpy(data, g_history.chunk_size, (size_t)g_history.chunk_count * sizeof(Uint32));
+    data += (size_t)g_history.chunk_count * sizeof(Uint32);
+    for (int chunk = 0; chunk < g_history.chunk_count; chunk++)
+    {
+        memcpy(data, g_history.chunk_data[chunk], g_history.chunk_size[chunk]);
+        data += g_history.chunk_size[chunk];
+    }
+
+    HistoryEntry *entry = &g_history.entries[(g_history.first + g_history.count) % HISTORY_MAX_ENTRIES];
+    *entry = (HistoryEntry){
+        .frame = g_history.job_frame,
+        .keyframe = g_history.job_keyframe,
+        .rest = g_history.job_rest,
+        .drag = g_history.job_drag,
+        .morph_shape = g_history.job_morph_shape,
+        .morph_settling = g_history.job_morph_settling,
+        .morph_shaped = g_history.job_morph_shaped,
+        .offset = offset,
+        .size = size};
+    g_history.count++;
+    g_history.head = offset + size;
+}
+
+/**
+ * Records the state after the frame's physics steps. The frame is encoded by
+ * the worker threads until history_wait() is called, so the grid must not be
+ * modified before then.
+ */
+static void history_submit(void)
+{
+    if (!g_history.enabled || g_history.paused)
+    {
+        return;
+    }
+
+    g_history.job_frame = g_history.next_frame++;
+    g_history.job_keyframe = g_history.force_keyframe || g_history.job_frame % HISTORY_KEYFRAME_INTERVAL == 0;
+    g_history.job_rest = g_history.job_keyframe || g_morph.shaped || g_history.rest_shaped;
+    g_history.job_drag = g_drag_state;
+    g_history.job_morph_shape = g_morph.shape;
+    g_history.job_morph_settling = g_morph.settling;
+    g_history.job_morph_shaped = g_morph.shaped;
+    g_history.force_keyframe = false;
+    g_history.rest_shaped = g_morph.shaped;
+
+    /* Called after the physics stage, so the recorder holds this frame's physics time */
+    const Uint64 start = SDL_GetPerformanceCounter();
+    g_history.recorded_frames++;
+    g_history.physics_ms += g_recorder.frames[g_recorder.frame % RECORDER_FRAMES].stage_ms[STAGE_PHYSICS];
+
+    if (g_history.worker_count == 0)
+    {
+        for (int chunk = 0; chunk < g_history.chunk_count; chunk++)
+        {
+            history_encode_chunk(chunk);
+        }
+        history_commit();
+        const double ms =
+            (double)(SDL_GetPerformanceCounter() - start) * 1000.0 / (double)SDL_GetPerformanceFrequency();
+        g_history.encode_ms[HISTORY_MAX_WORKERS] += ms;
+        g_history.main_ms += ms;
+        return;
+    }
+
+    SDL_AtomicSet(&g_history.next_chunk, 0);
+    SDL_AtomicSet(&g_history.pending, g_history.worker_count);
+    g_history.job_active = true;
+    for (int i = 0; i < g_history.worker_count; i++)
+    {
+        SDL_SemPost(g_history.start);
+    }
+    g_history.main_ms +=
+        (double)(SDL_GetPerformanceCounter() - start) * 1000.0 / (double)SDL_GetPerformanceFrequency();
+}
+
+/**
+ * Waits for the frame submitted by history_submit() to be committed.
+ */
+static void history_wait(void)
+{
+    if (g_history.job_active)
+    {
+        const Uint64 start = SDL_GetPerformanceCounter();
+        SDL_SemWait(g_history.done);
+        g_history.job_active = false;
+        g_history.wait_ms +=
+            (double)(SDL_GetPerformanceCounter() - start) * 1000.0 / (double)SDL_GetPerformanceFrequency();
+    }
+}
+
+/**
+ * Restores a recorded frame into the grid by decoding forward from the nearest
+ * keyframe, or from the frame currently shown when that is closer.
+ * Any active drag is released.
+ *
+ * @param frame Frame to restore
+ * @return true if the frame is in the history, false otherwise
+ */
+static bool history_seek(Uint32 frame)
+{
+    history_wait();
+
+    if (g_history.count == 0)
+    {
+        return false;
+    }
+
+    const Uint32 oldest = g_history.entries[g_history.first].frame;
+    if (frame < oldest || frame - oldest >= (Uint32)g_history.count)
+    {
+        return false;
+    }
+
+    const int target = (int)(frame - oldest);
+    int index = target;
+    while (!g_history.entries[(g_history.first + index) % HISTORY_MAX_ENTRIES].keyframe)
+    {
+        index--;
+    }
+
+    /* Continue from the frame already shown if no keyframe lies in between */
+    if (g_history.scrubbed && g_history.cursor >= oldest && (int)(g_history.cursor - oldest) >= index &&
+        (int)(g_history.cursor - oldest) < target)
+    {
+        index = (int)(g_history.cursor - oldest) + 1;
+    }
+
+    const size_t dot_count = (size_t)g_grid_rows * (size_t)g_grid_cols;
+    for (; index <= target; index++)
+    {
+        const HistoryEntry *entry = &g_history.entries[(g_history.first + index) % HISTORY_MAX_ENTRIES];
+        const Uint8 *in = g_history.arena + entry->offset + (size_t)g_history.chunk_count * sizeof(Uint32);
+
+        for (size_t i = 0; entry->keyframe && i < dot_count; i++)
+        {
+            Dot *dot = &g_dots[i];
+            memcpy(&dot->x, in, sizeof(float));
+            memcpy(&dot->y, in + 4, sizeof(float));
+            memcpy(&dot->vx, in + 8, sizeof(float));
+            memcpy(&dot->vy, in + 12, sizeof(float));
+            memcpy(&dot->original_x, in + 16, sizeof(float));
+            memcpy(&dot->original_y, in + 20, sizeof(float));
+            dot->fixed = in[24];
+            in += HISTORY_KEYFRAME_DOT_BYTES;
+        }
+
+        /* Runs of unchanged dots end at chunk boundaries */
+        for (size_t begin = 0; !entry->keyframe && begin < dot_count; begin += g_history.chunk_dots)
+        {
+            const size_t end = begin + g_history.chunk_dots < dot_count ? begin + g_history.chunk_dots : dot_count;
+            for (size_t i = begin; i < end; i++)
+            {
+                i += (Uint32)read_varint(&in);
+                if (i == end)
+                {
+                    break;
+                }
+
+                Dot *dot = &g_dots[i];
+                Sint32 quantised[HISTORY_VALUES];
+                history_quantise(dot, quantised);
+                dot->x = (float)(quantised[0] + read_varint(&in)) / HISTORY_POSITION_SCALE;
+                dot->y = (float)(quantised[1] + read_varint(&in)) / HISTORY_POSITION_SCALE;
+                dot->vx = (float)(quantised[2] + read_varint(&in)) / HISTORY_VELOCITY_SCALE;
+                dot->vy = (float)(quantised[3] + read_varint(&in)) / HISTORY_VELOCITY_SCALE;
+                if (entry->rest)
+                {
+                    dot->original_x = (float)(quantised[4] + read_varint(&in)) / HISTORY_POSITION_SCALE;
+                    dot->original_y = (float)(quantised[5] + read_varint(&in)) / HISTORY_POSITION_SCALE;
+                }
+            }
+        }
+
+        /* Dots held when the keyframe was taken were fixed by the pointers; touches only grab free dots */
+        if (entry->keyframe && entry->drag.is_dragging)
+        {
+            dot_at(entry->drag.row, entry->drag.col)->fixed = false;
+        }
+        for (int i = 0; entry->keyframe && i < TOUCH_MAX_POINTS; i++)
+        {
+            if (entry->drag.touches[i].held)
+            {
+                dot_at(entry->drag.touches[i].row, entry->drag.touches[i].col)->fixed = false;
+            }
+        }
+    }
+
+    /* The morph resumes toward the shape it had at the frame */
+    const HistoryEntry *entry = &g_history.entries[(g_history.first + target) % HISTORY_MAX_ENTRIES];
+    if (g_morph.shape_count > 0)
+    {
+        if (entry->morph_shape != g_morph.shape)
+        {
+            morph_show(entry->morph_shape);
+        }
+        g_morph.settling = entry->morph_settling;
+        g_morph.shaped = entry->morph_shaped;
+    }
+    g_history.rest_shaped = entry->morph_shaped;
+
+    g_drag_state = (DragState){.is_dragging = false, .row = -1, .col = -1};
+    g_history.cursor = frame;
+    g_history.scrubbed = true;
+    return true;
+}
+
+/**
+ * Pauses or resumes the simulation. Resuming from a rewound frame discards the
+ * history after it and starts a new timeline with a keyframe.
+ *
+ * @param paused Whether the simulation should be paused
+ */
+static void history_set_paused(bool paused)
+{
+    history_wait();
+
+    if (!paused && g_history.scrubbed)
+    {
+        const Uint32 oldest = g_history.entries[g_history.first].frame;
+        g_history.count = (int)(g_history.cursor - oldest) + 1;
+        const HistoryEntry *last = &g_history.entries[(g_history.first + g_history.count - 1) % HISTORY_MAX_ENTRIES];
+        g_history.head = last->offset + last->size;
+        g_history.next_frame = g_history.cursor + 1;
+        g_history.force_keyframe = true;
+        g_history.scrubbed = false;
+    }
+    else if (paused && g_history.count > 0)
+    {
+        g_history.cursor = g_history.next_frame - 1;
+    }
+
+    g_history.paused = paused;
+    history_update_title();
+}
+
+/**
+ * Shows the pause and scrub state in the window title.
+ */
+static void history_update_title(void)
+{
+    if (!g_window)
+    {
+        return;
+    }
+
+    if (!g_history.paused || g_history.count == 0)
+    {
+        SDL_SetWindowTitle(g_window, g_history.paused ? WINDOW_TITLE " (paused)" : WINDOW_TITLE);
+        return;
+    }
+
+    char title[128];
+    const Uint32 oldest = g_history.entries[g_history.first].frame;
+    snprintf(title, sizeof(title), WINDOW_TITLE " (paused at frame %u of %u-%u)",
+             g_history.cursor, oldest, oldest + (Uint32)g_history.count - 1);
+    SDL_SetWindowTitle(g_window, title);
+}
+
+/**
+ * Handles keyboard controls for morphing and for pausing and scrubbing the
+ * rewind history. M cycles through the loaded shapes and the lattice, C
+ * cycles through the colour modes, Space pauses or resumes, Left/Right step
+ * backward/forward a recorded frame (ten with Shift), Home/End jump to the
+ * oldest/newest recorded frame.
+ *
+ * @param event SDL key event to process
+ */
+static void handle_key_event(const SDL_Event *event)
+{
+    if (event->type == SDL_KEYDOWN && event->key.keysym.sym == SDLK_m && g_morph.shape_count > 0)
+    {
+        const InputCommand command = {
+            INPUT_MORPH, g_morph.shape + 1 < g_morph.shape_count ? g_morph.shape + 1 : -1, 0, 0};
+        recorder_log_input(&command);
+        lockstep_log_input(&command);
+        apply_input_command(&command);
+        return;
+    }
+
+    if (event->type == SDL_KEYDOWN && event->key.keysym.sym == SDLK_c)
+    {
+        g_color_mode = (ColorMode)((g_color_mode + 1) % COLOR_MODE_COUNT);
+        return;
+    }
+
+    if (event->type != SDL_KEYDOWN || !g_history.enabled)
+    {
+        return;
+    }
+
+    const Uint32 stride = (event->key.keysym.mod & KMOD_SHIFT) ? HISTORY_SCRUB_FAST_FRAMES : 1;
+
+    switch (event->key.keysym.sym)
+    {
+    case SDLK_SPACE:
+        history_set_paused(!g_history.paused);
+        return;
+
+    case SDLK_LEFT:
+    case SDLK_RIGHT:
+    case SDLK_HOME:
+    case SDLK_END:
+        break;
+
+    default:
+        return;
+    }
+
+    if (!g_history.paused)
+    {
+        history_set_paused(true);
+    }
+
+    history_wait();
+    if (g_history.count == 0)
+    {
+        return;
+    }
+
+    const Uint32 oldest = g_history.entries[g_history.first].frame;
+    const Uint32 newest = oldest + (Uint32)g_history.count - 1;
+    Uint32 frame = g_history.cursor;
+
+    switch (event->key.keysym.sym)
+    {
+    case SDLK_LEFT:
+        frame = frame >= oldest + stride ? frame - stride : oldest;
+        break;
+    case SDLK_RIGHT:
+        frame = frame + stride <= newest ? frame + stride : newest;
+        break;
+    case SDLK_HOME:
+        frame = oldest;
+        break;
+    default:
+        frame = newest;
+        break;
+    }
+
+    history_seek(frame);
+    history_update_title();
+}
+
+/**
+ * Re-samples the drag position from the freshest input just before the frame
+ * is rendered, so the dragged dot is not displayed a frame behind the mouse.
+ * The latch is recorded as an input command so replays reproduce it.
+ */
+static void late_latch_drag(void)
+{
+    if (!g_late_latch || !g_drag_state.is_dragging)
+    {
+        return;
+    }
+
+#ifdef __EMSCRIPTEN__
+    if (g_pointer_ring.active)
+    {
+        Sint32 x;
+        Sint32 y;
+        Uint64 input_counter;
+        if (pointer_ring_peek_move(&x, &y, &input_counter))
+        {
+            const InputCommand command = {.type = INPUT_LATCH, .x = x, .y = y};
+            recorder_log_input(&command);
+            lockstep_log_input(&command);
+            apply_input_command(&command);
+            latency_note_input(input_counter, x, y);
+        }
+        return;
+    }
+#endif
+
+    /* Motion that arrived since the event stage is left queued for the next frame */
+    SDL_PumpEvents();
+
+    SDL_Event motion[64];
+    const int count = SDL_PeepEvents(motion, SDL_arraysize(motion), SDL_PEEKEVENT, SDL_MOUSEMOTION, SDL_MOUSEMOTION);
+    if (count <= 0)
+    {
+        return;
+    }
+
+    const SDL_MouseMotionEvent *latest = &motion[count - 1].motion;
+    const View *view = view_for_window(latest->windowID);
+    const InputCommand command = {
+        .type = INPUT_LATCH, .x = latest->x - view->offset_x, .y = latest->y - view->offset_y};
+    recorder_log_input(&command);
+    lockstep_log_input(&command);
+    apply_input_command(&command);
+
+    latency_note_input(latency_event_time(&motion[count - 1], (Uint32)count - 1, false), command.x, command.y);
+}
+
+/**
+ * Returns the performance counter value at which an input event was generated.
+ * Injected events carry an exact stamp; real SDL events only have a
+ * millisecond timestamp, which is converted.
+ *
+ * @param event Event to look up
+ * @param queued_ahead Number of motion events queued before this one
+ * @param consume Whether the event is being removed from the queue
+ * @return Performance counter value of the event
+ */
+static Uint64 latency_event_time(const SDL_Event *event, Uint32 queued_ahead, bool consume)
+{
+    if (g_injector.active)
+    {
+        Uint64 stamp = 0;
+        SDL_LockMutex(g_injector.lock);
+        if (g_injector.head - g_injector.tail > queued_ahead)
+        {
+            stamp = g_injector.stamps[(g_injector.tail + queued_ahead) % LATENCY_INJECT_QUEUE];
+            if (consume)
+            {
+                g_injector.tail++;
+            }
+        }
+        SDL_UnlockMutex(g_injector.lock);
+        if (stamp)
+        {
+            return stamp;
+        }
+    }
+
+    const Uint64 now = SDL_GetPerformanceCounter();
+    const Uint64 age_ms = SDL_GetTicks() - event->common.timestamp;
+    return now - age_ms * SDL_GetPerformanceFrequency() / 1000;
+}
+
+/**
+ * Notes that the current frame consumed a drag sample.
+ *
+ * @param input_counter Performance counter value when the sample was generated
+ * @param x Position the sample moved the dragged dot to
+ * @param y Position the sample moved the dragged dot to
+ */
+static void latency_note_input(Uint64 input_counter, Sint32 x, Sint32 y)
+{
+    if (g_latency.pending)
+    {
+        g_latency.coalesced++;
+    }
+
+    g_latency.pending = true;
+    g_latency.input_counter = input_counter;
+    g_latency.consume_counter = SDL_GetPerformanceCounter();
+    g_latency.consume_frame = g_recorder.frame;
+    g_latency.x = x;
+    g_latency.y = y;
+}
+
+/**
+ * Records the input-to-present latency of the drag sample shown by the frame
+ * that was just presented, and optionally checks that its pixel changed.
+ */
+static void latency_record_present(void)
+{
+    if (!g_latency.pending)
+    {
+        return;
+    }
+
+    const double ms_per_tick = 1000.0 / (double)SDL_GetPerformanceFrequency();
+    const Uint64 present_counter = SDL_GetPerformanceCounter();
+    const float latency_ms = (float)((double)(present_counter - g_latency.input_counter) * ms_per_tick);
+    const float queue_ms = (float)((double)(g_latency.consume_counter - g_latency.input_counter) * ms_per_tick);
+
+    g_recorder.frames[g_recorder.frame % RECORDER_FRAMES].latency_ms = latency_ms;
+    g_latency.latency_ms[g_latency.samples % LATENCY_MAX_SAMPLES] = latency_ms;
+    g_latency.queue_ms[g_latency.samples % LATENCY_MAX_SAMPLES] = queue_ms;
+    g_latency.samples++;
+    g_latency.pending = false;
+
+    if (g_latency.verify_pixels)
+    {
+        Uint32 pixel = 0;
+        const SDL_Rect rect = {(int)((g_latency.x + g_view.offset_x) * g_view.pixel_scale_x),
+                               (int)((g_latency.y + g_view.offset_y) * g_view.pixel_scale_y), 1, 1};
+        const Uint32 background = (Uint32)BACKGROUND_COLOR_A << 24 | (Uint32)BACKGROUND_COLOR_R << 16 |
+                                  (Uint32)BACKGROUND_COLOR_G << 8 | BACKGROUND_COLOR_B;
+        if (SDL_RenderReadPixels(g_renderer, &rect, SDL_PIXELFORMAT_ARGB8888, &pixel, sizeof(pixel)) == 0 &&
+            pixel != background)
+        {
+            g_latency.verified++;
+        }
+        else
+        {
+            g_latency.missed++;
+        }
+    }
+}
+
+/**
+ * Prints the latency of the drag samples presented since the last report,
+ * once per STATS_INTERVAL_MS while dragging.
+ */
+static void latency_report(void)
+{
+    const Uint32 now = SDL_GetTicks();
+    if (!g_latency.periodic_report || now - g_latency.last_report < STATS_INTERVAL_MS)
+    {
+        return;
+    }
+
+    if (g_latency.samples > 0)
+    {
+        char label[64];
+        snprintf(label, sizeof(label), "Input-to-present (late latch %s)", g_late_latch ? "on" : "off");
+        latency_print_distribution(label, g_latency.latency_ms, g_latency.samples, false);
+    }
+
+    g_latency.samples = 0;
+    g_latency.coalesced = 0;
+    g_latency.last_report = now;
+}
+
+/**
+ * Comparison function for sorting latencies.
+ */
+static int compare_floats(const void *a, const void *b)
+{
+    const float lhs = *(const float *)a;
+    const float rhs = *(const float *)b;
+    return (lhs > rhs) - (lhs < rhs);
+}
+
+/**
+ * Prints percentiles of a latency sample ring, and optionally a histogram.
+ *
+ * @param label Name of the measured interval
+ * @param values Sample ring of LATENCY_MAX_SAMPLES entries
+ * @param count Number of samples written to the ring
+ * @param histogram Whether to print a histogram as well
+ */
+static void latency_print_distribution(const char *label, const float *values, Uint32 count, bool histogram)
+{
+    static float sorted[LATENCY_MAX_SAMPLES];
+    const Uint32 n = count < LATENCY_MAX_SAMPLES ? count : LATENCY_MAX_SAMPLES;
+    if (n == 0)
+    {
+        return;
+    }
+
+    memcpy(sorted, values, n * sizeof(float));
+    qsort(sorted, n, sizeof(float), compare_floats);
+
+    double sum = 0.0;
+    for (Uint32 i = 0; i < n; i++)
+    {
+        sum += sorted[i];
+    }
+
+    printf("%s: mean %.2f, p50 %.2f, p90 %.2f, p99 %.2f, max %.2f ms (%u samples)\n",
+           label, sum / n, sorted[n / 2], sorted[n * 90 / 100], sorted[n * 99 / 100], sorted[n - 1], n);
+
+    if (!histogram)
+    {
+        return;
+    }
+
+    Uint32 bins[LATENCY_HISTOGRAM_BINS] = {0};
+    Uint32 largest = 0;
+    for (Uint32 i = 0; i < n; i++)
+    {
+        int bin = (int)(sorted[i] / LATENCY_HISTOGRAM_BIN_MS);
+        bin = bin < LATENCY_HISTOGRAM_BINS ? bin : LATENCY_HISTOGRAM_BINS - 1;
+        bins[bin]++;
+        largest = SDL_max(largest, bins[bin]);
+    }
+
+    for (int bin = 0; bin < LATENCY_HISTOGRAM_BINS; bin++)
+    {
+        if (bins[bin] == 0)
+        {
+            continue;
+        }
+        printf("  %5.1f-%-5.1f%s ms %6u ", bin * LATENCY_HISTOGRAM_BIN_MS, (bin + 1) * LATENCY_HISTOGRAM_BIN_MS,
+               bin == LATENCY_HISTOGRAM_BINS - 1 ? "+" : " ", bins[bin]);
+        for (Uint32 bar = 0; bar < bins[bin] * 40 / largest; bar++)
+        {
+            putchar('#');
+        }
+        putchar('\n');
+    }
+}
+
+/**
+ * Injector thread: pushes mouse motion around a circle at LATENCY_INJECT_HZ,
+ * stamping each event as it is queued.
+ *
+ * @param data Unused
+ * @return 0
+ */
+static int latency_injector_thread(void *data)
+{
+    (void)data;
+    const Uint64 start = SDL_GetPerformanceCounter();
+    const double frequency = (double)SDL_GetPerformanceFrequency();
+
+    while (!SDL_AtomicGet(&g_injector.quit))
+    {
+        const double seconds = (double)(SDL_GetPerformanceCounter() - start) / frequency;
+        const double angle = seconds * 2.0 * M_PI;
+
+        SDL_Event event = {0};
+        event.type = SDL_MOUSEMOTION;
+        event.motion.x = g_injector.center_x + (Sint32)lrint(LATENCY_INJECT_RADIUS * cos(angle));
+        event.motion.y = g_injector.center_y + (Sint32)lrint(LATENCY_INJECT_RADIUS * sin(angle));
+
+        SDL_LockMutex(g_injector.lock);
+        if (g_injector.head - g_injector.tail < LATENCY_INJECT_QUEUE)
+        {
+            g_injector.stamps[g_injector.head % LATENCY_INJECT_QUEUE] = SDL_GetPerformanceCounter();
+            if (SDL_PushEvent(&event) == 1)
+            {
+                g_injector.head++;
+            }
+        }
+        SDL_UnlockMutex(g_injector.lock);
+
+        SDL_Delay(1000 / LATENCY_INJECT_HZ);
+    }
+    return 0;
+}
+
+/**
+ * Headless input-to-present benchmark: renders with the software renderer into
+ * an offscreen surface, grabs the centre dot and drags it in a circle with
+ * synthetic mouse events, then reports the latency distributions.
+ * Must be called after init_simulation() with no window or renderer.
+ *
+ * @param frames Number of frames to run
+ * @return EXIT_SUCCESS on success, EXIT_FAILURE on error
+ */
+static int run_latency_benchmark(int frames)
+{
+    SDL_Surface *surface = SDL_CreateRGBSurfaceWithFormat(0, WINDOW_WIDTH, WINDOW_HEIGHT, 32, SDL_PIXELFORMAT_ARGB8888);
+    g_renderer = surface ? SDL_CreateSoftwareRenderer(surface) : NULL;
+    g_injector.lock = SDL_CreateMutex();
+    if (!g_renderer || !g_injector.lock)
+    {
+        fprintf(stderr, "Software renderer creation failed: %s\n", SDL_GetError());
+        SDL_FreeSurface(surface);
+        return EXIT_FAILURE;
+    }
+
+    const Dot *target = dot_at(g_grid_rows / 2, g_grid_cols / 2);
+    g_injector.center_x = (int)target->x;
+    g_injector.center_y = (int)target->y;
+
+    SDL_Event grab = {0};
+    grab.type = SDL_MOUSEBUTTONDOWN;
+    grab.button.button = SDL_BUTTON_LEFT;
+    grab.button.x = g_injector.center_x;
+    grab.button.y = g_injector.center_y;
+    SDL_PushEvent(&grab);
+
+    g_latency.periodic_report = false;
+    g_latency.verify_pixels = true;
+    g_injector.active = true;
+    g_injector.thread = SDL_CreateThread(latency_injector_thread, "injector", NULL);
+    if (!g_injector.thread)
+    {
+        fprintf(stderr, "Injector thread creation failed: %s\n", SDL_GetError());
+        SDL_DestroyRenderer(g_renderer);
+        SDL_FreeSurface(surface);
+        return EXIT_FAILURE;
+    }
+
+    for (int frame = 0; frame < frames && g_running; frame++)
+    {
+        main_loop();
+        SDL_Delay(FRAME_DELAY_MS);
+    }
+
+    SDL_AtomicSet(&g_injector.quit, 1);
+    SDL_WaitThread(g_injector.thread, NULL);
+
+    printf("Latency benchmark: %d frames, %dx%d grid, software renderer, %d Hz input, late latch %s\n",
+           frames, g_grid_rows, g_grid_cols, LATENCY_INJECT_HZ, g_late_latch ? "on" : "off");
+
+    static float present_ms[LATENCY_MAX_SAMPLES];
+    const Uint32 n = g_latency.samples < LATENCY_MAX_SAMPLES ? g_latency.samples : LATENCY_MAX_SAMPLES;
+    for (Uint32 i = 0; i < n; i++)
+    {
+        present_ms[i] = g_latency.latency_ms[i] - g_latency.queue_ms[i];
+    }
+
+    latency_print_distribution("Input to consume", g_latency.queue_ms, g_latency.samples, false);
+    latency_print_distribution("Consume to present", present_ms, g_latency.samples, false);
+    latency_print_distribution("Input to present", g_latency.latency_ms, g_latency.samples, true);
+    printf("Injected %u events, %u superseded before present; pixel check: %u changed, %u missed\n",
+           g_injector.head, g_latency.coalesced, g_latency.verified, g_latency.missed);
+
+    g_injector.active = false;
+    SDL_DestroyMutex(g_injector.lock);
+    render_shutdown();
+    dynres_shutdown();
+    SDL_DestroyRenderer(g_renderer);
+    g_renderer = NULL;
+    SDL_FreeSurface(surface);
+    return g_latency.samples > 0 ? EXIT_SUCCESS : EXIT_FAILURE;
+}
+
+/**
+ * Draws the sheet once into an offscreen renderer and times the CPU-side
+ * build of vertices or raster, the submission to the renderer and the
+ * present. The points backend draws while it builds, so all of its time
+ * counts as submission.
+ *
+ * @param renderer Offscreen SDL renderer
+ * @param state Buffers and textures of the backend, prepared
+ * @param view View of the offscreen target
+ * @param stage_ms Output, build, submit and present time of the frame
+ */
+static void render_bench_frame(SDL_Renderer *renderer, RenderState *state, const View *view,
+                               double stage_ms[RENDER_BENCH_STAGES])
+{
+    const double ms_per_tick = 1000.0 / (double)SDL_GetPerformanceFrequency();
+    const Uint64 start = SDL_GetPerformanceCounter();
+    if (state->backend != RENDER_POINTS)
+    {
+        render_build(state, view, NULL);
+    }
+    const Uint64 built = SDL_GetPerformanceCounter();
+
+    SDL_SetRenderDrawColor(renderer, BACKGROUND_COLOR_R, BACKGROUND_COLOR_G, BACKGROUND_COLOR_B, BACKGROUND_COLOR_A);
+    SDL_RenderClear(renderer);
+    if (state->backend == RENDER_POINTS)
+    {
+        render_build(state, view, renderer);
+    }
+    else
+    {
+        render_submit(renderer, state, view);
+    }
+    const Uint64 submitted = SDL_GetPerformanceCounter();
+
+    SDL_RenderPresent(renderer);
+    const Uint64 presented = SDL_GetPerformanceCounter();
+
+    stage_ms[0] = (double)(built - start) * ms_per_tick;
+    stage_ms[1] = (double)(submitted - built) * ms_per_tick;
+    stage_ms[2] = (double)(presented - submitted) * ms_per_tick;
+}
+
+/**
+ * Prints one backend's row of the render benchmark.
+ *
+ * @param name Backend name
+ * @param stage_ms Build, submit and present time summed over the frames, negative for a stage the backend lacks
+ * @param max_ms Slowest frame
+ * @param cpu_ms Process CPU time over the frames
+ * @param frames Frames drawn
+ * @param dots Visible dots summed over the frames
+ */
+static void render_bench_report(const char *name, const double stage_ms[RENDER_BENCH_STAGES], double max_ms,
+                                double cpu_ms, int frames, double dots)
+{
+    double total_ms = 0.0;
+    printf("%-9s", name);
+    for (int stage = 0; stage < RENDER_BENCH_STAGES; stage++)
+    {
+        if (stage_ms[stage] < 0.0)
+        {
+            printf(" %10s", "-");
+            continue;
+        }
+        printf(" %10.3f", stage_ms[stage] / frames);
+        total_ms += stage_ms[stage];
+    }
+    dots = dots > 0.0 ? dots : 1.0;
+    printf(" %10.3f %10.3f %10.1f %10.1f\n", total_ms / frames, max_ms, total_ms * 1e6 / dots, cpu_ms * 1e6 / dots);
+}
+
+/**
+ * Replays recorded position frames through every render backend into an
+ * offscreen software renderer, so render cost is measured without the
+ * physics. The frames come from a flight recorder dump, from the --script
+ * input, or from dragging the centre dot in a circle. The physics runs once,
+ * untimed, to capture them; every backend then draws the same frames.
+ * Must be called after init_simulation() with no window or renderer.
+ *
+ * @param path Flight recorder dump to take the frames from, or NULL
+ * @return EXIT_SUCCESS on success, EXIT_FAILURE on error
+ */
+static int run_render_benchmark(const char *path)
+{
+    RecordingHeader header = {0};
+    FrameRecord *records = NULL;
+    const bool scripted = !path && g_script.frames > 0;
+    int frames = scripted ? (int)g_script.frames : RENDER_BENCH_FRAMES;
+    if (path)
+    {
+        records = recording_load(path, &header, true);
+        if (!records)
+        {
+            return EXIT_FAILURE;
+        }
+        frames = (int)header.frame_count;
+    }
+
+    /* Keep as many frames as fit the memory limit */
+    const size_t dot_count = (size_t)g_grid_rows * (size_t)g_grid_cols;
+    const size_t frame_bytes = dot_count * sizeof(Dot);
+    const size_t fit = ((size_t)RENDER_BENCH_MEMORY_MB << 20) / frame_bytes;
+    if ((size_t)frames > fit)
+    {
+        frames = fit > 0 ? (int)fit : 1;
+    }
+
+    Dot *positions = frames > 0 ? malloc((size_t)frames * frame_bytes) : NULL;
+    if (!positions)
+    {
+        fprintf(stderr, "No frames to draw\n");
+        free(records);
+        return EXIT_FAILURE;
+    }
+
+    const Dot *center = dot_at(g_grid_rows / 2, g_grid_cols / 2);
+    const float center_x = center->x;
+    const float center_y = center->y;
+    if (!path && !scripted)
+    {
+        const InputCommand grab = {INPUT_GRAB, (Sint32)center_x, (Sint32)center_y, 0};
+        apply_input_command(&grab);
+    }
+
+    const float margin = DOT_RADIUS + 1.0f;
+    double visible = 0.0;
+    for (int frame = 0; frame < frames; frame++)
+    {
+        if (path)
+        {
+            const FrameRecord *record = &records[frame];
+            for (Uint32 input = 0; input < record->input_count; input++)
+            {
+                if (record->inputs[input].type == INPUT_STEP)
+                {
+                    update_physics();
+                }
+                else
+                {
+                    apply_input_command(&record->inputs[input]);
+                }
+            }
+        }
+        else if (scripted)
+        {
+            script_play_frame(&g_script);
+            for (int substep = 0; substep < g_substeps; substep++)
+            {
+                update_physics();
+            }
+        }
+        else
+        {
+            const double angle = 2.0 * M_PI * frame / RENDER_BENCH_DRAG_PERIOD;
+            const InputCommand move = {INPUT_MOVE, (Sint32)(center_x + RENDER_BENCH_DRAG_RADIUS * cos(angle)),
+                                       (Sint32)(center_y + RENDER_BENCH_DRAG_RADIUS * sin(angle)), 0};
+            apply_input_command(&move);
+            for (int substep = 0; substep < g_substeps; substep++)
+            {
+                update_physics();
+            }
+        }
+
+        memcpy(positions + (size_t)frame * dot_count, g_dots, frame_bytes);
+        for (size_t i = 0; i < dot_count; i++)
+        {
+            visible += g_dots[i].x >= -margin && g_dots[i].x <= WINDOW_WIDTH + margin && g_dots[i].y >= -margin &&
+                       g_dots[i].y <= WINDOW_HEIGHT + margin;
+        }
+    }
+    free(records);
+
+    SDL_Surface *surface = SDL_CreateRGBSurfaceWithFormat(0, WINDOW_WIDTH, WINDOW_HEIGHT, 32, SDL_PIXELFORMAT_ARGB8888);
+    SDL_Renderer *renderer = surface ? SDL_CreateSoftwareRenderer(surface) : NULL;
+    if (!renderer)
+    {
+        fprintf(stderr, "Software renderer creation failed: %s\n", SDL_GetError());
+        SDL_FreeSurface(surface);
+        free(positions);
+        return EXIT_FAILURE;
+    }
+    const View view = {.width = WINDOW_WIDTH, .height = WINDOW_HEIGHT, .pixel_scale_x = 1.0f, .pixel_scale_y = 1.0f};
+
+    printf("Render benchmark: %d frames of a %dx%d grid from %s, %.0f of %zu dots visible per frame,\n"
+           "%s colours, %dx%d software renderer offscreen\n",
+           frames, g_grid_rows, g_grid_cols, path ? path : scripted ? g_script.name : "a circular drag",
+           visible / frames, dot_count,
+           k_color_mode_names[g_color_mode], WINDOW_WIDTH, WINDOW_HEIGHT);
+    printf("%-9s %10s %10s %10s %10s %10s %10s %10s\n", "backend", "build ms", "submit ms", "present ms", "total ms",
+           "max ms", "ns/dot", "cpu ns/dot");
+
+    for (int backend = 0; backend < RENDER_BACKEND_COUNT; backend++)
+    {
+        RenderState state = {.backend = (RenderBackend)backend};
+#ifndef HAS_RENDER_GEOMETRY
+        if (backend == RENDER_GEOMETRY || backend == RENDER_SPRITE)
+        {
+            printf("%-9s needs SDL 2.0.18 or newer\n", k_render_backend_names[backend]);
+            continue;
+        }
+#endif
+        if (!render_prepare(renderer, &state, &view) || state.backend != (RenderBackend)backend)
+        {
+            printf("%-9s could not be set up\n", k_render_backend_names[backend]);
+            render_state_free(&state);
+            continue;
+        }
+
+        /* The first frame creates buffers and textures, so it is drawn once untimed */
+        double frame_ms[RENDER_BENCH_STAGES];
+        memcpy(g_dots, positions, frame_bytes);
+        render_bench_frame(renderer, &state, &view, frame_ms);
+
+        double stage_ms[RENDER_BENCH_STAGES] = {0.0, 0.0, 0.0};
+        double max_ms = 0.0;
+        const clock_t cpu_start = clock();
+        for (int frame = 0; frame < frames; frame++)
+        {
+            memcpy(g_dots, positions + (size_t)frame * dot_count, frame_bytes);
+            render_bench_frame(renderer, &state, &view, frame_ms);
+            max_ms = SDL_max(max_ms, frame_ms[0] + frame_ms[1] + frame_ms[2]);
+            for (int stage = 0; stage < RENDER_BENCH_STAGES; stage++)
+            {
+                stage_ms[stage] += frame_ms[stage];
+            }
+        }
+        const double cpu_ms = (double)(clock() - cpu_start) * 1000.0 / CLOCKS_PER_SEC;
+
+        if (backend == RENDER_POINTS)
+        {
+            stage_ms[0] = -1.0;
+        }
+        render_bench_report(k_render_backend_names[backend], stage_ms, max_ms, cpu_ms, frames, visible);
+        render_state_free(&state);
+    }
+
+#ifdef HAS_TERMINAL_VIEW
+    /* The terminal backend builds escape sequences and writes them to a null device */
+    FILE *sink = fopen("/dev/null", "wb");
+    if (sink && terminal_resize())
+    {
+        const double ms_per_tick = 1000.0 / (double)SDL_GetPerformanceFrequency();
+        double stage_ms[RENDER_BENCH_STAGES] = {0.0, -1.0, 0.0};
+        double max_ms = 0.0;
+        size_t bytes = 0;
+        const clock_t cpu_start = clock();
+        for (int frame = 0; frame < frames; frame++)
+        {
+            memcpy(g_dots, positions + (size_t)frame * dot_count, frame_bytes);
+            const Uint64 start = SDL_GetPerformanceCounter();
+            terminal_render();
+            const Uint64 built = SDL_GetPerformanceCounter();
+            fwrite(g_terminal.output, 1, g_terminal.output_length, sink);
+            fflush(sink);
+            const Uint64 presented = SDL_GetPerformanceCounter();
+
+            stage_ms[0] += (double)(built - start) * ms_per_tick;
+            stage_ms[2] += (double)(presented - built) * ms_per_tick;
+            max_ms = SDL_max(max_ms, (double)(presented - start) * ms_per_tick);
+            bytes += g_terminal.output_length;
+        }
+        const double cpu_ms = (double)(clock() - cpu_start) * 1000.0 / CLOCKS_PER_SEC;
+
+        render_bench_report("terminal", stage_ms, max_ms, cpu_ms, frames, visible);
+        printf("terminal: %dx%d cells, %.0f bytes per frame\n", g_terminal.cols, g_terminal.rows,
+               (double)bytes / frames);
+        free(g_terminal.cells);
+        free(g_terminal.previous);
+        free(g_terminal.output);
+        memset(&g_terminal, 0, sizeof(g_terminal));
+    }
+    if (sink)
+    {
+        fclose(sink);
+    }
+#endif
+
+    SDL_DestroyRenderer(renderer);
+    SDL_FreeSurface(surface);
+    free(positions);
+    return EXIT_SUCCESS;
+}
+
+/**
+ * Returns the next number of a splitmix64 sequence, so a seed always
+ * generates the same script on every platform.
+ *
+ * @param state Generator state, advanced
+ * @return Uniform 32-bit number
+ */
+static Uint32 stress_random(Uint64 *state)
+{
+    Uint64 z = (*state += 0x9E3779B97F4A7C15ull);
+    z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ull;
+    z = (z ^ (z >> 27)) * 0x94D049BB133111EBull;
+    return (Uint32)((z ^ (z >> 31)) >> 32);
+}
+
+/**
+ * Returns a uniform integer in [low, high].
+ *
+ * @param state Generator state, advanced
+ * @param low Smallest value
+ * @param high Largest value
+ * @return The number
+ */
+static int stress_range(Uint64 *state, int low, int high)
+{
+    return low + (int)(stress_random(state) % (Uint32)(high - low + 1));
+}
+
+/**
+ * Appends formatted text to a generated script.
+ *
+ * @param text Script buffer of STRESS_SCRIPT_BYTES
+ * @param length In: bytes used; out: bytes used after appending
+ * @param format printf format
+ * @return true if the text fitted
+ */
+static bool stress_append(char *text, size_t *length, const char *format, ...)
+{
+    va_list args;
+    va_start(args, format);
+    const int written = vsnprintf(text + *length, STRESS_SCRIPT_BYTES - *length, format, args);
+    va_end(args);
+    if (written < 0 || (size_t)written >= STRESS_SCRIPT_BYTES - *length)
+    {
+        text[*length] = '\0';
+        return false;
+    }
+    *length += (size_t)written;
+    return true;
+}
+
+/**
+ * Writes the adversarial input script of a seed: violent shakes, many
+ * touches pulled apart at once, the sheet stretched to the window corners,
+ * fast flicks and rapid grab/release, in random order until the script
+ * lasts STRESS_SCRIPT_MS.
+ *
+ * @param seed Seed
+ * @param text Output buffer of STRESS_SCRIPT_BYTES
+ * @return true on success, false if the script did not fit
+ */
+static bool stress_generate(Uint32 seed, char *text)
+{
+    Uint64 state = seed;
+    size_t length = 0;
+    int elapsed_ms = 0;
+    bool ok = stress_append(text, &length, "# --stress-bench seed %u\n", seed);
+
+    while (ok && elapsed_ms < STRESS_SCRIPT_MS)
+    {
+        /* A random dot of the rest lattice */
+        float x, y;
+        lattice_position(stress_range(&state, 0, g_grid_rows - 1), stress_range(&state, 0, g_grid_cols - 1), &x, &y);
+
+        switch (stress_random(&state) % 5)
+        {
+        case 0:
+        {
+            /* Shake one dot hard and fast */
+            const int amplitude_x = stress_range(&state, -400, 400);
+            const int amplitude_y = stress_range(&state, -400, 400);
+            const int period_ms = stress_range(&state, 16, 50);
+            const int shakes = stress_range(&state, 5, 30);
+            ok = stress_append(text, &length, "grab %d %d\nrepeat %d\n  move %d %d %d\n  move %d %d %d\nend\nrelease\n",
+                               (int)x, (int)y, shakes, (int)x + amplitude_x, (int)y + amplitude_y, period_ms,
+                               (int)x - amplitude_x, (int)y - amplitude_y, period_ms);
+            elapsed_ms += shakes * 2 * period_ms;
+            break;
+        }
+
+        case 1:
+        {
+            /* Grab many dots at once and pull them toward random points of the window */
+            const int touches = stress_range(&state, 2, TOUCH_MAX_POINTS);
+            const int pull_ms = stress_range(&state, 50, 500);
+            const int hold_ms = stress_range(&state, 0, 500);
+            for (int touch = 0; ok && touch < touches; touch++)
+            {
+                lattice_position(stress_range(&state, 0, g_grid_rows - 1), stress_range(&state, 0, g_grid_cols - 1),
+                                 &x, &y);
+                ok = stress_append(text, &length, "touch %d down %d %d\n", touch, (int)x, (int)y);
+            }
+            ok = ok && stress_append(text, &length, "parallel\n");
+            for (int touch = 0; ok && touch < touches; touch++)
+            {
+                ok = stress_append(text, &length, "  touch %d move %d %d %d\n", touch,
+                                   stress_range(&state, 0, WINDOW_WIDTH), stress_range(&state, 0, WINDOW_HEIGHT),
+                                   pull_ms);
+            }
+            ok = ok && stress_append(text, &length, "end\nwait %d\n", hold_ms);
+            for (int touch = 0; ok && touch < touches; touch++)
+            {
+                ok = stress_append(text, &length, "touch %d up\n", touch);
+            }
+            elapsed_ms += pull_ms + hold_ms;
+            break;
+        }
+
+        case 2:
+        {
+            /* Stretch the bottom corners and the centre to the window corners */
+            float left_x, left_y, right_x, right_y, centre_x, centre_y;
+            lattice_position(g_grid_rows - 1, 0, &left_x, &left_y);
+            lattice_position(g_grid_rows - 1, g_grid_cols - 1, &right_x, &right_y);
+            lattice_position(g_grid_rows / 2, g_grid_cols / 2, &centre_x, &centre_y);
+            const int pull_ms = stress_range(&state, 100, 1000);
+            const int hold_ms = stress_range(&state, 100, 800);
+            ok = stress_append(text, &length,
+                               "touch 0 down %d %d\ntouch 1 down %d %d\ntouch 2 down %d %d\nparallel\n"
+                               "  touch 0 move 0 %d %d\n  touch 1 move %d %d %d\n  touch 2 move %d 0 %d\nend\n"
+                               "wait %d\ntouch 0 up\ntouch 1 up\ntouch 2 up\n",
+                               (int)left_x, (int)left_y, (int)right_x, (int)right_y, (int)centre_x, (int)centre_y,
+                               WINDOW_HEIGHT, pull_ms, WINDOW_WIDTH, WINDOW_HEIGHT, pull_ms, WINDOW_WIDTH / 2,
+                               pull_ms, hold_ms);
+            elapsed_ms += pull_ms + hold_ms;
+            break;
+        }
+
+        case 3:
+        {
+            /* Flick a dot across the window */
+            const int flick_ms = stress_range(&state, 16, 100);
+            ok = stress_append(text, &length, "brush %d %d %d %d %d\n", flick_ms, (int)x, (int)y,
+                               stress_range(&state, 0, WINDOW_WIDTH), stress_range(&state, 0, WINDOW_HEIGHT));
+            elapsed_ms += flick_ms;
+            break;
+        }
+
+        default:
+        {
+            /* Grab, jerk and release every other frame */
+            const int jerks = stress_range(&state, 5, 40);
+            ok = stress_append(text, &length, "repeat %d\n  grab %d %d\n  move %d %d\n  wait 16\n  release\n"
+                               "  wait 16\nend\n",
+                               jerks, (int)x, (int)y, (int)x + stress_range(&state, -200, 200),
+                               (int)y + stress_range(&state, -200, 200));
+            elapsed_ms += jerks * 32;
+            break;
+        }
+        }
+
+        const int pause_ms = stress_range(&state, 0, 200);
+        ok = ok && stress_append(text, &length, "wait %d\n", pause_ms);
+        elapsed_ms += pause_ms;
+    }
+    return ok;
+}
+
+/**
+ * Prints the mean and tail percentiles of per-frame times.
+ *
+ * @param label Name of the measured time
+ * @param values Times in ms; sorted in place
+ * @param count Number of times
+ */
+static void stress_print_distribution(const char *label, float *values, size_t count)
+{
+    qsort(values, count, sizeof(float), compare_floats);
+    double sum = 0.0;
+    for (size_t i = 0; i < count; i++)
+    {
+        sum += values[i];
+    }
+    printf("%-7s %9.3f %9.3f %9.3f %9.3f %9.3f\n", label, sum / count, values[count / 2], values[count * 99 / 100],
+           values[count * 999 / 1000], values[count - 1]);
+}
+
+/**
+ * Orders stress results from the slowest worst frame down.
+ */
+static int compare_stress_results(const void *a, const void *b)
+{
+    const StressResult *lhs = a;
+    const StressResult *rhs = b;
+    return (lhs->worst_ms < rhs->worst_ms) - (lhs->worst_ms > rhs->worst_ms);
+}
+
+/**
+ * Runs the adversarial scripts of a range of seeds headlessly from the rest
+ * lattice, stepping the physics and drawing each frame into an offscreen
+ * software renderer with the selected backend. Reports the tail of the
+ * step and render times over every frame and writes the scripts of the
+ * worst seeds to disk, for --replay and --script.
+ * Must be called after init_simulation() with no window or renderer.
+ *
+ * @param seeds Number of seeds
+ * @param first_seed First seed
+ * @return EXIT_SUCCESS on success, EXIT_FAILURE on error
+ */
+static int run_stress_benchmark(int seeds, Uint32 first_seed)
+{
+    const int frames = (int)script_frames(STRESS_SCRIPT_MS);
+    const size_t samples = (size_t)seeds * (size_t)frames;
+    float *step_ms = malloc(samples * sizeof(float));
+    float *render_ms = malloc(samples * sizeof(float));
+    float *frame_ms = malloc(samples * sizeof(float));
+    StressResult *results = malloc((size_t)seeds * sizeof(StressResult));
+    char *text = malloc(STRESS_SCRIPT_BYTES);
+    SDL_Surface *surface = SDL_CreateRGBSurfaceWithFormat(0, WINDOW_WIDTH, WINDOW_HEIGHT, 32, SDL_PIXELFORMAT_ARGB8888);
+    SDL_Renderer *renderer = surface ? SDL_CreateSoftwareRenderer(surface) : NULL;
+    const View view = {.width = WINDOW_WIDTH, .height = WINDOW_HEIGHT, .pixel_scale_x = 1.0f, .pixel_scale_y = 1.0f};
+    RenderState state = {.backend = g_render.backend};
+    double stage_ms[RENDER_BENCH_STAGES];
+
+    bool ok = step_ms && render_ms && frame_ms && results && text && renderer &&
+              render_prepare(renderer, &state, &view);
+    if (!ok)
+    {
+        fprintf(stderr, "Stress benchmark setup failed: %s\n", SDL_GetError());
+    }
+    else
+    {
+        /* The first frame creates buffers and textures, so it is drawn once untimed */
+        render_bench_frame(renderer, &state, &view, stage_ms);
+    }
+
+    const double ms_per_tick = 1000.0 / (double)SDL_GetPerformanceFrequency();
+    for (int i = 0; ok && i < seeds; i++)
+    {
+        const Uint32 seed = first_seed + (Uint32)i;
+        Script script;
+        char name[64];
+        snprintf(name, sizeof(name), STRESS_SEED_PATTERN, seed);
+        if (!stress_generate(seed, text) || !script_compile(text, name, &script))
+        {
+            fprintf(stderr, "Seed %u did not generate a valid script\n", seed);
+            ok = false;
+            break;
+        }
+
+        initialize_grid();
+        g_drag_state = (DragState){.is_dragging = false, .row = -1, .col = -1};
+        results[i] = (StressResult){.seed = seed};
+        for (int frame = 0; frame < frames; frame++)
+        {
+            script_play_frame(&script);
+            const Uint64 start = SDL_GetPerformanceCounter();
+            for (int substep = 0; substep < g_substeps; substep++)
+            {
+                update_physics();
+            }
+            const size_t sample = (size_t)i * (size_t)frames + (size_t)frame;
+            step_ms[sample] = (float)((double)(SDL_GetPerformanceCounter() - start) * ms_per_tick);
+            render_bench_frame(renderer, &state, &view, stage_ms);
+            render_ms[sample] = (float)(stage_ms[0] + stage_ms[1] + stage_ms[2]);
+            frame_ms[sample] = step_ms[sample] + render_ms[sample];
+
+            if (frame_ms[sample] > results[i].worst_ms)
+            {
+                results[i] = (StressResult){seed, frame, frame_ms[sample], step_ms[sample], render_ms[sample]};
+            }
+        }
+        script_free(&script);
+    }
+
+    if (ok)
+    {
+        printf("Stress benchmark: seeds %u-%u, %d frames each, %dx%d grid, %d steps per frame, %s physics,\n"
+               "%s renderer into an offscreen %dx%d software renderer\n",
+               first_seed, first_seed + (Uint32)seeds - 1, frames, g_grid_rows, g_grid_cols, g_substeps,
+               k_physics_mode_names[g_physics_mode], k_render_backend_names[state.backend], WINDOW_WIDTH,
+               WINDOW_HEIGHT);
+        printf("%-7s %9s %9s %9s %9s %9s   (ms over %zu frames)\n", "", "mean", "p50", "p99", "p99.9", "max",
+               samples);
+        stress_print_distribution("step", step_ms, samples);
+        stress_print_distribution("render", render_ms, samples);
+        stress_print_distribution("frame", frame_ms, samples);
+
+        /* Keep the scripts of the worst seeds as regression cases */
+        qsort(results, (size_t)seeds, sizeof(StressResult), compare_stress_results);
+        printf("Worst seeds:\n%10s %9s %9s %9s %6s  %s\n", "seed", "frame ms", "step ms", "render ms", "frame",
+               "script");
+        for (int i = 0; i < SDL_min(seeds, STRESS_SAVED_SEEDS); i++)
+        {
+            char path[64];
+            snprintf(path, sizeof(path), STRESS_SEED_PATTERN, results[i].seed);
+            stress_generate(results[i].seed, text);
+            FILE *file = fopen(path, "wb");
+            const bool saved = file && fputs(text, file) >= 0;
+            if (file)
+            {
+                fclose(file);
+            }
+            printf("%10u %9.3f %9.3f %9.3f %6d  %s\n", results[i].seed, results[i].worst_ms, results[i].step_ms,
+                   results[i].render_ms, results[i].frame, saved ? path : "(not saved)");
+        }
+    }
+
+    render_state_free(&state);
+    SDL_DestroyRenderer(renderer);
+    SDL_FreeSurface(surface);
+    free(step_ms);
+    free(render_ms);
+    free(frame_ms);
+    free(results);
+    free(text);
+    return ok ? EXIT_SUCCESS : EXIT_FAILURE;
+}
+
+/**
+ * Fills a sheet with the rest lattice, anchors its top corners like
+ * initialize_grid() does, and sets every dot moving in a fixed pattern so
+ * all springs stay stretched.
+ *
+ * @param sheet Sheet to fill
+ */
+static void sheet_init(const Sheet *sheet)
+{
+    for (int row = 0; row < sheet->rows; row++)
+    {
+        for (int col = 0; col < sheet->cols; col++)
+        {
+            const float x = (float)(col * SPRING_REST_LENGTH);
+            const float y = (float)(row * SPRING_REST_LENGTH);
+            const int pattern = (row * 31 + col * 17) % 13 - 6;
+            *sheet_dot(sheet, row, col) = (Dot){
+                .x = x, .y = y, .vx = 0.5f * pattern, .vy = -0.25f * pattern, .original_x = x, .original_y = y};
+        }
+    }
+    sheet_dot(sheet, 0, 0)->fixed = true;
+    sheet_dot(sheet, 0, sheet->cols - 1)->fixed = true;
+}
+
+/**
+ * Steps a sheet once with the float step.
+ *
+ * @param sheet Sheet to step
+ */
+static void sheet_step(const Sheet *sheet)
+{
+    physics_integrate_rows(sheet, 0, sheet->rows);
+    physics_spring_rows(sheet, 0, sheet->rows);
+}
+
+/**
+ * Body of a scaling benchmark thread: prepares its own memory, so it is
+ * first touched by the thread that uses it, then waits for the start signal
+ * and runs its share of the work.
+ */
+static int scaling_worker(void *data)
+{
+    ScalingTask *task = data;
+
+    switch (task->kind)
+    {
+    case SCALING_STEP:
+        sheet_init(&task->sheet);
+        break;
+    case SCALING_STREAM:
+        for (size_t i = 0; i < task->count; i++)
+        {
+            task->a[i] = 0.0f;
+            task->b[i] = 1.0f;
+            task->c[i] = 2.0f;
+        }
+        break;
+    default:
+        break;
+    }
+
+    SDL_AtomicAdd(&task->gate->ready, 1);
+    while (!SDL_AtomicGet(&task->gate->go))
+    {
+        /* Spin, so every thread starts within microseconds of the others */
+    }
+
+    switch (task->kind)
+    {
+    case SCALING_STEP:
+        for (int step = 0; step < task->repeats; step++)
+        {
+            sheet_step(&task->sheet);
+        }
+        break;
+
+    case SCALING_STREAM:
+    {
+        const float scale = 3.0f;
+        for (int repeat = 0; repeat < task->repeats; repeat++)
+        {
+            for (size_t i = 0; i < task->count; i++)
+            {
+                task->a[i] = task->b[i] + scale * task->c[i];
+            }
+        }
+        break;
+    }
+
+    case SCALING_COMPUTE:
+    {
+        /* Independent multiply-add chains, so the probe is limited by throughput rather than latency */
+        float chains[SCALING_COMPUTE_CHAINS];
+        for (int i = 0; i < SCALING_COMPUTE_CHAINS; i++)
+        {
+            chains[i] = task->seed + (float)i;
+        }
+        for (int repeat = 0; repeat < task->repeats; repeat++)
+        {
+            for (int i = 0; i < SCALING_COMPUTE_CHAINS; i++)
+            {
+                chains[i] = chains[i] * 0.999999f + 0.000001f;
+            }
+        }
+        float sum = 0.0f;
+        for (int i = 0; i < SCALING_COMPUTE_CHAINS; i++)
+        {
+            sum += chains[i];
+        }
+        task->seed = sum; /* Keeps the loop from being optimised away */
+        break;
+    }
+    }
+    return 0;
+}
+
+/**
+ * Runs one scaling benchmark task per thread, all released at once.
+ *
+ * @param tasks Tasks, each with its gate set to the same gate
+ * @param count Number of tasks
+ * @return Wall time from the start signal until every thread finished, in ms, or -1 on error
+ */
+static double scaling_run(ScalingTask *tasks, int count)
+{
+    ScalingGate gate;
+    SDL_AtomicSet(&gate.ready, 0);
+    SDL_AtomicSet(&gate.go, 0);
+
+    SDL_Thread *threads[SCALING_MAX_THREADS];
+    int started = 0;
+    for (int i = 0; i < count; i++)
+    {
+        tasks[i].gate = &gate;
+        threads[i] = SDL_CreateThread(scaling_worker, "scaling", &tasks[i]);
+        if (!threads[i])
+        {
+            break;
+        }
+        started++;
+    }
+
+    while (SDL_AtomicGet(&gate.ready) < started)
+    {
+        SDL_Delay(1);
+    }
+    const Uint64 start = SDL_GetPerformanceCounter();
+    SDL_AtomicSet(&gate.go, 1);
+    for (int i = 0; i < started; i++)
+    {
+        SDL_WaitThread(threads[i], NULL);
+    }
+    const Uint64 end = SDL_GetPerformanceCounter();
+
+    if (started < count)
+    {
+        fprintf(stderr, "Could not start %d threads: %s\n", count, SDL_GetError());
+        return -1.0;
+    }
+    return (double)(end - start) * 1000.0 / (double)SDL_GetPerformanceFrequency();
+}
+
+/**
+ * Measures memory bandwidth with a STREAM-style triad, a[i] = b[i] + s * c[i],
+ * over SCALING_STREAM_FLOATS floats per array split across the threads.
+ * Counts 12 bytes per element, as STREAM does, and keeps the best run.
+ *
+ * @param threads Number of threads
+ * @return Bandwidth in GB/s, or 0 on error
+ */
+static double scaling_stream_probe(int threads)
+{
+    float *arrays = malloc((size_t)SCALING_STREAM_FLOATS * 3 * sizeof(float));
+    if (!arrays)
+    {
+        return 0.0;
+    }
+
+    ScalingTask tasks[SCALING_MAX_THREADS];
+    const size_t share = SCALING_STREAM_FLOATS / (size_t)threads;
+    for (int i = 0; i < threads; i++)
+    {
+        const size_t first = share * (size_t)i;
+        tasks[i] = (ScalingTask){
+            .kind = SCALING_STREAM,
+            .a = arrays + first,
+            .b = arrays + SCALING_STREAM_FLOATS + first,
+            .c = arrays + 2 * (size_t)SCALING_STREAM_FLOATS + first,
+            .count = share,
+            .repeats = 1};
+    }
+
+    double best_ms = 0.0;
+    for (int run = 0; run < SCALING_STREAM_RUNS; run++)
+    {
+        const double ms = scaling_run(tasks, threads);
+        if (ms <= 0.0)
+        {
+            free(arrays);
+            return 0.0;
+        }
+        best_ms = run == 0 ? ms : SDL_min(best_ms, ms);
+    }
+
+    free(arrays);
+    return 12.0 * (double)share * threads / (best_ms * 1e6);
+}
+
+/**
+ * Measures peak multiply-add throughput, 2 flops per multiply-add.
+ *
+ * @param threads Number of threads
+ * @return Throughput in GFLOP/s, or 0 on error
+ */
+static double scaling_compute_probe(int threads)
+{
+    ScalingTask tasks[SCALING_MAX_THREADS];
+    for (int i = 0; i < threads; i++)
+    {
+        tasks[i] = (ScalingTask){.kind = SCALING_COMPUTE, .repeats = SCALING_COMPUTE_REPEATS, .seed = (float)i};
+    }
+
+    const double ms = scaling_run(tasks, threads);
+    return ms > 0.0 ? 2.0 * SCALING_COMPUTE_CHAINS * (double)SCALING_COMPUTE_REPEATS * threads / (ms * 1e6) : 0.0;
+}
+
+/**
+ * Steps one sheet per thread and prints a row of a scaling table, with the
+ * step's place on the roofline for this thread count.
+ *
+ * @param threads Number of threads
+ * @param rows Rows of each thread's sheet; the last one gets what is left
+ * @param total_rows Rows of all sheets together
+ * @param cols Columns of every sheet
+ * @param steps Steps each thread runs
+ * @param base_rate Dots stepped per second with one thread, or 0 if this is that run
+ * @param probes Bandwidth and compute probes for this thread count
+ * @return Dots stepped per second, or 0 on error
+ */
+static double scaling_measure(int threads, int rows, int total_rows, int cols, int steps, double base_rate,
+                              const ScalingProbes *probes)
+{
+    ScalingTask tasks[SCALING_MAX_THREADS];
+    bool allocated = true;
+    for (int i = 0; i < threads; i++)
+    {
+        const int sheet_rows = SDL_max(0, SDL_min(rows, total_rows - i * rows));
+        Dot *dots = malloc((size_t)SDL_max(sheet_rows, 1) * (size_t)cols * sizeof(Dot));
+        tasks[i] = (ScalingTask){.kind = SCALING_STEP, .sheet = {dots, sheet_rows, cols, &g_physics_params},
+                                 .repeats = steps};
+        allocated &= dots != NULL;
+    }
+
+    const double ms = allocated ? scaling_run(tasks, threads) : -1.0;
+    for (int i = 0; i < threads; i++)
+    {
+        free(tasks[i].sheet.dots);
+    }
+    if (ms <= 0.0)
+    {
+        fprintf(stderr, "Could not step %d sheets of %dx%d\n", threads, rows, cols);
+        return 0.0;
+    }
+
+    const double dots = (double)total_rows * cols;
+    const double step_ms = ms / steps;
+    const double rate = dots * 1000.0 / step_ms;
+    const double speedup = base_rate > 0.0 ? rate / base_rate : 1.0;
+    const double gbytes = rate * SCALING_BYTES_PER_DOT / 1e9;
+    const double gflops = rate * SCALING_FLOPS_PER_DOT / 1e9;
+    const double intensity = (double)SCALING_FLOPS_PER_DOT / SCALING_BYTES_PER_DOT;
+    const double roof = SDL_min(probes->gflops, intensity * probes->gbytes);
+
+    /* Faster than the triad means the sheets live in cache, where the DRAM roof does not apply */
+    const char *bound = gbytes > probes->gbytes                      ? "cache"
+                        : intensity * probes->gbytes < probes->gflops ? "memory"
+                                                                      : "compute";
+    printf("%7d %11.0f %9.3f %9.1f %8.2f %9.0f%% %8.1f %8.2f %6.0f%%  %s\n", threads, dots, step_ms, rate / 1e6,
+           speedup, 100.0 * speedup / threads, gbytes, gflops, 100.0 * gflops / roof, bound);
+    return rate;
+}
+
+/**
+ * Benchmarks how the float step scales with threads. The step pushes both
+ * dots of every spring, so threads cannot share a sheet; the work is split
+ * into independent sheets, one per thread, instead. Weak scaling gives every
+ * thread a whole sheet. Strong scaling divides a fixed sheet into row bands
+ * stepped as separate sheets, a proxy for a parallel step that leaves out
+ * the springs across band boundaries. Each thread count also gets a
+ * STREAM-style bandwidth probe and a multiply-add probe, and every row shows
+ * the achieved bandwidth and flop rate against the roofline they define.
+ *
+ * @param max_threads Largest thread count
+ * @param rows Rows of the sheet
+ * @param cols Columns of the sheet
+ * @return EXIT_SUCCESS, or EXIT_FAILURE on error
+ */
+static int run_scaling_benchmark(int max_threads, int rows, int cols)
+{
+    max_threads = SDL_min(max_threads, SCALING_MAX_THREADS);
+
+    int counts[SCALING_MAX_THREADS];
+    int count_total = 0;
+    for (int threads = 1; threads < max_threads; threads *= 2)
+    {
+        counts[count_total++] = threads;
+    }
+    counts[count_total++] = max_threads;
+
+    /* Calibrate the steps so the one-thread runs take about SCALING_TARGET_MS */
+    const Sheet sheet = {malloc((size_t)rows * (size_t)cols * sizeof(Dot)), rows, cols, &g_physics_params};
+    if (!sheet.dots)
+    {
+        fprintf(stderr, "Could not allocate a %dx%d sheet\n", rows, cols);
+        return EXIT_FAILURE;
+    }
+    sheet_init(&sheet);
+    sheet_step(&sheet);
+    const Uint64 start = SDL_GetPerformanceCounter();
+    sheet_step(&sheet);
+    const double calibration_ms =
+        (double)(SDL_GetPerformanceCounter() - start) * 1000.0 / (double)SDL_GetPerformanceFrequency();
+    free(sheet.dots);
+    const int steps = (int)SDL_max(2.0, SDL_min(SCALING_MAX_STEPS, SCALING_TARGET_MS / SDL_max(calibration_ms, 1e-3)));
+
+    printf("Scaling benchmark: %dx%d sheet, %d to %d threads, %d steps per run, %d CPUs\n", rows, cols, 1,
+           max_threads, steps, SDL_GetCPUCount());
+    printf("Roofline model: %d flops and %d bytes per dot step, %.2f flop/byte\n\n", SCALING_FLOPS_PER_DOT,
+           (int)SCALING_BYTES_PER_DOT, (double)SCALING_FLOPS_PER_DOT / SCALING_BYTES_PER_DOT);
+
+    ScalingProbes probes[SCALING_MAX_THREADS];
+    printf("%7s %12s %12s %14s\n", "threads", "triad GB/s", "peak GFLOP/s", "ridge flop/B");
+    for (int i = 0; i < count_total; i++)
+    {
+        probes[i].gbytes = scaling_stream_probe(counts[i]);
+        probes[i].gflops = scaling_compute_probe(counts[i]);
+        if (probes[i].gbytes <= 0.0 || probes[i].gflops <= 0.0)
+        {
+            fprintf(stderr, "Probes failed with %d threads\n", counts[i]);
+            return EXIT_FAILURE;
+        }
+        printf("%7d %12.1f %12.1f %14.2f\n", counts[i], probes[i].gbytes, probes[i].gflops,
+               probes[i].gflops / probes[i].gbytes);
+    }
+
+    static const char *const header = "%7s %11s %9s %9s %8s %10s %8s %8s %7s  %s\n";
+    for (int weak = 0; weak < 2; weak++)
+    {
+        if (weak)
+        {
+            printf("\nWeak scaling: one %dx%d sheet per thread\n", rows, cols);
+        }
+        else
+        {
+            printf("\nStrong scaling (proxy): the %dx%d sheet split into independent row bands, one per thread; "
+                   "springs across bands are skipped\n",
+                   rows, cols);
+        }
+        printf(header, "threads", "dots", "ms/step", "Mdots/s", "speedup", "efficiency", "GB/s", "GFLOP/s", "roof",
+               "bound");
+
+        double base_rate = 0.0;
+        for (int i = 0; i < count_total; i++)
+        {
+            const int threads = counts[i];
+            const int sheet_rows = weak ? rows : (rows + threads - 1) / threads;
+            const int total_rows = weak ? rows * threads : rows;
+            const double rate =
+                scaling_measure(threads, sheet_rows, total_rows, cols, steps, base_rate, &probes[i]);
+            if (rate <= 0.0)
+            {
+                return EXIT_FAILURE;
+            }
+            if (i == 0)
+            {
+                base_rate = rate;
+            }
+        }
+    }
+
+    const ScalingProbes *last = &probes[count_total - 1];
+    const double intensity = (double)SCALING_FLOPS_PER_DOT / SCALING_BYTES_PER_DOT;
+    printf("\nWith %d threads the ridge point is %.2f flop/byte: a sheet too large for the caches is %s-bound, "
+           "at most %.1f GFLOP/s.\n",
+           max_threads, last->gflops / last->gbytes, intensity * last->gbytes < last->gflops ? "memory" : "compute",
+           SDL_min(last->gflops, intensity * last->gbytes));
+    return EXIT_SUCCESS;
+}
+
+/**
+ * Measures how far a sheet is from rest.
+ *
+ * @param sheet Sheet to measure
+ * @param distance Output, farthest any dot is from its rest position, infinite once a dot is not finite
+ * @param speed Output, fastest any dot moves, px/step
+ * @param strain Output, most any spring is stretched or compressed, as a fraction of its rest length
+ */
+static void sheet_measure(const Sheet *sheet, float *distance, float *speed, float *strain)
+{
+    float distance_squared = 0.0f;
+    float speed_squared = 0.0f;
+    *strain = 0.0f;
+
+    for (int row = 0; row < sheet->rows; row++)
+    {
+        for (int col = 0; col < sheet->cols; col++)
+        {
+            const Dot *dot = sheet_dot(sheet, row, col);
+            if (!isfinite(dot->x) || !isfinite(dot->y) || !isfinite(dot->vx) || !isfinite(dot->vy))
+            {
+                *distance = INFINITY;
+                *speed = INFINITY;
+                return;
+            }
+
+            const float dx = dot->x - dot->original_x;
+            const float dy = dot->y - dot->original_y;
+            distance_squared = SDL_max(distance_squared, dx * dx + dy * dy);
+            speed_squared = SDL_max(speed_squared, dot->vx * dot->vx + dot->vy * dot->vy);
+
+            /* The springs to the right and down, so each is measured once */
+            for (int neighbour = 0; neighbour < 2; neighbour++)
+            {
+                const int other_row = row + neighbour;
+                const int other_col = col + 1 - neighbour;
+                if (other_row >= sheet->rows || other_col >= sheet->cols)
+                {
+                    continue;
+                }
+                const Dot *other = sheet_dot(sheet, other_row, other_col);
+                const float rest = spring_rest_length(dot, other);
+                const float length = hypotf(other->x - dot->x, other->y - dot->y);
+                *strain = SDL_max(*strain, fabsf(length - rest) / rest);
+            }
+        }
+    }
+    *distance = sqrtf(distance_squared);
+    *speed = sqrtf(speed_squared);
+}
+
+/**
+ * Plays a script on a sheet of the live grid's size with one sweep
+ * configuration, then keeps stepping until the sheet is back at rest, it
+ * diverges, or SWEEP_SETTLE_LIMIT_MS pass.
+ *
+ * @param script Compiled script
+ * @param dots Dots of the sheet, g_grid_rows * g_grid_cols
+ * @param result Configuration to run, filled with how it did
+ */
+static void sweep_run(const Script *script, Dot *dots, SweepResult *result)
+{
+    const Sheet sheet = {dots, g_grid_rows, g_grid_cols, &result->params};
+    const Uint32 last_frame = script->frames + script_frames(SWEEP_SETTLE_LIMIT_MS);
+    DragState drag = {.is_dragging = false, .row = -1, .col = -1};
+    Uint64 step_ticks = 0;
+    Uint32 frame = 0;
+    int next = 0;
+
+    sheet_rest(&sheet);
+    result->stable = true;
+    result->settle_frames = -1;
+    result->peak_strain = 0.0f;
+    while (frame < last_frame)
+    {
+        while (next < script->count && script->events[next].frame <= frame)
+        {
+            sheet_apply_input(&sheet, &drag, &script->events[next++].command);
+        }
+        const Uint64 start = SDL_GetPerformanceCounter();
+        for (int substep = 0; substep < result->substeps; substep++)
+        {
+            sheet_step(&sheet);
+        }
+        step_ticks += SDL_GetPerformanceCounter() - start;
+        frame++;
+
+        float distance, speed, strain;
+        sheet_measure(&sheet, &distance, &speed, &strain);
+        if (distance > SWEEP_BLOWUP_DISTANCE)
+        {
+            result->stable = false;
+            break;
+        }
+        result->peak_strain = SDL_max(result->peak_strain, strain);
+        if (next == script->count && frame >= script->frames && distance < SWEEP_SETTLE_DISTANCE &&
+            speed * result->substeps < SWEEP_SETTLE_SPEED)
+        {
+            result->settle_frames = (int)(frame - script->frames);
+            break;
+        }
+    }
+    result->frame_ms = (double)step_ticks * 1000.0 / (double)SDL_GetPerformanceFrequency() / frame;
+}
+
+/**
+ * Body of a parameter sweep thread: runs configurations from the shared
+ * queue on a sheet of its own until none are left.
+ */
+static int sweep_worker(void *data)
+{
+    SweepQueue *queue = data;
+    Dot *dots = malloc((size_t)g_grid_rows * (size_t)g_grid_cols * sizeof(Dot));
+    if (!dots)
+    {
+        return -1;
+    }
+
+    for (int i = SDL_AtomicAdd(&queue->next, 1); i < queue->count; i = SDL_AtomicAdd(&queue->next, 1))
+    {
+        sweep_run(queue->script, dots, &queue->results[i]);
+        SDL_AtomicAdd(&queue->done, 1);
+    }
+    free(dots);
+    return 0;
+}
+
+/**
+ * Orders passing sweep configurations from the cheapest: fewest steps per
+ * frame, then quickest to settle.
+ */
+static int compare_sweep_results(const void *a, const void *b)
+{
+    const SweepResult *lhs = *(const SweepResult *const *)a;
+    const SweepResult *rhs = *(const SweepResult *const *)b;
+    if (lhs->substeps != rhs->substeps)
+    {
+        return lhs->substeps - rhs->substeps;
+    }
+    return lhs->settle_frames - rhs->settle_frames;
+}
+
+/**
+ * Judges a sweep configuration against the quality constraint.
+ *
+ * @param result Configuration that ran
+ * @param settle_frames Most frames the sheet may take to settle after the script
+ * @param max_strain Most a spring may be stretched or compressed, as a fraction of its rest length
+ * @return "pass", or what it failed on
+ */
+static const char *sweep_verdict(const SweepResult *result, int settle_frames, double max_strain)
+{
+    if (!result->stable)
+    {
+        return "unstable";
+    }
+    if (result->peak_strain > max_strain)
+    {
+        return "stretched";
+    }
+    if (result->settle_frames < 0 || result->settle_frames > settle_frames)
+    {
+        return "unsettled";
+    }
+    return "pass";
+}
+
+/**
+ * Prints one configuration of the parameter sweep.
+ *
+ * @param result Configuration that ran
+ * @param verdict How it did
+ * @param note Trailing note, or ""
+ */
+static void sweep_print_result(const SweepResult *result, const char *verdict, const char *note)
+{
+    char settle[16] = "-";
+    char strain[16] = "-";
+    if (result->settle_frames >= 0)
+    {
+        snprintf(settle, sizeof(settle), "%.0f", result->settle_frames * 1000.0 / SCRIPT_FRAME_RATE);
+    }
+    if (result->stable)
+    {
+        snprintf(strain, sizeof(strain), "%.2f", result->peak_strain);
+    }
+    printf("%9g %8g %9g %8d %9s %7s %9.4f  %s%s\n", result->params.stiffness, result->params.damping,
+           result->params.restoring, result->substeps, settle, strain, result->frame_ms, verdict, note);
+}
+
+/**
+ * Runs the --script input, or a pull on the centre dot, headlessly under
+ * every combination of the sweep's stiffness, damping, restoring and substep
+ * values, one sheet per configuration, spread over threads. Each
+ * configuration is scored on stability, the time the sheet takes to settle
+ * after the script and the most any spring stretches, and the cheapest one
+ * meeting the quality constraint is reported. Uses the float step.
+ * Must be called after init_simulation().
+ *
+ * @param threads Number of threads
+ * @param settle_ms Longest the sheet may take to settle after the script
+ * @param max_strain Most a spring may be stretched or compressed, as a fraction of its rest length
+ * @return EXIT_SUCCESS if a configuration passed, EXIT_FAILURE otherwise
+ */
+static int run_parameter_sweep(int threads, double settle_ms, double max_strain)
+{
+    /* Without a script, pull the centre dot aside and let it go */
+    Script pull = {0};
+    const Script *script = &g_script;
+    if (g_script.count == 0)
+    {
+        char text[SCRIPT_MAX_LINE];
+        float x, y;
+        lattice_position(g_grid_rows / 2, g_grid_cols / 2, &x, &y);
+        snprintf(text, sizeof(text), "grab %d %d\nmove %d %d 300\nwait 500\nrelease\n", (int)x, (int)y,
+                 (int)x + SWEEP_PULL, (int)y + SWEEP_PULL / 2);
+        if (!script_compile(text, "a pull on the centre dot", &pull))
+        {
+            return EXIT_FAILURE;
+        }
+        script = &pull;
+    }
+
+    /* The current configuration first, then every combination of the sweep values */
+    const int count = 1 + (int)(SDL_arraysize(k_sweep_stiffness) * SDL_arraysize(k_sweep_damping) *
+                                SDL_arraysize(k_sweep_restoring) * SDL_arraysize(k_sweep_substeps));
+    SweepResult *results = malloc((size_t)count * sizeof(SweepResult));
+    const SweepResult **passed = malloc((size_t)count * sizeof(SweepResult *));
+    if (!results || !passed)
+    {
+        fprintf(stderr, "Could not allocate %d sweep configurations\n", count);
+        free(results);
+        free(passed);
+        script_free(&pull);
+        return EXIT_FAILURE;
+    }
+    results[0] = (SweepResult){.params = g_physics_params, .substeps = g_substeps};
+    int index = 1;
+    for (size_t substeps = 0; substeps < SDL_arraysize(k_sweep_substeps); substeps++)
+    {
+        for (size_t stiffness = 0; stiffness < SDL_arraysize(k_sweep_stiffness); stiffness++)
+        {
+            for (size_t damping = 0; damping < SDL_arraysize(k_sweep_damping); damping++)
+            {
+                for (size_t restoring = 0; restoring < SDL_arraysize(k_sweep_restoring); restoring++)
+                {
+                    results[index++] = (SweepResult){
+                        .params = {k_sweep_stiffness[stiffness], k_sweep_damping[damping],
+                                   k_sweep_restoring[restoring]},
+                        .substeps = k_sweep_substeps[substeps]};
+                }
+            }
+        }
+    }
+
+    SweepQueue queue = {.script = script, .results = results, .count = count};
+    SDL_AtomicSet(&queue.next, 0);
+    SDL_AtomicSet(&queue.done, 0);
+    SDL_Thread *workers[SWEEP_MAX_THREADS];
+    threads = SDL_max(1, SDL_min(SDL_min(threads, SWEEP_MAX_THREADS), count));
+    const Uint64 start = SDL_GetPerformanceCounter();
+    int started = 0;
+    for (int i = 0; i < threads; i++)
+    {
+        workers[started] = SDL_CreateThread(sweep_worker, "sweep", &queue);
+        started += workers[started] != NULL;
+    }
+    for (int i = 0; i < started; i++)
+    {
+        SDL_WaitThread(workers[i], NULL);
+    }
+    const double elapsed_s = (double)(SDL_GetPerformanceCounter() - start) / (double)SDL_GetPerformanceFrequency();
+
+    if (SDL_AtomicGet(&queue.done) < count)
+    {
+        fprintf(stderr, "The sweep did not finish: %s\n", started ? "out of memory" : SDL_GetError());
+        free(results);
+        free(passed);
+        script_free(&pull);
+        return EXIT_FAILURE;
+    }
+
+    /* Score every configuration against the constraint */
+    const int settle_frames = (int)script_frames(settle_ms);
+    int unstable = 0;
+    int stretched = 0;
+    int unsettled = 0;
+    int pass_count = 0;
+    for (int i = 1; i < count; i++)
+    {
+        const char *verdict = sweep_verdict(&results[i], settle_frames, max_strain);
+        unstable += strcmp(verdict, "unstable") == 0;
+        stretched += strcmp(verdict, "stretched") == 0;
+        unsettled += strcmp(verdict, "unsettled") == 0;
+        if (strcmp(verdict, "pass") == 0)
+        {
+            passed[pass_count++] = &results[i];
+        }
+    }
+    qsort(passed, (size_t)pass_count, sizeof(SweepResult *), compare_sweep_results);
+
+    printf("Parameter sweep: %d configurations of a %dx%d grid on %d threads in %.1f s, playing %s\n"
+           "(%u frames, then up to %.0f ms to settle), float physics\n",
+           count, g_grid_rows, g_grid_cols, started, elapsed_s, script->name, script->frames, SWEEP_SETTLE_LIMIT_MS);
+    printf("Constraint: stable, no spring stretched or compressed by more than %.0f%%, settled within %.0f ms "
+           "of the end\n",
+           max_strain * 100.0, settle_ms);
+    printf("%d unstable, %d stretched, %d unsettled, %d pass\n\n", unstable, stretched, unsettled, pass_count);
+    printf("%9s %8s %9s %8s %9s %7s %9s  %s\n", "stiffness", "damping", "restoring", "substeps", "settle ms",
+           "strain", "ms/frame", "verdict");
+    sweep_print_result(&results[0], sweep_verdict(&results[0], settle_frames, max_strain), " (current)");
+    for (int i = 0; i < SDL_min(pass_count, SWEEP_SHOWN); i++)
+    {
+        sweep_print_result(passed[i], "pass", i == 0 ? " (cheapest)" : "");
+    }
+
+    int status = EXIT_FAILURE;
+    if (pass_count > 0)
+    {
+        printf("\nCheapest: --stiffness %g --damping %g --restoring %g --substeps %d\n", passed[0]->params.stiffness,
+               passed[0]->params.damping, passed[0]->params.restoring, passed[0]->substeps);
+        status = EXIT_SUCCESS;
+    }
+    else
+    {
+        printf("\nNo configuration meets the constraint\n");
+    }
+    free(results);
+    free(passed);
+    script_free(&pull);
+    return status;
+}
+
+/**
+ * Main entry point for the Dot Matrix Sheet simulation.
+ * Initializes SDL, creates the window and renderer, runs the main loop,
+ * and cleans up resources on exit.
+ *
+ * @return EXIT_SUCCESS on successful execution, EXIT_FAILURE on error
+ */
+
+/**
+ * Main loop iteration function.
+ * Processes events, updates physics, and renders the frame.
+ * This function is called repeatedly either by the native loop or by Emscripten.
+ */
+static void main_loop(void)
+{
+    SDL_Event event;
+
+    /* The previous step's history encode reads the grid until here */
+    history_wait();
+
+    recorder_begin_frame();
+    Uint64 stage_start = g_recorder.frame_start;
+
+    /* Process all pending events, leaving them queued while a sliced step is in progress */
+    if (!g_slice.active)
+    {
+        drag_samples_begin_frame();
+    }
+#ifdef __EMSCRIPTEN__
+    if (!g_slice.active && g_lockstep.role != LOCKSTEP_NODE)
+    {
+        pointer_ring_drain();
+    }
+#endif
+#ifdef HAS_TERMINAL_VIEW
+    if (g_terminal.active && !g_slice.active)
+    {
+        terminal_poll_input();
+    }
+#endif
+    while (!g_slice.active && SDL_PollEvent(&event))
+    {
+        if (event.type == SDL_QUIT)
+        {
+            g_running = false;
+#ifdef __EMSCRIPTEN__
+            emscripten_cancel_main_loop();
+#endif
+        }
+        else if (event.type == SDL_KEYDOWN)
+        {
+            handle_key_event(&event);
+        }
+        else if (event.type == SDL_WINDOWEVENT)
+        {
+            if (event.window.event == SDL_WINDOWEVENT_SIZE_CHANGED)
+            {
+                view_update(g_window, g_renderer, &g_view);
+                for (int i = 0; i < g_wall.count; i++)
+                {
+                    view_update(g_wall.windows[i].window, g_wall.windows[i].renderer, &g_wall.windows[i].view);
+                }
+            }
+            else if (event.window.event == SDL_WINDOWEVENT_CLOSE && g_wall.count > 0)
+            {
+                g_running = false; /* Closing any wall window ends the session */
+            }
+            else
+            {
+                power_window_event(&event.window);
+            }
+        }
+        else if (g_lockstep.role != LOCKSTEP_NODE)
+        {
+            handle_mouse_event(&event);
+        }
+    }
+
+    /* A script plays one frame per simulated frame */
+    if (!g_slice.active && g_lockstep.role != LOCKSTEP_NODE && !g_history.paused && !g_power.paused &&
+        g_script.frame < g_script.frames)
+    {
+        script_play_frame(&g_script);
+    }
+
+    frame_source_update();
+    stage_start = recorder_end_stage(STAGE_EVENTS, stage_start);
+
+    /* Update physics simulation, recording it while the frame renders */
+    bool stepped = false; /* Only a completed step is recorded into the history */
+#ifdef HAS_LOCKSTEP
+    if (g_lockstep.role == LOCKSTEP_NODE)
+    {
+        const Uint32 followed = g_lockstep.step;
+        lockstep_follow();
+        stepped = g_lockstep.step != followed;
+    }
+    else
+#endif
+    {
+        /* Drag samples are spread over the substeps; a resumed sliced step finishes the previous frame's substep */
+        const int substeps = (g_slice.active || (!g_history.paused && !g_power.paused)) ? g_substeps : 0;
+        for (int substep = 0; substep < substeps; substep++)
+        {
+            const bool resumed = g_slice.active;
+            if (!resumed)
+            {
+                drag_samples_apply(substep, substeps);
+            }
+            if (!physics_step_frame())
+            {
+                break;
+            }
+            stepped = true;
+            recorder_note_step();
+            lockstep_note_step();
+            if (resumed)
+            {
+                break;
+            }
+        }
+        if (!g_slice.active)
+        {
+            drag_samples_flush();
+        }
+    }
+    stage_start = recorder_end_stage(STAGE_PHYSICS, stage_start);
+
+    if (!g_slice.active)
+    {
+        late_latch_drag();
+        if (stepped)
+        {
+            history_submit();
+        }
+    }
+#ifdef HAS_LOCKSTEP
+    lockstep_broadcast();
+#endif
+
+    /* Nothing to draw while every window is hidden */
+    if (g_power.hidden)
+    {
+        recorder_end_frame();
+        return;
+    }
+
+    /* Render frame */
+#ifdef HAS_TERMINAL_VIEW
+    if (g_terminal.active)
+    {
+        terminal_render();
+        stage_start = recorder_end_stage(STAGE_RENDER, stage_start);
+        terminal_present();
+        recorder_end_stage(STAGE_PRESENT, stage_start);
+        recorder_end_frame();
+        return;
+    }
+#endif
+    wall_begin();
+    const bool scaled = dynres_begin(g_renderer);
+    SDL_SetRenderDrawColor(
+        g_renderer,
+        BACKGROUND_COLOR_R,
+        BACKGROUND_COLOR_G,
+        BACKGROUND_COLOR_B,
+        BACKGROUND_COLOR_A);
+    SDL_RenderClear(g_renderer);
+    render_grid(g_renderer);
+    if (scaled)
+    {
+        dynres_end(g_renderer);
+    }
+    wall_end();
+    stage_start = recorder_end_stage(STAGE_RENDER, stage_start);
+
+    SDL_RenderPresent(g_renderer);
+    wall_present();
+    recorder_end_stage(STAGE_PRESENT, stage_start);
+    latency_record_present();
+    dynres_update();
+
+    recorder_end_frame();
+    latency_report();
+}
+
+#ifdef HAS_TERMINAL_VIEW
+/**
+ * Signal handler for the terminal view: notes resizes and interrupts so the
+ * main loop can react outside of signal context.
+ */
+static void terminal_signal_handler(int signal_number)
+{
+    if (signal_number == SIGWINCH)
+    {
+        g_terminal_resized = 1;
+    }
+    else
+    {
+        g_terminal_interrupted = 1;
+    }
+}
+
+/**
+ * Writes a whole buffer to stdout, retrying on partial writes.
+ *
+ * @param data Bytes to write
+ * @param length Number of bytes
+ * @return true if everything was written
+ */
+static bool terminal_write_all(const char *data, size_t length)
+{
+    while (length > 0)
+    {
+        const ssize_t written = write(STDOUT_FILENO, data, length);
+        if (written <= 0)
+        {
+            return false;
+        }
+        data += written;
+        length -= (size_t)written;
+    }
+    return true;
+}
+
+/**
+ * Puts the terminal into raw mode on the alternate screen with mouse
+ * reporting enabled, and sizes the cell buffers.
+ *
+ * @return true on success, false if stdin/stdout is not a terminal
+ */
+static bool terminal_init(void)
+{
+    if (!isatty(STDIN_FILENO) || !isatty(STDOUT_FILENO) || tcgetattr(STDIN_FILENO, &g_terminal.saved_termios) != 0)
+    {
+        fprintf(stderr, "--term needs an interactive terminal\n");
+        return false;
+    }
+
+    struct termios raw = g_terminal.saved_termios;
+    raw.c_iflag &= ~(tcflag_t)(IXON | ICRNL);
+    raw.c_lflag &= ~(tcflag_t)(ICANON | ECHO);
+    raw.c_cc[VMIN] = 0; /* Non-blocking reads */
+    raw.c_cc[VTIME] = 0;
+    tcsetattr(STDIN_FILENO, TCSAFLUSH, &raw);
+
+    signal(SIGWINCH, terminal_signal_handler);
+    signal(SIGINT, terminal_signal_handler);
+    signal(SIGTERM, terminal_signal_handler);
+
+    /* Alternate screen, hidden cursor, button-event mouse tracking in SGR format */
+    static const char enter[] = "\x1b[?1049h\x1b[?25l\x1b[?1002h\x1b[?1006h\x1b[2J";
+    terminal_write_all(enter, sizeof(enter) - 1);
+
+    g_terminal.active = true;
+    if (!terminal_resize())
+    {
+        terminal_shutdown();
+        return false;
+    }
+    return true;
+}
+
+/**
+ * Restores the terminal and frees the cell buffers.
+ */
+static void terminal_shutdown(void)
+{
+    if (!g_terminal.active)
+    {
+        return;
+    }
+
+    static const char leave[] = "\x1b[?1006l\x1b[?1002l\x1b[?25h\x1b[?1049l";
+    terminal_write_all(leave, sizeof(leave) - 1);
+    tcsetattr(STDIN_FILENO, TCSAFLUSH, &g_terminal.saved_termios);
+
+    free(g_terminal.cells);
+    free(g_terminal.previous);
+    free(g_terminal.output);
+    memset(&g_terminal, 0, sizeof(g_terminal));
+}
+
+/**
+ * Sizes the cell buffers to the terminal and fits the window area into them,
+ * keeping the aspect ratio. Forces a full redraw.
+ *
+ * @return true on success, false if allocation failed
+ */
+static bool terminal_resize(void)
+{
+    struct winsize size;
+    int cols = TERMINAL_DEFAULT_COLS;
+    int rows = TERMINAL_DEFAULT_ROWS;
+    if (ioctl(STDOUT_FILENO, TIOCGWINSZ, &size) == 0 && size.ws_col > 0 && size.ws_row > 1)
+    {
+        cols = size.ws_col;
+        rows = size.ws_row;
+    }
+    rows--; /* Status line */
+
+    const size_t cell_count = (size_t)cols * (size_t)rows;
+    /* Worst case per cell: a cursor move and a 3-byte UTF-8 character */
+    const size_t output_capacity = cell_count * 16 + 256;
+    Uint8 *cells = calloc(cell_count, 1);
+    Uint8 *previous = calloc(cell_count, 1);
+    char *output = malloc(output_capacity);
+    if (!cells || !previous || !output)
+    {
+        free(cells);
+        free(previous);
+        free(output);
+        return false;
+    }
+
+    free(g_terminal.cells);
+    free(g_terminal.previous);
+    free(g_terminal.output);
+    g_terminal.cells = cells;
+    g_terminal.previous = previous;
+    g_terminal.output = output;
+    g_terminal.output_capacity = output_capacity;
+    g_terminal.cols = cols;
+    g_terminal.rows = rows;
+
+    const float scale_x = (float)(cols * 2) / WINDOW_WIDTH;
+    const float scale_y = (float)(rows * 4) / WINDOW_HEIGHT;
+    g_terminal.scale = scale_x < scale_y ? scale_x : scale_y;
+    g_terminal.offset_x = (cols * 2 - WINDOW_WIDTH * g_terminal.scale) / 2.0f;
+    g_terminal.offset_y = (rows * 4 - WINDOW_HEIGHT * g_terminal.scale) / 2.0f;
+    g_terminal.full_redraw = true;
+    return true;
+}
+
+/**
+ * Reads pending terminal input without blocking and dispatches complete
+ * key and mouse sequences.
+ */
+static void terminal_poll_input(void)
+{
+    if (g_terminal_interrupted)
+    {
+        g_running = false;
+    }
+    if (g_terminal_resized)
+    {
+        g_terminal_resized = 0;
+        terminal_resize();
+    }
+
+    for (;;)
+    {
+        const ssize_t count = read(STDIN_FILENO, g_terminal.input + g_terminal.input_length,
+                                   sizeof(g_terminal.input) - g_terminal.input_length);
+        if (count <= 0)
+        {
+            break;
+        }
+        g_terminal.input_length += (size_t)count;
+
+        size_t start = 0;
+        while (start < g_terminal.input_length)
+        {
+            const char *sequence = g_terminal.input + start;
+            const size_t available = g_terminal.input_length - start;
+            size_t length = 1;
+
+            if (sequence[0] == '\x1b')
+            {
+                /* CSI sequences end with a byte in 0x40-0x7E */
+                if (available < 2)
+                {
+                    break;
+                }
+                if (sequence[1] == '[')
+                {
+                    length = 2;
+                    while (length < available && (sequence[length] < 0x40 || sequence[length] > 0x7E))
+                    {
+                        length++;
+                    }
+                    if (length == available)
+                    {
+                        /* Incomplete; keep it unless the buffer is full of garbage */
+                        if (start == 0 && available == sizeof(g_terminal.input))
+                        {
+                            start = available;
+                        }
+                        break;
+                    }
+                    length++;
+                }
+            }
+
+            terminal_handle_sequence(sequence, length);
+            start += length;
+        }
+
+        memmove(g_terminal.input, g_terminal.input + start, g_terminal.input_length - start);
+        g_terminal.input_length -= start;
+    }
+}
+
+/**
+ * Handles one key press or SGR mouse report. Mouse positions are mapped from
+ * character cells back to window coordinates; keys are forwarded to the same
+ * handler as SDL key events.
+ *
+ * @param sequence Input bytes
+ * @param length Number of bytes
+ */
+static void terminal_handle_sequence(const char *sequence, size_t length)
+{
+    SDL_Event key = {0};
+    key.type = SDL_KEYDOWN;
+
+    if (length == 1)
+    {
+        if (sequence[0] == 'q')
+        {
+            g_running = false;
+            return;
+        }
+        key.key.keysym.sym = (unsigned char)sequence[0];
+        handle_key_event(&key);
+        return;
+    }
+
+    int button, cell_x, cell_y;
+    char action;
+    if (length > 3 && sequence[2] == '<' &&
+        sscanf(sequence + 3, "%d;%d;%d%c", &button, &cell_x, &cell_y, &action) == 4)
+    {
+        /* Centre of the character cell, in window coordinates */
+        const float x = ((cell_x - 1) * 2 + 1 - g_terminal.offset_x) / g_terminal.scale;
+        const float y = ((cell_y - 1) * 4 + 2 - g_terminal.offset_y) / g_terminal.scale;
+        InputCommand command = {.x = (Sint32)x, .y = (Sint32)y};
+
+        if (action == 'm')
+        {
+            command.type = INPUT_RELEASE;
+        }
+        else if (button == 0)
+        {
+            /* A cell covers several window pixels; snap to the nearest dot within it */
+            const float radius = SDL_max(CLICK_DETECTION_RADIUS, 4.0f / g_terminal.scale);
+            float best = radius * radius;
+            for (int i = 0; i < g_grid_rows * g_grid_cols; i++)
+            {
+                const float dx = g_dots[i].x - x;
+                const float dy = g_dots[i].y - y;
+                if (dx * dx + dy * dy < best)
+                {
+                    best = dx * dx + dy * dy;
+                    command.x = (Sint32)g_dots[i].x;
+                    command.y = (Sint32)g_dots[i].y;
+                }
+            }
+            command.type = INPUT_GRAB;
+        }
+        else if (button == 32 && g_drag_state.is_dragging)
+        {
+            command.type = INPUT_MOVE;
+        }
+        else
+        {
+            return;
+        }
+
+        recorder_log_input(&command);
+        lockstep_log_input(&command);
+        apply_input_command(&command);
+        return;
+    }
+
+    switch (sequence[length - 1])
+    {
+    case 'C':
+        key.key.keysym.sym = SDLK_RIGHT;
+        break;
+    case 'D':
+        key.key.keysym.sym = SDLK_LEFT;
+        break;
+    case 'H':
+        key.key.keysym.sym = SDLK_HOME;
+        break;
+    case 'F':
+        key.key.keysym.sym = SDLK_END;
+        break;
+    default:
+        return;
+    }
+    /* Modified arrows arrive as ESC [ 1 ; 2 C, where 2 means Shift */
+    if (length > 4 && sequence[length - 2] == '2' && sequence[length - 3] == ';')
+    {
+        key.key.keysym.mod = KMOD_SHIFT;
+    }
+    handle_key_event(&key);
+}
+
+/**
+ * Appends formatted text to the terminal output buffer.
+ */
+static void terminal_append(const char *format, ...)
+{
+    va_list args;
+    va_start(args, format);
+    const int length = vsnprintf(g_terminal.output + g_terminal.output_length,
+                                 g_terminal.output_capacity - g_terminal.output_length, format, args);
+    va_end(args);
+    if (length > 0)
+    {
+        g_terminal.output_length = SDL_min(g_terminal.output_length + (size_t)length, g_terminal.output_capacity - 1);
+    }
+}
+
+/**
+ * Rasterizes the dots into Braille cells and builds the escape sequences that
+ * update the cells that changed since the previous frame. The cursor is only
+ * moved when the next changed cell is not the one right after the last write.
+ */
+static void terminal_render(void)
+{
+    /* Bit of each dot within a Braille cell, indexed by [y][x] */
+    static const Uint8 braille_bits[4][2] = {{0x01, 0x08}, {0x02, 0x10}, {0x04, 0x20}, {0x40, 0x80}};
+
+    const int cols = g_terminal.cols;
+    const int rows = g_terminal.rows;
+    const int dots_x = cols * 2;
+    const int dots_y = rows * 4;
+
+    memset(g_terminal.cells, 0, (size_t)cols * (size_t)rows);
+    for (int i = 0; i < g_grid_rows * g_grid_cols; i++)
+    {
+        /* With a frame source, only dots at least half lit are drawn */
+        if (g_dot_colors && g_dot_colors[i].r + g_dot_colors[i].g + g_dot_colors[i].b < 3 * 128)
+        {
+            continue;
+        }
+
+        const int x = (int)floorf(g_dots[i].x * g_terminal.scale + g_terminal.offset_x);
+        const int y = (int)floorf(g_dots[i].y * g_terminal.scale + g_terminal.offset_y);
+        if (x >= 0 && x < dots_x && y >= 0 && y < dots_y)
+        {
+            g_terminal.cells[(y >> 2) * cols + (x >> 1)] |= braille_bits[y & 3][x & 1];
+        }
+    }
+
+    g_terminal.output_length = 0;
+    if (g_terminal.full_redraw)
+    {
+        terminal_append("\x1b[2J");
+    }
+
+    int cursor_row = -1;
+    int cursor_col = -1;
+    for (int row = 0; row < rows; row++)
+    {
+        for (int col = 0; col < cols; col++)
+        {
+            const size_t index = (size_t)row * cols + col;
+            const Uint8 bits = g_terminal.cells[index];
+            if (!g_terminal.full_redraw && bits == g_terminal.previous[index])
+            {
+                continue;
+            }
+            if (g_terminal.full_redraw && bits == 0)
+            {
+                continue; /* Already blank after clearing */
+            }
+
+            if (row != cursor_row || col != cursor_col)
+            {
+                terminal_append("\x1b[%d;%dH", row + 1, col + 1);
+            }
+
+            /* U+2800-U+28FF encoded as UTF-8 */
+            const unsigned int code_point = TERMINAL_BRAILLE_BASE + bits;
+            char *out = g_terminal.output + g_terminal.output_length;
+            out[0] = (char)(0xE0 | (code_point >> 12));
+            out[1] = (char)(0x80 | ((code_point >> 6) & 0x3F));
+            out[2] = (char)(0x80 | (code_point & 0x3F));
+            g_terminal.output_length += 3;
+
+            cursor_row = row;
+            cursor_col = col + 1;
+        }
+    }
+
+    memcpy(g_terminal.previous, g_terminal.cells, (size_t)cols * (size_t)rows);
+    g_terminal.full_redraw = false;
+
+    /* Status line, refreshed a few times per second */
+    const Uint32 now = SDL_GetTicks();
+    g_terminal.status_frames++;
+    if (now - g_terminal.last_status >= TERMINAL_STATUS_INTERVAL_MS)
+    {
+        const FrameRecord *record = &g_recorder.frames[g_recorder.frame % RECORDER_FRAMES];
+        const float seconds = (now - g_terminal.last_status) / 1000.0f;
+        terminal_append("\x1b[%d;1H\x1b[2K%.0f fps  physics %.2f ms  %.0f B/frame", rows + 1,
+                        g_terminal.status_frames / seconds, record->stage_ms[STAGE_PHYSICS],
+                        (float)g_terminal.status_bytes / g_terminal.status_frames);
+        if (g_history.paused)
+        {
+            terminal_append("  paused at frame %u", g_history.cursor);
+        }
+        terminal_append("  (q to quit)");
+        g_terminal.last_status = now;
+        g_terminal.status_frames = 0;
+        g_terminal.status_bytes = 0;
+    }
+}
+
+/**
+ * Writes the frame's terminal updates with a single write.
+ */
+static void terminal_present(void)
+{
+    g_terminal.status_bytes += g_terminal.output_length;
+    terminal_write_all(g_terminal.output, g_terminal.output_length);
+}
+
+/**
+ * Runs the simulation in the terminal until quit.
+ * Must be called after init_simulation().
+ *
+ * @return EXIT_SUCCESS on success, EXIT_FAILURE on error
+ */
+static int run_terminal_view(void)
+{
+    if (!terminal_init())
+    {
+        return EXIT_FAILURE;
+    }
+
+    g_late_latch = false; /* Terminal input is only read once per frame */
+    while (g_running)
+    {
+        main_loop();
+        SDL_Delay(FRAME_DELAY_MS);
+    }
+
+    terminal_shutdown();
+    return EXIT_SUCCESS;
+}
+#endif
+
+/**
+ * Adds an applied input command to the frame sent to lockstep nodes.
+ *
+ * @param command Input command that was applied
+ */
+static void lockstep_log_input(const InputCommand *command)
+{
+    if (g_lockstep.role != LOCKSTEP_COORDINATOR)
+    {
+        return;
+    }
+
+    if (g_lockstep.input_count == LOCKSTEP_INPUTS_PER_FRAME)
+    {
+        g_lockstep.overflowed = true;
+        return;
+    }
+    g_lockstep.inputs[g_lockstep.input_count++] = *command;
+}
+
+/**
+ * Marks that the frame ran a physics step after the inputs logged so far.
+ */
+static void lockstep_note_step(void)
+{
+    if (g_lockstep.role == LOCKSTEP_COORDINATOR)
+    {
+        const InputCommand command = {.type = INPUT_STEP};
+        lockstep_log_input(&command);
+        g_lockstep.step++;
+    }
+}
+
+#ifdef HAS_LOCKSTEP
+/**
+ * Checksums the positions and velocities of every dot, bit for bit. Four
+ * independent FNV-1a lanes keep the pass from being one long dependency chain.
+ *
+ * @return State checksum
+ */
+static Uint32 lockstep_checksum(void)
+{
+    Uint32 lanes[4] = {2166136261u, 2166136261u, 2166136261u, 2166136261u};
+    const size_t dot_count = (size_t)g_grid_rows * g_grid_cols;
+
+    for (size_t i = 0; i < dot_count; i++)
+    {
+        Uint32 bits[4]; /* x, y, vx, vy */
+        memcpy(bits, &g_dots[i].x, sizeof(bits));
+        for (int lane = 0; lane < 4; lane++)
+        {
+            lanes[lane] = (lanes[lane] ^ bits[lane]) * 16777619u;
+        }
+    }
+
+    return lanes[0] ^ (lanes[1] * 3u) ^ (lanes[2] * 5u) ^ (lanes[3] * 7u);
+}
+
+/**
+ * Starts coordinating: listens for nodes on the given TCP port. Nodes are
+ * accepted between frames and start from a snapshot.
+ *
+ * @param port TCP port to listen on
+ * @return true on success, false on error
+ */
+static bool lockstep_serve(int port)
+{
+    const int listen_socket = socket(AF_INET, SOCK_STREAM, 0);
+    if (listen_socket < 0)
+    {
+        perror("Lockstep socket");
+        return false;
+    }
+
+    const int reuse = 1;
+    setsockopt(listen_socket, SOL_SOCKET, SO_REUSEADDR, &reuse, sizeof(reuse));
+
+    struct sockaddr_in address = {0};
+    address.sin_family = AF_INET;
+    address.sin_addr.s_addr = htonl(INADDR_ANY);
+    address.sin_port = htons((Uint16)port);
+    if (bind(listen_socket, (struct sockaddr *)&address, sizeof(address)) < 0 || listen(listen_socket, 4) < 0 ||
+        fcntl(listen_socket, F_SETFL, fcntl(listen_socket, F_GETFL) | O_NONBLOCK) < 0)
+    {
+        perror("Lockstep listen");
+        close(listen_socket);
+        return false;
+    }
+
+    g_lockstep.role = LOCKSTEP_COORDINATOR;
+    g_lockstep.listen_socket = listen_socket;
+    printf("Lockstep: coordinating on port %d\n", port);
+    return true;
+}
+
+/**
+ * Starts following a coordinator: connects, then waits for the snapshot it
+ * sends every new node. Local mouse input is ignored from then on.
+ *
+ * @param address Coordinator as HOST:PORT
+ * @return true on success, false on error
+ */
+static bool lockstep_join(const char *address)
+{
+    char host[256];
+    const char *colon = strrchr(address, ':');
+    if (!colon || colon == address || (size_t)(colon - address) >= sizeof(host))
+    {
+        fprintf(stderr, "Lockstep: expected HOST:PORT, got %s\n", address);
+        return false;
+    }
+    memcpy(host, address, (size_t)(colon - address));
+    host[colon - address] = '\0';
+
+    struct addrinfo hints = {0};
+    struct addrinfo *results = NULL;
+    hints.ai_family = AF_UNSPEC;
+    hints.ai_socktype = SOCK_STREAM;
+    const int error = getaddrinfo(host, colon + 1, &hints, &results);
+    if (error != 0)
+    {
+        fprintf(stderr, "Lockstep: cannot resolve %s: %s\n", host, gai_strerror(error));
+        return false;
+    }
+
+    int connection = -1;
+    for (const struct addrinfo *result = results; result && connection < 0; result = result->ai_next)
+    {
+        connection = socket(result->ai_family, result->ai_socktype, result->ai_protocol);
+        if (connection >= 0 && connect(connection, result->ai_addr, result->ai_addrlen) < 0)
+        {
+            close(connection);
+            connection = -1;
+        }
+    }
+    freeaddrinfo(results);
+    if (connection < 0)
+    {
+        fprintf(stderr, "Lockstep: cannot connect to %s: %s\n", address, strerror(errno));
+        return false;
+    }
+
+    const int no_delay = 1;
+    setsockopt(connection, IPPROTO_TCP, TCP_NODELAY, &no_delay, sizeof(no_delay));
+
+    g_lockstep.role = LOCKSTEP_NODE;
+    g_lockstep.coordinator.socket = connection;
+    g_lockstep.resync_pending = true;
+    g_late_latch = false; /* The drag comes from the coordinator */
+
+    /* Block until the initial snapshot is in */
+    while (g_lockstep.resync_pending && g_running)
+    {
+        lockstep_follow();
+        SDL_Delay(1);
+    }
+    if (!g_running)
+    {
+        return false;
+    }
+
+    printf("Lockstep: following %s from step %u\n", address, g_lockstep.step);
+    return true;
+}
+
+/**
+ * Queues a header and up to two payload parts, then sends as much of the
+ * queue as the connection takes without blocking.
+ *
+ * @param peer Receiving end
+ * @param header Message header; payload_bytes must match the parts
+ * @param payload First payload part, or NULL
+ * @param payload_bytes Size of the first part
+ * @param extra Second payload part, or NULL
+ * @param extra_bytes Size of the second part
+ * @return true on success, false if the connection failed
+ */
+static bool lockstep_send(LockstepPeer *peer, const LockstepHeader *header, const void *payload, size_t payload_bytes,
+                          const void *extra, size_t extra_bytes)
+{
+    const void *parts[3] = {header, payload, extra};
+    const size_t sizes[3] = {sizeof(*header), payload ? payload_bytes : 0, extra ? extra_bytes : 0};
+    const size_t bytes = sizes[0] + sizes[1] + sizes[2];
+
+    if (peer->outbox_capacity - peer->outbox_length < bytes)
+    {
+        const size_t capacity = SDL_max(peer->outbox_capacity * 2, peer->outbox_length + bytes);
+        Uint8 *outbox = realloc(peer->outbox, capacity);
+        if (!outbox)
+        {
+            return false;
+        }
+        peer->outbox = outbox;
+        peer->outbox_capacity = capacity;
+    }
+
+    for (int part = 0; part < 3; part++)
+    {
+        if (sizes[part] > 0)
+        {
+            memcpy(peer->outbox + peer->outbox_length, parts[part], sizes[part]);
+            peer->outbox_length += sizes[part];
+        }
+    }
+    return lockstep_flush(peer);
+}
+
+/**
+ * Sends as much of a connection's queued bytes as it takes without blocking.
+ *
+ * @param peer Connection to send on
+ * @return false if the connection failed
+ */
+static bool lockstep_flush(LockstepPeer *peer)
+{
+    size_t sent = 0;
+    while (sent < peer->outbox_length)
+    {
+        const ssize_t written =
+            send(peer->socket, peer->outbox + sent, peer->outbox_length - sent, MSG_NOSIGNAL | MSG_DONTWAIT);
+        if (written > 0)
+        {
+            sent += (size_t)written;
+            continue;
+        }
+        if (written < 0 && errno == EINTR)
+        {
+            continue;
+        }
+        if (written < 0 && (errno == EAGAIN || errno == EWOULDBLOCK))
+        {
+            break;
+        }
+        return false;
+    }
+
+    if (sent > 0)
+    {
+        memmove(peer->outbox, peer->outbox + sent, peer->outbox_length - sent);
+        peer->outbox_length -= sent;
+    }
+    return true;
+}
+
+/**
+ * Sends the full simulation state, which the node adopts as is.
+ *
+ * @param peer Node to send to
+ * @return true on success, false if the connection failed
+ */
+static bool lockstep_send_snapshot(LockstepPeer *peer)
+{
+    const LockstepState state = {
+        .rows = g_grid_rows,
+        .cols = g_grid_cols,
+        .drag = g_drag_state,
+        .morph_shape = g_morph.shape,
+        .morph_settling = g_morph.settling,
+        .morph_shaped = g_morph.shaped};
+    const size_t dot_bytes = (size_t)g_grid_rows * g_grid_cols * sizeof(Dot);
+    const LockstepHeader header = {
+        .magic = LOCKSTEP_MAGIC,
+        .type = LOCKSTEP_SNAPSHOT,
+        .step = g_lockstep.step,
+        .checksum = lockstep_checksum(),
+        .time_ms = SDL_GetTicks(),
+        .payload_bytes = (Uint32)(sizeof(state) + dot_bytes)};
+
+    g_lockstep.snapshots++;
+    g_lockstep.snapshot_bytes += sizeof(header) + header.payload_bytes;
+    return lockstep_send(peer, &header, &state, sizeof(state), g_dots, dot_bytes);
+}
+
+/**
+ * Largest payload a message of the given type may carry, so that a peer
+ * cannot make the other end buffer more than one snapshot.
+ *
+ * @param type LockstepMessageType
+ * @return Payload limit in bytes
+ */
+static size_t lockstep_payload_limit(Uint32 type)
+{
+    switch (type)
+    {
+    case LOCKSTEP_FRAME:
+        return LOCKSTEP_INPUTS_PER_FRAME * sizeof(InputCommand);
+    case LOCKSTEP_SNAPSHOT:
+        return sizeof(LockstepState) + (size_t)g_grid_rows * g_grid_cols * sizeof(Dot);
+    default:
+        return 0;
+    }
+}
+
+/**
+ * Checks that a snapshot is of a grid the size of this one, and stops with
+ * a hint if not.
+ *
+ * @param state State that arrived with a snapshot
+ * @return true if the grids match
+ */
+static bool lockstep_grid_matches(const LockstepState *state)
+{
+    if (state->rows == g_grid_rows && state->cols == g_grid_cols)
+    {
+        return true;
+    }
+
+    fprintf(stderr, "Lockstep: coordinator grid is %dx%d, start with --grid %dx%d\n", state->rows, state->cols,
+            state->rows, state->cols);
+    g_running = false;
+    return false;
+}
+
+/**
+ * Appends whatever has arrived on a connection to its buffer, without
+ * blocking. The buffer stops growing at the largest message; anything
+ * beyond it stays in the socket until the buffer has been parsed.
+ *
+ * @param peer Connection to read
+ * @return false if the connection was closed or failed
+ */
+static bool lockstep_receive(LockstepPeer *peer)
+{
+    const size_t limit = sizeof(LockstepHeader) + lockstep_payload_limit(LOCKSTEP_SNAPSHOT);
+
+    while (peer->length < limit)
+    {
+        if (peer->capacity - peer->length < 65536 && peer->capacity < limit)
+        {
+            const size_t capacity = SDL_min(peer->capacity ? peer->capacity * 2 : 262144, limit);
+            Uint8 *buffer = realloc(peer->buffer, capacity);
+            if (!buffer)
+            {
+                return false;
+            }
+            peer->buffer = buffer;
+            peer->capacity = capacity;
+        }
+
+        const ssize_t received =
+            recv(peer->socket, peer->buffer + peer->length, peer->capacity - peer->length, MSG_DONTWAIT);
+        if (received > 0)
+        {
+            peer->length += (size_t)received;
+            continue;
+        }
+        if (received < 0 && (errno == EAGAIN || errno == EWOULDBLOCK || errno == EINTR))
+        {
+            return true;
+        }
+        return false;
+    }
+    return true;
+}
+
+/**
+ * Takes the oldest complete message out of a connection's buffer.
+ *
+ * @param peer Connection to parse
+ * @param header Output message header
+ * @param payload Output copy of the payload, valid until the next call
+ * @return 1 for a message, 0 if none is complete, -1 for a corrupt stream
+ */
+static int lockstep_next_message(LockstepPeer *peer, LockstepHeader *header, Uint8 **payload)
+{
+    if (peer->length < sizeof(*header))
+    {
+        return 0;
+    }
+    memcpy(header, peer->buffer, sizeof(*header));
+    if (header->magic != LOCKSTEP_MAGIC || header->type > LOCKSTEP_RESYNC ||
+        header->payload_bytes > lockstep_payload_limit(header->type))
+    {
+        return -1;
+    }
+
+    const size_t total = sizeof(*header) + header->payload_bytes;
+    if (peer->length < total)
+    {
+        return 0;
+    }
+
+    if (g_lockstep.message_capacity < header->payload_bytes)
+    {
+        Uint8 *message = realloc(g_lockstep.message, header->payload_bytes);
+        if (!message)
+        {
+            return -1;
+        }
+        g_lockstep.message = message;
+        g_lockstep.message_capacity = header->payload_bytes;
+    }
+    memcpy(g_lockstep.message, peer->buffer + sizeof(*header), header->payload_bytes);
+    memmove(peer->buffer, peer->buffer + total, peer->length - total);
+    peer->length -= total;
+    *payload = g_lockstep.message;
+    return 1;
+}
+
+/**
+ * Closes a node connection.
+ *
+ * @param node Index into the node list
+ */
+static void lockstep_drop_node(int node)
+{
+    printf("Lockstep: node %d disconnected\n", node);
+    close(g_lockstep.nodes[node].socket);
+    free(g_lockstep.nodes[node].buffer);
+    free(g_lockstep.nodes[node].outbox);
+    g_lockstep.nodes[node] = g_lockstep.nodes[--g_lockstep.node_count];
+}
+
+/**
+ * Coordinator, once per frame after the physics step: accepts new nodes,
+ * sends every node this frame's inputs and checksum, and sends a snapshot
+ * to new nodes and to nodes that reported a mismatch. Nothing blocks: a
+ * node whose unsent backlog outgrows a snapshot plus LOCKSTEP_MAX_BACKLOG
+ * misses frames until its queue drains, then gets a snapshot.
+ */
+static void lockstep_broadcast(void)
+{
+    if (g_lockstep.role != LOCKSTEP_COORDINATOR)
+    {
+        return;
+    }
+
+    for (;;)
+    {
+        const int connection = accept(g_lockstep.listen_socket, NULL, NULL);
+        if (connection < 0)
+        {
+            break;
+        }
+        if (g_lockstep.node_count == LOCKSTEP_MAX_NODES)
+        {
+            close(connection);
+            continue;
+        }
+
+        const int no_delay = 1;
+        setsockopt(connection, IPPROTO_TCP, TCP_NODELAY, &no_delay, sizeof(no_delay));
+        g_lockstep.nodes[g_lockstep.node_count] = (LockstepPeer){.socket = connection, .wants_snapshot = true};
+        printf("Lockstep: node %d connected\n", g_lockstep.node_count);
+        g_lockstep.node_count++;
+    }
+
+    for (int node = 0; node < g_lockstep.node_count; node++)
+    {
+        LockstepPeer *peer = &g_lockstep.nodes[node];
+        LockstepHeader header;
+        Uint8 *payload;
+        int parsed = 0;
+        const bool open = lockstep_receive(peer);
+        while ((parsed = lockstep_next_message(peer, &header, &payload)) > 0)
+        {
+            if (header.type == LOCKSTEP_RESYNC)
+            {
+                printf("Lockstep: node %d diverged at step %u, sending a snapshot\n", node, header.step);
+                peer->wants_snapshot = true;
+            }
+        }
+        if (!open || parsed < 0)
+        {
+            lockstep_drop_node(node--);
+        }
+    }
+
+    if (g_lockstep.node_count > 0)
+    {
+        const size_t backlog_limit =
+            sizeof(LockstepHeader) + lockstep_payload_limit(LOCKSTEP_SNAPSHOT) + LOCKSTEP_MAX_BACKLOG;
+        const LockstepHeader header = {
+            .magic = LOCKSTEP_MAGIC,
+            .type = LOCKSTEP_FRAME,
+            .step = g_lockstep.step,
+            .checksum = lockstep_checksum(),
+            .time_ms = SDL_GetTicks(),
+            .payload_bytes = (Uint32)(g_lockstep.input_count * sizeof(InputCommand)),
+            .input_count = (Uint16)g_lockstep.input_count};
+
+        for (int node = 0; node < g_lockstep.node_count; node++)
+        {
+            LockstepPeer *peer = &g_lockstep.nodes[node];
+            bool sent = lockstep_flush(peer);
+            peer->wants_snapshot |= g_lockstep.overflowed;
+            if (peer->outbox_length > backlog_limit && !peer->wants_snapshot)
+            {
+                printf("Lockstep: node %d fell behind, sending a snapshot once it catches up\n", node);
+                peer->wants_snapshot = true;
+            }
+
+            /* The snapshot is taken after this frame and replaces every frame the node missed */
+            if (sent && !peer->wants_snapshot)
+            {
+                sent = lockstep_send(peer, &header, g_lockstep.inputs, header.payload_bytes, NULL, 0);
+                g_lockstep.frame_bytes += sizeof(header) + header.payload_bytes;
+            }
+            else if (sent && peer->outbox_length == 0)
+            {
+                sent = lockstep_send_snapshot(peer);
+                peer->wants_snapshot = false;
+            }
+            if (!sent)
+            {
+                lockstep_drop_node(node--);
+            }
+        }
+        g_lockstep.frames++;
+    }
+
+    g_lockstep.input_count = 0;
+    g_lockstep.overflowed = false;
+}
+
+/**
+ * Node, in place of the physics step: applies every frame that has arrived
+ * from the coordinator, in order, and compares checksums. A mismatch asks
+ * for a snapshot; frames keep being applied until it arrives.
+ */
+static void lockstep_follow(void)
+{
+    LockstepPeer *peer = &g_lockstep.coordinator;
+    LockstepHeader header;
+    Uint8 *payload;
+    int parsed;
+
+    const bool open = lockstep_receive(peer) && lockstep_flush(peer);
+    while ((parsed = lockstep_next_message(peer, &header, &payload)) > 0)
+    {
+        if (header.type == LOCKSTEP_SNAPSHOT)
+        {
+            LockstepState state;
+            if (header.payload_bytes < sizeof(state))
+            {
+                parsed = -1;
+                break;
+            }
+            memcpy(&state, payload, sizeof(state));
+            if (!lockstep_grid_matches(&state))
+            {
+                return;
+            }
+            if (header.payload_bytes != lockstep_payload_limit(LOCKSTEP_SNAPSHOT) ||
+                !drag_state_valid(&state.drag, g_grid_rows, g_grid_cols) ||
+                (g_morph.shape_count > 0 && (state.morph_shape < -1 || state.morph_shape >= g_morph.shape_count)))
+            {
+                parsed = -1;
+                break;
+            }
+
+            memcpy(g_dots, payload + sizeof(state), (size_t)g_grid_rows * g_grid_cols * sizeof(Dot));
+            g_drag_state = state.drag;
+            if (g_morph.shape_count > 0)
+            {
+                if (state.morph_shape != g_morph.shape)
+                {
+                    morph_show(state.morph_shape);
+                }
+                g_morph.settling = state.morph_settling;
+                g_morph.shaped = state.morph_shaped;
+            }
+            g_lockstep.step = header.step;
+            g_lockstep.resync_pending = false;
+            g_lockstep.snapshots++;
+            g_lockstep.snapshot_bytes += sizeof(header) + header.payload_bytes;
+            continue;
+        }
+
+        if (header.type != LOCKSTEP_FRAME)
+        {
+            continue;
+        }
+        if (header.payload_bytes != header.input_count * sizeof(InputCommand))
+        {
+            parsed = -1;
+            break;
+        }
+
+        const InputCommand *inputs = (const InputCommand *)payload;
+        for (int i = 0; i < header.input_count; i++)
+        {
+            if (inputs[i].type == INPUT_STEP)
+            {
+                morph_step();
+                update_physics();
+                g_lockstep.step++;
+            }
+            else
+            {
+                apply_input_command(&inputs[i]);
+            }
+        }
+        g_lockstep.frames++;
+        g_lockstep.frame_bytes += sizeof(header) + header.payload_bytes;
+
+        if (!g_lockstep.resync_pending && (header.step != g_lockstep.step || header.checksum != lockstep_checksum()))
+        {
+            const LockstepHeader request = {.magic = LOCKSTEP_MAGIC, .type = LOCKSTEP_RESYNC, .step = header.step};
+            printf("Lockstep: diverged at step %u, requesting a snapshot\n", header.step);
+            g_lockstep.divergences++;
+            g_lockstep.resync_pending = true;
+            if (!lockstep_send(peer, &request, NULL, 0, NULL, 0))
+            {
+                break;
+            }
+        }
+    }
+
+    if (parsed < 0 && peer->length >= sizeof(header) + sizeof(LockstepState))
+    {
+        /* A snapshot of a larger grid is over the size limit; say why rather than calling the stream corrupt */
+        LockstepState state;
+        memcpy(&header, peer->buffer, sizeof(header));
+        memcpy(&state, peer->buffer + sizeof(header), sizeof(state));
+        if (header.type == LOCKSTEP_SNAPSHOT && !lockstep_grid_matches(&state))
+        {
+            return;
+        }
+    }
+    if (!open || parsed < 0)
+    {
+        printf("Lockstep: coordinator disconnected\n");
+        g_running = false;
+    }
+}
+
+/**
+ * Closes all lockstep connections and prints the traffic totals.
+ */
+static void lockstep_shutdown(void)
+{
+    if (g_lockstep.role == LOCKSTEP_OFF)
+    {
+        return;
+    }
+
+    printf("Lockstep: %u frames, %.1f bytes per frame; %u snapshots, %.1f KB; %u divergences; "
+           "step %u, checksum %08x\n",
+           g_lockstep.frames, g_lockstep.frames ? (double)g_lockstep.frame_bytes / g_lockstep.frames : 0.0,
+           g_lockstep.snapshots, g_lockstep.snapshot_bytes / 1024.0, g_lockstep.divergences, g_lockstep.step,
+           lockstep_checksum());
+
+    for (int node = 0; node < g_lockstep.node_count; node++)
+    {
+        close(g_lockstep.nodes[node].socket);
+        free(g_lockstep.nodes[node].buffer);
+        free(g_lockstep.nodes[node].outbox);
+    }
+    if (g_lockstep.listen_socket >= 0)
+    {
+        close(g_lockstep.listen_socket);
+    }
+    if (g_lockstep.coordinator.socket >= 0)
+    {
+        close(g_lockstep.coordinator.socket);
+    }
+    free(g_lockstep.coordinator.buffer);
+    free(g_lockstep.coordinator.outbox);
+    free(g_lockstep.message);
+    g_lockstep = (Lockstep){.listen_socket = -1, .coordinator = {.socket = -1}};
+}
+#endif
+
+/**
+ * Opens a source of raw frames that drives the dots' colours. Regular files
+ * are memory mapped and loop at the end; anything else (pipes, "-" for stdin)
+ * is streamed by a reader thread and stops at end of stream.
+ * Must be called after the grid has been allocated.
+ *
+ * @param path File, pipe or "-" for stdin
+ * @param width Frame width in pixels
+ * @param height Frame height in pixels
+ * @param format Pixel format of the frames
+ * @param rate Frames per second to show
+ * @return true on success, false on error
+ */
+static bool frame_source_open(const char *path, int width, int height, FrameFormat format, int rate)
+{
+    memset(&g_frames, 0, sizeof(g_frames));
+    g_frames.format = format;
+    g_frames.width = width;
+    g_frames.height = height;
+    g_frames.channels = format == FRAME_RGB ? 3 : 1;
+    g_frames.frame_bytes = (size_t)width * (size_t)height * (size_t)g_frames.channels;
+    g_frames.interval_ms = 1000 / (Uint32)(rate > 0 ? rate : FRAME_DEFAULT_RATE);
+
+    const size_t dot_count = (size_t)g_grid_rows * (size_t)g_grid_cols;
+    g_dot_colors = arena_alloc(dot_count * sizeof(SDL_Color));
+    g_frames.column_map = arena_alloc((size_t)g_grid_cols * sizeof(Sint32));
+    g_frames.row_scratch = arena_alloc((size_t)g_grid_cols + 16);
+    if (!g_dot_colors || !g_frames.column_map || !g_frames.row_scratch)
+    {
+        fprintf(stderr, "Failed to allocate frame source buffers\n");
+        frame_source_close();
+        return false;
+    }
+
+    /* Start with every dot unlit */
+    for (size_t i = 0; i < dot_count; i++)
+    {
+        g_dot_colors[i] = (SDL_Color){BACKGROUND_COLOR_R, BACKGROUND_COLOR_G, BACKGROUND_COLOR_B, DOT_COLOR_A};
+    }
+    for (int col = 0; col < g_grid_cols; col++)
+    {
+        g_frames.column_map[col] = (Sint32)((Sint64)col * width / g_grid_cols);
+    }
+
+#ifdef HAS_MMAP
+    struct stat info;
+    if (strcmp(path, "-") != 0 && stat(path, &info) == 0 && S_ISREG(info.st_mode))
+    {
+        const int fd = open(path, O_RDONLY);
+        g_frames.frame_count = fd >= 0 ? (size_t)info.st_size / g_frames.frame_bytes : 0;
+        if (g_frames.frame_count == 0)
+        {
+            fprintf(stderr, "%s holds no complete %dx%d frame\n", path, width, height);
+            if (fd >= 0)
+            {
+                close(fd);
+            }
+            frame_source_close();
+            return false;
+        }
+
+        void *mapping = mmap(NULL, (size_t)info.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+        close(fd);
+        if (mapping == MAP_FAILED)
+        {
+            fprintf(stderr, "Failed to map %s\n", path);
+            frame_source_close();
+            return false;
+        }
+
+        g_frames.mapping = mapping;
+        g_frames.mapping_size = (size_t)info.st_size;
+        g_frames.active = true;
+        return true;
+    }
+#endif
+
+    g_frames.stream = strcmp(path, "-") == 0 ? stdin : fopen(path, "rb");
+    if (!g_frames.stream)
+    {
+        fprintf(stderr, "Failed to open %s\n", path);
+        frame_source_close();
+        return false;
+    }
+
+    /* Not from the arena: a reader blocked on a pipe is detached at shutdown and may still fill a slot after
+       the arena is released. Browser builds have no reader thread and map their files instead. */
+    for (int slot = 0; slot < FRAME_RING_SIZE; slot++)
+    {
+        g_frames.ring[slot] = malloc(g_frames.frame_bytes);
+        if (!g_frames.ring[slot])
+        {
+            fprintf(stderr, "Failed to allocate frame buffers\n");
+            frame_source_close();
+            return false;
+        }
+    }
+
+    g_frames.active = true;
+    g_frames.free_slots = SDL_CreateSemaphore(FRAME_RING_SIZE);
+    g_frames.full_slots = SDL_CreateSemaphore(0);
+    if (g_frames.free_slots && g_frames.full_slots)
+    {
+        g_frames.reader = SDL_CreateThread(frame_source_reader, "frames", NULL);
+    }
+    /* Without a reader thread, frames are read on the main thread when due */
+    return true;
+}
+
+/**
+ * Releases the frame source. A reader blocked on a pipe is detached rather
+ * than waited for.
+ */
+static void frame_source_close(void)
+{
+    if (g_frames.reader)
+    {
+        SDL_AtomicSet(&g_frames.ended, 1);
+        SDL_SemPost(g_frames.free_slots);
+        SDL_DetachThread(g_frames.reader);
+        g_frames.reader = NULL;
+    }
+    else
+    {
+        for (int slot = 0; slot < FRAME_RING_SIZE; slot++)
+        {
+            free(g_frames.ring[slot]);
+        }
+        if (g_frames.free_slots)
+        {
+            SDL_DestroySemaphore(g_frames.free_slots);
+        }
+        if (g_frames.full_slots)
+        {
+            SDL_DestroySemaphore(g_frames.full_slots);
+        }
+        if (g_frames.stream && g_frames.stream != stdin)
+        {
+            fclose(g_frames.stream);
+        }
+    }
+
+#ifdef HAS_MMAP
+    if (g_frames.mapping)
+    {
+        munmap((void *)g_frames.mapping, g_frames.mapping_size);
+    }
+#endif
+
+    arena_free(g_frames.column_map);
+    arena_free(g_frames.row_scratch);
+    arena_free(g_dot_colors);
+    g_dot_colors = NULL;
+    memset(&g_frames, 0, sizeof(g_frames));
+}
+
+/**
+ * Reader thread: fills free ring buffers with frames from the stream until it
+ * ends. The ring and stream are left allocated if the thread is detached.
+ *
+ * @param data Unused
+ * @return 0
+ */
+static int frame_source_reader(void *data)
+{
+    (void)data;
+    int slot = 0;
+
+    for (;;)
+    {
+        SDL_SemWait(g_frames.free_slots);
+        if (SDL_AtomicGet(&g_frames.ended))
+        {
+            return 0;
+        }
+
+        if (fread(g_frames.ring[slot], 1, g_frames.frame_bytes, g_frames.stream) != g_frames.frame_bytes)
+        {
+            SDL_AtomicSet(&g_frames.ended, 1);
+            return 0;
+        }
+
+        slot = (slot + 1) % FRAME_RING_SIZE;
+        SDL_SemPost(g_frames.full_slots);
+    }
+}
+
+/**
+ * Shows the next frame once its time has come. When a streamed frame is not
+ * ready yet, the current colours are kept and the frame is shown later.
+ */
+static void frame_source_update(void)
+{
+    if (!g_frames.active)
+    {
+        return;
+    }
+
+    const Uint32 now = SDL_GetTicks();
+    if ((Sint32)(now - g_frames.next_frame_ticks) < 0)
+    {
+        return;
+    }
+
+    if (g_frames.mapping)
+    {
+        frame_source_resample(g_frames.mapping + g_frames.next_index * g_frames.frame_bytes);
+        g_frames.next_index = (g_frames.next_index + 1) % g_frames.frame_count;
+    }
+    else if (g_frames.reader)
+    {
+        if (SDL_SemTryWait(g_frames.full_slots) != 0)
+        {
+            return;
+        }
+        frame_source_resample(g_frames.ring[g_frames.consume_slot]);
+        g_frames.consume_slot = (g_frames.consume_slot + 1) % FRAME_RING_SIZE;
+        SDL_SemPost(g_frames.free_slots);
+    }
+    else if (!SDL_AtomicGet(&g_frames.ended))
+    {
+        if (fread(g_frames.ring[0], 1, g_frames.frame_bytes, g_frames.stream) != g_frames.frame_bytes)
+        {
+            SDL_AtomicSet(&g_frames.ended, 1);
+            return;
+        }
+        frame_source_resample(g_frames.ring[0]);
+    }
+    else
+    {
+        return;
+    }
+
+    g_frames.frames_shown++;
+    /* Keep a steady cadence, but do not try to catch up after a stall */
+    g_frames.next_frame_ticks += g_frames.interval_ms;
+    if ((Sint32)(now - g_frames.next_frame_ticks) > (Sint32)g_frames.interval_ms)
+    {
+        g_frames.next_frame_ticks = now + g_frames.interval_ms;
+    }
+}
+
+/**
+ * Converts one row of grey pixels into dot colours: the dot colour scaled by
+ * each pixel's intensity. Uses SSE2 eight pixels at a time when available.
+ *
+ * @param grey Grey pixels, one per dot
+ * @param colors Output colours
+ * @param count Number of dots
+ */
+static void frame_source_shade_row(const Uint8 *grey, SDL_Color *colors, int count)
+{
+    /* (g * 257 * (c + 1)) >> 16 approximates g * c / 255 and is exact at 0 and 255 */
+    int i = 0;
+#ifdef __SSE2__
+    const __m128i zero = _mm_setzero_si128();
+    const __m128i scale = _mm_set1_epi16(257);
+    const __m128i red = _mm_set1_epi16(DOT_COLOR_R + 1);
+    const __m128i green = _mm_set1_epi16(DOT_COLOR_G + 1);
+    const __m128i blue = _mm_set1_epi16(DOT_COLOR_B + 1);
+    const __m128i alpha = _mm_set1_epi16((short)(DOT_COLOR_A << 8));
+
+    for (; i + 8 <= count; i += 8)
+    {
+        const __m128i pixels = _mm_unpacklo_epi8(_mm_loadl_epi64((const __m128i *)(grey + i)), zero);
+        const __m128i intensity = _mm_mullo_epi16(pixels, scale);
+        const __m128i r = _mm_mulhi_epu16(intensity, red);
+        const __m128i g = _mm_mulhi_epu16(intensity, green);
+        const __m128i b = _mm_mulhi_epu16(intensity, blue);
+
+        /* Interleave into r, g, b, a bytes per dot */
+        const __m128i rg = _mm_or_si128(r, _mm_slli_epi16(g, 8));
+        const __m128i ba = _mm_or_si128(b, alpha);
+        _mm_storeu_si128((__m128i *)(colors + i), _mm_unpacklo_epi16(rg, ba));
+        _mm_storeu_si128((__m128i *)(colors + i + 4), _mm_unpackhi_epi16(rg, ba));
+    }
+#endif
+
+    for (; i < count; i++)
+    {
+        const Uint32 intensity = grey[i] * 257u;
+        colors[i] = (SDL_Color){
+            (Uint8)((intensity * (DOT_COLOR_R + 1)) >> 16),
+            (Uint8)((intensity * (DOT_COLOR_G + 1)) >> 16),
+            (Uint8)((intensity * (DOT_COLOR_B + 1)) >> 16),
+            DOT_COLOR_A};
+    }
+}
+
+/**
+ * Resamples a frame to the grid's resolution into the per-dot colours.
+ * Rows of matching width are shaded straight from the frame.
+ *
+ * @param frame Frame pixels in the source's format
+ */
+static void frame_source_resample(const Uint8 *frame)
+{
+    const size_t stride = (size_t)g_frames.width * (size_t)g_frames.channels;
+    const bool same_width = g_frames.width == g_grid_cols;
+
+    for (int row = 0; row < g_grid_rows; row++)
+    {
+        const Uint8 *source = frame + (size_t)((Sint64)row * g_frames.height / g_grid_rows) * stride;
+        SDL_Color *colors = &g_dot_colors[(size_t)row * g_grid_cols];
+
+        if (g_frames.format == FRAME_GREY)
+        {
+            if (!same_width)
+            {
+                for (int col = 0; col < g_grid_cols; col++)
+                {
+                    g_frames.row_scratch[col] = source[g_frames.column_map[col]];
+                }
+                source = g_frames.row_scratch;
+            }
+            frame_source_shade_row(source, colors, g_grid_cols);
+        }
+        else
+        {
+            for (int col = 0; col < g_grid_cols; col++)
+            {
+                const Uint8 *pixel = source + (size_t)g_frames.column_map[col] * 3;
+                colors[col] = (SDL_Color){pixel[0], pixel[1], pixel[2], DOT_COLOR_A};
+            }
+        }
+    }
+}
+
+/**
+ * Builds one shape's displacement field from a brightness map: the map is
+ * resampled to the grid, blurred, and each dot is displaced along the
+ * brightness gradient so dots gather on bright features.
+ *
+ * @param map Brightness map, one byte per pixel
+ * @param width Map width in pixels
+ * @param height Map height in pixels
+ * @param intensity Scratch buffer of one float per dot
+ * @param scratch Second scratch buffer of one float per dot
+ * @param dx Output x displacement per dot
+ * @param dy Output y displacement per dot
+ */
+static void morph_build_shape(const Uint8 *map, int width, int height, float *intensity, float *scratch,
+                              float *dx, float *dy)
+{
+    const int rows = g_grid_rows;
+    const int cols = g_grid_cols;
+
+    for (int row = 0; row < rows; row++)
+    {
+        const Uint8 *source = map + (size_t)((Sint64)row * height / rows) * width;
+        for (int col = 0; col < cols; col++)
+        {
+            intensity[row * cols + col] = source[(Sint64)col * width / cols] / 255.0f;
+        }
+    }
+
+    /* Separable 3x3 box blur with clamped edges, so glyph strokes have a gradient to follow */
+    for (int pass = 0; pass < MORPH_BLUR_PASSES; pass++)
+    {
+        for (int row = 0; row < rows; row++)
+        {
+            const float *line = intensity + (size_t)row * cols;
+            for (int col = 0; col < cols; col++)
+            {
+                scratch[row * cols + col] =
+                    (line[col > 0 ? col - 1 : 0] + line[col] + line[col < cols - 1 ? col + 1 : col]) / 3.0f;
+            }
+        }
+        for (int row = 0; row < rows; row++)
+        {
+            const float *above = scratch + (size_t)(row > 0 ? row - 1 : 0) * cols;
+            const float *line = scratch + (size_t)row * cols;
+            const float *below = scratch + (size_t)(row < rows - 1 ? row + 1 : row) * cols;
+            for (int col = 0; col < cols; col++)
+            {
+                intensity[row * cols + col] = (above[col] + line[col] + below[col]) / 3.0f;
+            }
+        }
+    }
+
+    const float scale = MORPH_DISPLACEMENT * SPRING_REST_LENGTH / 2.0f;
+    for (int row = 0; row < rows; row++)
+    {
+        const float *above = intensity + (size_t)(row > 0 ? row - 1 : 0) * cols;
+        const float *line = intensity + (size_t)row * cols;
+        const float *below = intensity + (size_t)(row < rows - 1 ? row + 1 : row) * cols;
+        for (int col = 0; col < cols; col++)
+        {
+            dx[row * cols + col] = (line[col < cols - 1 ? col + 1 : col] - line[col > 0 ? col - 1 : 0]) * scale;
+            dy[row * cols + col] = (below[col] - above[col]) * scale;
+        }
+    }
+}
+
+/**
+ * Counts the shapes in a morph file from its size, so their fields can be
+ * allocated at once.
+ *
+ * @param path File holding one or more width x height maps
+ * @param width Map width in pixels
+ * @param height Map height in pixels
+ * @return Complete shapes in the file, or 1 if its size is not known in advance
+ */
+static size_t morph_file_shapes(const char *path, int width, int height)
+{
+#ifdef HAS_MMAP
+    const size_t map_bytes = (size_t)width * (size_t)height;
+    struct stat info;
+    if (map_bytes > 0 && stat(path, &info) == 0 && S_ISREG(info.st_mode) && (size_t)info.st_size >= map_bytes)
+    {
+        return (size_t)info.st_size / map_bytes;
+    }
+#else
+    (void)path;
+    (void)width;
+    (void)height;
+#endif
+    return 1;
+}
+
+/**
+ * Loads rest shapes from a file of raw greyscale brightness maps, one after
+ * another, and starts morphing toward the first.
+ *
+ * @param path File holding one or more width x height maps
+ * @param width Map width in pixels
+ * @param height Map height in pixels
+ * @param rate Fraction of the remaining distance covered per step
+ * @return true on success, false on error
+ */
+static bool morph_load(const char *path, int width, int height, float rate)
+{
+    FILE *file = fopen(path, "rb");
+    if (!file)
+    {
+        fprintf(stderr, "Failed to open %s\n", path);
+        return false;
+    }
+
+    const size_t dot_count = (size_t)g_grid_rows * (size_t)g_grid_cols;
+    const size_t map_bytes = (size_t)width * (size_t)height;
+    Uint8 *map = malloc(map_bytes);
+    float *intensity = malloc(dot_count * sizeof(float));
+    float *scratch = malloc(dot_count * sizeof(float));
+    size_t capacity = morph_file_shapes(path, width, height);
+    g_morph.target_x = arena_alloc(dot_count * sizeof(float));
+    g_morph.target_y = arena_alloc(dot_count * sizeof(float));
+    g_morph.shape_dx = arena_alloc(capacity * dot_count * sizeof(float));
+    g_morph.shape_dy = arena_alloc(capacity * dot_count * sizeof(float));
+    bool ok = map && intensity && scratch && g_morph.target_x && g_morph.target_y && g_morph.shape_dx &&
+              g_morph.shape_dy;
+
+    while (ok && fread(map, 1, map_bytes, file) == map_bytes)
+    {
+        /* More shapes than the file size promised, as from a pipe */
+        if ((size_t)g_morph.shape_count == capacity)
+        {
+            const size_t bytes = capacity * dot_count * sizeof(float);
+            float *shape_dx = arena_realloc(g_morph.shape_dx, bytes, bytes * 2);
+            if (shape_dx)
+            {
+                g_morph.shape_dx = shape_dx;
+            }
+            float *shape_dy = arena_realloc(g_morph.shape_dy, bytes, bytes * 2);
+            if (shape_dy)
+            {
+                g_morph.shape_dy = shape_dy;
+            }
+            if (!shape_dx || !shape_dy)
+            {
+                fprintf(stderr, "Failed to allocate shape %d\n", g_morph.shape_count + 1);
+                ok = false;
+                break;
+            }
+            capacity *= 2;
+        }
+
+        const size_t offset = (size_t)g_morph.shape_count * dot_count;
+        morph_build_shape(map, width, height, intensity, scratch, g_morph.shape_dx + offset,
+                          g_morph.shape_dy + offset);
+        g_morph.shape_count++;
+    }
+
+    fclose(file);
+    free(map);
+    free(intensity);
+    free(scratch);
+
+    if (ok && g_morph.shape_count == 0)
+    {
+        fprintf(stderr, "%s holds no complete %dx%d shape\n", path, width, height);
+        ok = false;
+    }
+    if (!ok)
+    {
+        morph_shutdown();
+        return false;
+    }
+
+    g_morph.rate = rate;
+    morph_show(0);
+    return true;
+}
+
+/**
+ * Frees loaded shapes and targets.
+ */
+static void morph_shutdown(void)
+{
+    arena_free(g_morph.target_x);
+    arena_free(g_morph.target_y);
+    arena_free(g_morph.shape_dx);
+    arena_free(g_morph.shape_dy);
+    g_morph = (Morph){0};
+}
+
+/**
+ * Starts morphing toward a loaded shape or back to the lattice.
+ *
+ * @param shape Index of a loaded shape, or -1 for the lattice
+ */
+static void morph_show(int shape)
+{
+    const float *shape_dx = shape >= 0 ? g_morph.shape_dx + (size_t)shape * g_grid_rows * g_grid_cols : NULL;
+    const float *shape_dy = shape >= 0 ? g_morph.shape_dy + (size_t)shape * g_grid_rows * g_grid_cols : NULL;
+
+    for (int row = 0; row < g_grid_rows; row++)
+    {
+        for (int col = 0; col < g_grid_cols; col++)
+        {
+            const size_t i = (size_t)row * g_grid_cols + col;
+            lattice_position(row, col, &g_morph.target_x[i], &g_morph.target_y[i]);
+            if (shape_dx)
+            {
+                g_morph.target_x[i] += shape_dx[i];
+                g_morph.target_y[i] += shape_dy[i];
+            }
+        }
+    }
+
+    g_morph.shape = shape;
+    g_morph.settling = true;
+    g_morph.shaped = true;
+}
+
+/**
+ * Moves every rest position a fixed fraction of the way to its target in a
+ * single pass over the grid. Does nothing once all targets are reached.
+ */
+static void morph_step(void)
+{
+    if (!g_morph.settling)
+    {
+        return;
+    }
+
+    const size_t dot_count = (size_t)g_grid_rows * (size_t)g_grid_cols;
+    const float *target_x = g_morph.target_x;
+    const float *target_y = g_morph.target_y;
+    const float rate = g_morph.rate;
+    bool settling = false;
+
+    if (g_physics_mode == PHYSICS_FIXED)
+    {
+        /* Blend in 1/4096 px with steps rounded toward the target, so rest positions stay bit-identical too */
+        const Sint32 fixed_rate = rate < 1.0f ? FIXED_FACTOR(rate) : 65535;
+
+        for (size_t i = 0; i < dot_count; i++)
+        {
+            Dot *dot = &g_dots[i];
+            const Sint32 rest_x = fixed_from_float(dot->original_x);
+            const Sint32 rest_y = fixed_from_float(dot->original_y);
+            const Sint32 dx = fixed_from_float(target_x[i]) - rest_x;
+            const Sint32 dy = fixed_from_float(target_y[i]) - rest_y;
+            const Sint32 step_x = fixed_scale(abs(dx), fixed_rate);
+            const Sint32 step_y = fixed_scale(abs(dy), fixed_rate);
+
+            if (step_x == 0 && step_y == 0)
+            {
+                dot->original_x = fixed_to_float(rest_x + dx);
+                dot->original_y = fixed_to_float(rest_y + dy);
+            }
+            else
+            {
+                dot->original_x = fixed_to_float(rest_x + (dx < 0 ? -step_x : step_x));
+                dot->original_y = fixed_to_float(rest_y + (dy < 0 ? -step_y : step_y));
+                settling = true;
+            }
+        }
+    }
+    else
+    {
+        for (size_t i = 0; i < dot_count; i++)
+        {
+            Dot *dot = &g_dots[i];
+            const float dx = target_x[i] - dot->original_x;
+            const float dy = target_y[i] - dot->original_y;
+
+            if (fabsf(dx) < MORPH_SETTLE_DISTANCE && fabsf(dy) < MORPH_SETTLE_DISTANCE)
+            {
+                dot->original_x = target_x[i];
+                dot->original_y = target_y[i];
+            }
+            else
+            {
+                dot->original_x += dx * rate;
+                dot->original_y += dy * rate;
+                settling = true;
+            }
+        }
+    }
+
+    g_morph.settling = settling;
+
+    /* Back on the lattice, springs can use the constant rest length again */
+    if (!settling && g_morph.shape < 0)
+    {
+        g_morph.shaped = false;
+    }
+}
+
+/**
+ * Adds the queued force records to the dots' velocities. Records for fixed
+ * dots or indices outside the grid are ignored.
+ */
+static void forces_apply(void)
+{
+    const float dot_count = (float)((size_t)g_grid_rows * (size_t)g_grid_cols);
+
+    for (int i = 0; i < g_forces.count; i++)
+    {
+        const float *record = &g_forces.records[i * 3];
+        if (!(record[0] >= 0.0f && record[0] < dot_count))
+        {
+            continue;
+        }
+
+        Dot *dot = &g_dots[(size_t)record[0]];
+        if (!dot->fixed)
+        {
+            dot->vx += record[1];
+            dot->vy += record[2];
+        }
+    }
+    g_forces.count = 0;
+}
+
+/**
+ * Frees the force queue.
+ */
+static void forces_shutdown(void)
+{
+    free(g_forces.records);
+    g_forces = (ForceQueue){0};
+}
+
+/**
+ * Tracks windows being hidden, minimised and shown again. Once every window
+ * is hidden, rendering stops and, without lockstep peers, the physics
+ * pauses. When a window is shown again, a sheet that was still moving is
+ * fast-forwarded by the steps it missed.
+ *
+ * @param event Window event
+ */
+static void power_window_event(const SDL_WindowEvent *event)
+{
+    bool hide;
+    switch (event->event)
+    {
+    case SDL_WINDOWEVENT_HIDDEN:
+    case SDL_WINDOWEVENT_MINIMIZED:
+        hide = true;
+        break;
+    case SDL_WINDOWEVENT_SHOWN:
+    case SDL_WINDOWEVENT_EXPOSED:
+    case SDL_WINDOWEVENT_RESTORED:
+    case SDL_WINDOWEVENT_MAXIMIZED:
+        hide = false;
+        break;
+    default:
+        return;
+    }
+
+    int window = 0;
+    for (int i = 0; i < g_wall.count; i++)
+    {
+        if (SDL_GetWindowID(g_wall.windows[i].window) == event->windowID)
+        {
+            window = i + 1;
+        }
+    }
+    if (hide)
+    {
+        g_power.hidden_windows |= 1u << window;
+    }
+    else
+    {
+        g_power.hidden_windows &= ~(1u << window);
+    }
+
+    const bool hidden = g_power.hidden_windows == (1u << (g_wall.count + 1)) - 1;
+    if (hidden == g_power.hidden)
+    {
+        return;
+    }
+    g_power.hidden = hidden;
+
+    if (hidden)
+    {
+        /* The button may come up while nothing is shown, so let go now */
+        if (g_drag_state.is_dragging && g_lockstep.role != LOCKSTEP_NODE)
+        {
+            pointer_input(INPUT_RELEASE, 0, 0, 0);
+        }
+        g_power.hidden_at = event->timestamp;
+        g_power.paused = g_lockstep.role == LOCKSTEP_OFF;
+        g_power.moving = g_power.paused && power_sheet_moving();
+        return;
+    }
+
+    const bool fast_forward = g_power.paused && g_power.moving && !g_history.paused;
+    g_power.paused = false;
+    if (!fast_forward)
+    {
+        return;
+    }
+
+    const Uint32 hidden_ms = event->timestamp - g_power.hidden_at;
+    const InputCommand command = {
+        .type = INPUT_FAST_FORWARD,
+        .x = (Sint32)SDL_min((Uint64)hidden_ms * (Uint64)g_substeps / FRAME_DELAY_MS, POWER_MAX_CATCH_UP)};
+    if (command.x > 0)
+    {
+        recorder_log_input(&command);
+        apply_input_command(&command);
+        printf("Hidden for %.1f s: fast-forwarded %d steps\n", hidden_ms / 1000.0, command.x);
+    }
+}
+
+/**
+ * Checks whether the sheet would still change without input: a dot is away
+ * from rest or moving, or the rest shape is morphing.
+ *
+ * @return true if the sheet is moving
+ */
+static bool power_sheet_moving(void)
+{
+    if (g_morph.settling)
+    {
+        return true;
+    }
+
+    const size_t dot_count = (size_t)g_grid_rows * (size_t)g_grid_cols;
+    for (size_t i = 0; i < dot_count; i++)
+    {
+        const Dot *dot = &g_dots[i];
+        if (!dot->fixed && (fabsf(dot->vx) > POWER_MOVING_SPEED || fabsf(dot->vy) > POWER_MOVING_SPEED ||
+                            fabsf(dot->x - dot->original_x) > POWER_MOVING_DISTANCE ||
+                            fabsf(dot->y - dot->original_y) > POWER_MOVING_DISTANCE))
+        {
+            return true;
+        }
+    }
+    return false;
+}
+
+/**
+ * Raises a factor below one to a power, by squaring in 1/65536 with each
+ * product rounded down, so the result is the same on every target.
+ *
+ * @param factor Factor in 1/65536, from 0 to 65535
+ * @param exponent Power, at least 1
+ * @return factor^exponent in 1/65536
+ */
+static Sint32 fixed_power(Sint32 factor, Uint32 exponent)
+{
+    Sint64 result = 65536;
+    Sint64 base = factor;
+    while (exponent)
+    {
+        if (exponent & 1)
+        {
+            result = result * base / 65536;
+        }
+        base = base * base / 65536;
+        exponent >>= 1;
+    }
+    return (Sint32)result;
+}
+
+/**
+ * Relaxes the sheet as a number of steps without input would, in one pass
+ * instead of running them. Linearised around rest, every mode of the step
+ * oscillates with an amplitude that decays by sqrt(VELOCITY_DAMPING) per
+ * step, so each dot's offset from rest and its velocity are scaled by that
+ * decay over all the steps. A morph in progress advances by the same steps
+ * first. In --physics fixed mode the pass is rounded in fixed point, so
+ * recordings replay it bit-identically.
+ *
+ * @param steps Physics steps to stand in for
+ */
+static void power_fast_forward(Sint32 steps)
+{
+    if (steps <= 0)
+    {
+        return;
+    }
+
+    const bool fixed = g_physics_mode == PHYSICS_FIXED;
+    const size_t dot_count = (size_t)g_grid_rows * (size_t)g_grid_cols;
+
+    if (g_morph.settling)
+    {
+        const Sint32 remaining =
+            g_morph.rate < 1.0f ? fixed_power(65536 - FIXED_FACTOR(g_morph.rate), (Uint32)steps) : 0;
+        bool settling = false;
+        for (size_t i = 0; i < dot_count; i++)
+        {
+            Dot *dot = &g_dots[i];
+            if (fixed)
+            {
+                const Sint32 target_x = fixed_from_float(g_morph.target_x[i]);
+                const Sint32 target_y = fixed_from_float(g_morph.target_y[i]);
+                const Sint32 dx = fixed_scale(target_x - fixed_from_float(dot->original_x), remaining);
+                const Sint32 dy = fixed_scale(target_y - fixed_from_float(dot->original_y), remaining);
+                dot->original_x = fixed_to_float(target_x - dx);
+                dot->original_y = fixed_to_float(target_y - dy);
+                settling |= dx != 0 || dy != 0;
+                continue;
+            }
+
+            const float dx = (g_morph.target_x[i] - dot->original_x) * (remaining / 65536.0f);
+            const float dy = (g_morph.target_y[i] - dot->original_y) * (remaining / 65536.0f);
+            if (fabsf(dx) < MORPH_SETTLE_DISTANCE && fabsf(dy) < MORPH_SETTLE_DISTANCE)
+            {
+                dot->original_x = g_morph.target_x[i];
+                dot->original_y = g_morph.target_y[i];
+            }
+            else
+            {
+                dot->original_x = g_morph.target_x[i] - dx;
+                dot->original_y = g_morph.target_y[i] - dy;
+                settling = true;
+            }
+        }
+
+        g_morph.settling = settling;
+        if (!settling && g_morph.shape < 0)
+        {
+            g_morph.shaped = false;
+        }
+    }
+
+    const Sint32 decay = fixed_power(FIXED_FACTOR(sqrt(g_physics_params.damping)), (Uint32)steps);
+    const float decay_float = decay / 65536.0f;
+    for (size_t i = 0; i < dot_count; i++)
+    {
+        Dot *dot = &g_dots[i];
+        if (dot->fixed)
+        {
+            continue;
+        }
+
+        if (fixed)
+        {
+            const Sint32 rest_x = fixed_from_float(dot->original_x);
+            const Sint32 rest_y = fixed_from_float(dot->original_y);
+            dot->x = fixed_to_float(rest_x + fixed_scale(fixed_from_float(dot->x) - rest_x, decay));
+            dot->y = fixed_to_float(rest_y + fixed_scale(fixed_from_float(dot->y) - rest_y, decay));
+            dot->vx = fixed_to_float(fixed_scale(fixed_from_float(dot->vx), decay));
+            dot->vy = fixed_to_float(fixed_scale(fixed_from_float(dot->vy), decay));
+        }
+        else
+        {
+            dot->x = dot->original_x + (dot->x - dot->original_x) * decay_float;
+            dot->y = dot->original_y + (dot->y - dot->original_y) * decay_float;
+            dot->vx *= decay_float;
+            dot->vy *= decay_float;
+        }
+    }
+}
+
+#ifdef __EMSCRIPTEN__
+/**
+ * JavaScript API. Dots are read in place: dms_dots() points at dms_dot_count()
+ * dots of dms_dot_stride() floats each, with x, y, vx, vy, rest x and rest y
+ * first. The pointer can change between frames, while a sliced step shows its
+ * snapshot, so it should be fetched every frame.
+ *
+ * @return The dots as currently shown
+ */
+EMSCRIPTEN_KEEPALIVE Dot *dms_dots(void)
+{
+    return g_dots;
+}
+
+/**
+ * @return Number of dots, row-major
+ */
+EMSCRIPTEN_KEEPALIVE int dms_dot_count(void)
+{
+    return g_grid_rows * g_grid_cols;
+}
+
+/**
+ * @return Floats from one dot to the next
+ */
+EMSCRIPTEN_KEEPALIVE int dms_dot_stride(void)
+{
+    return (int)(sizeof(Dot) / sizeof(float));
+}
+
+/**
+ * @return Dots per grid row
+ */
+EMSCRIPTEN_KEEPALIVE int dms_grid_cols(void)
+{
+    return g_grid_cols;
+}
+
+/**
+ * Returns room for count (index, fx, fy) float records after the queued ones,
+ * for JavaScript to fill before calling dms_apply_forces().
+ *
+ * @param count Records to be written
+ * @return The first free record, or NULL if the queue cannot grow
+ */
+EMSCRIPTEN_KEEPALIVE float *dms_force_buffer(int count)
+{
+    if (count < 0)
+    {
+        return NULL;
+    }
+
+    if (g_forces.count + count > g_forces.capacity)
+    {
+        const int capacity = SDL_max(g_forces.count + count, g_forces.capacity * 2);
+        float *records = realloc(g_forces.records, (size_t)capacity * 3 * sizeof(float));
+        if (!records)
+        {
+            return NULL;
+        }
+        g_forces.records = records;
+        g_forces.capacity = capacity;
+    }
+    return g_forces.records + (size_t)g_forces.count * 3;
+}
+
+/**
+ * Queues the count records written to dms_force_buffer(). They are applied at
+ * once, or when the next step starts if a sliced step is in progress.
+ *
+ * @param count Records written
+ * @return Records queued
+ */
+EMSCRIPTEN_KEEPALIVE int dms_apply_forces(int count)
+{
+    if (count < 0 || g_forces.count + count > g_forces.capacity)
+    {
+        return 0;
+    }
+
+    g_forces.count += count;
+    if (!g_slice.active)
+    {
+        forces_apply();
+    }
+    return count;
+}
+
+/**
+ * Returns the pointer ring the page fills with coalesced pointer samples.
+ *
+ * @return Pointer ring in WebAssembly memory
+ */
+EMSCRIPTEN_KEEPALIVE PointerRing *dms_pointer_ring(void)
+{
+    return &g_pointer_ring;
+}
+
+/**
+ * Converts a pointer sample to sheet coordinates and a performance counter
+ * value.
+ *
+ * @param sample Sample to convert
+ * @param x Receives the position in sheet coordinates
+ * @param y Receives the position in sheet coordinates
+ * @return Performance counter value when the sample was generated
+ */
+static Uint64 pointer_sample_convert(const PointerSample *sample, Sint32 *x, Sint32 *y)
+{
+    *x = (Sint32)((Sint64)sample->x * g_view.width / POINTER_COORDINATE_SCALE) - g_view.offset_x;
+    *y = (Sint32)((Sint64)sample->y * g_view.height / POINTER_COORDINATE_SCALE) - g_view.offset_y;
+
+    const double age_ms = SDL_max(emscripten_get_now() - sample->time_ms, 0.0);
+    return SDL_GetPerformanceCounter() - (Uint64)(age_ms * (double)SDL_GetPerformanceFrequency() / 1000.0);
+}
+
+/**
+ * Moves every pointer sample the page wrote since the last frame into the
+ * input queue.
+ */
+static void pointer_ring_drain(void)
+{
+    if (!g_pointer_ring.active)
+    {
+        return;
+    }
+
+    const Uint32 head = g_pointer_ring.head;
+    for (Uint32 tail = g_pointer_ring.tail; tail != head; tail++)
+    {
+        const PointerSample *sample = &g_pointer_ring.samples[tail % POINTER_RING_SIZE];
+        Sint32 x, y;
+        const Uint64 input_counter = pointer_sample_convert(sample, &x, &y);
+        switch (sample->type)
+        {
+        case POINTER_DOWN:
+            pointer_input(INPUT_GRAB, x, y, 0);
+            break;
+        case POINTER_UP:
+            pointer_input(INPUT_RELEASE, x, y, 0);
+            break;
+        default:
+            pointer_input(INPUT_MOVE, x, y, input_counter);
+            break;
+        }
+    }
+    g_pointer_ring.tail = head;
+}
+
+/**
+ * Finds the newest motion sample the page wrote since the last frame,
+ * leaving it queued for the next one.
+ *
+ * @param x Receives the position in sheet coordinates
+ * @param y Receives the position in sheet coordinates
+ * @param input_counter Receives the performance counter value of the sample
+ * @return true if a motion sample is queued
+ */
+static bool pointer_ring_peek_move(Sint32 *x, Sint32 *y, Uint64 *input_counter)
+{
+    if (g_pointer_ring.head == g_pointer_ring.tail)
+    {
+        return false;
+    }
+
+    const PointerSample *sample = &g_pointer_ring.samples[(g_pointer_ring.head - 1) % POINTER_RING_SIZE];
+    if (sample->type != POINTER_MOVE)
+    {
+        return false; /* A grab or release follows the newest motion */
+    }
+    *input_counter = pointer_sample_convert(sample, x, y);
+    return true;
+}
+
+/**
+ * Returns the live statistics the page shows.
+ *
+ * @return Statistics in WebAssembly memory
+ */
+EMSCRIPTEN_KEEPALIVE SharedStats *dms_stats(void)
+{
+    return &g_stats;
+}
+
+/**
+ * Emits buffered frames as performance.measure() entries, one per stage
+ * that ran plus one for the whole frame, so they show in the Timings track
+ * of the browser's Performance panel. The entries are cleared again at
+ * once, as the panel records them when they are created.
+ */
+EM_JS(void, timeline_emit, (const double *times, int frames, int stages), {
+    const names = ['dms events', 'dms physics', 'dms render', 'dms present']; /* FrameStage order */
+    const stride = 2 + 2 * stages;
+    const base = times >> 3;
+    for (let frame = 0; frame < frames; frame++) {
+        const offset = base + frame * stride;
+        performance.measure('dms frame', {start: HEAPF64[offset], end: HEAPF64[offset + 1]});
+        for (let stage = 0; stage < stages; stage++) {
+            const end = HEAPF64[offset + 3 + 2 * stage];
+            if (end > 0) {
+                performance.measure(names[stage], {start: HEAPF64[offset + 2 + 2 * stage], end: end});
+            }
+        }
+    }
+    performance.clearMeasures();
+});
+
+/**
+ * Converts a performance counter value to the page's performance.now()
+ * clock.
+ *
+ * @param counter Performance counter value
+ * @return Time in milliseconds
+ */
+static double timeline_ms(Uint64 counter)
+{
+    if (!g_timeline.aligned)
+    {
+        /* Both clocks run at the same rate, so measuring the offset once is enough */
+        g_timeline.offset_ms =
+            emscripten_get_now() - (double)SDL_GetPerformanceCounter() * 1000.0 / (double)SDL_GetPerformanceFrequency();
+        g_timeline.aligned = true;
+    }
+    return (double)counter * 1000.0 / (double)SDL_GetPerformanceFrequency() + g_timeline.offset_ms;
+}
+
+/**
+ * Buffers a stage's start and end for the timeline.
+ *
+ * @param stage Stage that just finished
+ * @param stage_start Performance counter value when the stage started
+ * @param stage_end Performance counter value when the stage finished
+ */
+static void timeline_note_stage(FrameStage stage, Uint64 stage_start, Uint64 stage_end)
+{
+    double *times = g_timeline.times[g_timeline.count];
+    times[2 + 2 * stage] = timeline_ms(stage_start);
+    times[3 + 2 * stage] = timeline_ms(stage_end);
+}
+
+/**
+ * Updates the shared statistics with a finished frame and buffers it for
+ * the timeline, passing a full batch to the page.
+ *
+ * @param record Flight recorder record of the frame
+ * @param frame_end Performance counter value at the end of the frame
+ */
+static void browser_end_frame(const FrameRecord *record, Uint64 frame_end)
+{
+    const float weight = g_stats.frame ? STATS_SMOOTHING : 1.0f;
+    for (int stage = 0; stage < STAGE_COUNT; stage++)
+    {
+        g_stats.stage_ms[stage] += (record->stage_ms[stage] - g_stats.stage_ms[stage]) * weight;
+    }
+    g_stats.frame_ms += (record->total_ms - g_stats.frame_ms) * weight;
+    if (g_timeline.last_frame_start != 0)
+    {
+        const float interval_ms = (float)((double)(g_recorder.frame_start - g_timeline.last_frame_start) * 1000.0 /
+                                          (double)SDL_GetPerformanceFrequency());
+        if (interval_ms > 0.0f)
+        {
+            g_stats.fps += (1000.0f / interval_ms - g_stats.fps) * (g_stats.fps > 0.0f ? STATS_SMOOTHING : 1.0f);
+        }
+    }
+    g_timeline.last_frame_start = g_recorder.frame_start;
+
+    for (Uint32 i = 0; i < record->input_count; i++)
+    {
+        g_stats.steps += record->inputs[i].type == INPUT_STEP;
+    }
+    if (record->latency_ms >= 0.0f)
+    {
+        g_stats.latency_ms = record->latency_ms;
+    }
+    g_stats.frame++;
+    g_stats.dots = (Uint32)g_grid_rows * (Uint32)g_grid_cols;
+    g_stats.substeps = (Uint32)g_substeps;
+    g_stats.render_scale = record->render_scale;
+
+    double *times = g_timeline.times[g_timeline.count];
+    times[0] = timeline_ms(g_recorder.frame_start);
+    times[1] = timeline_ms(frame_end);
+    if (++g_timeline.count == TIMELINE_BATCH_FRAMES)
+    {
+        timeline_emit(&g_timeline.times[0][0], g_timeline.count, STAGE_COUNT);
+        memset(g_timeline.times, 0, sizeof(g_timeline.times));
+        g_timeline.count = 0;
+    }
+}
+#endif
+
+/**
+ * Allocates and initializes the grid, flight recorder, rewind history and
+ * frame source, and connects lockstep peers.
+ *
+ * @param options Parsed command line options
+ * @return true on success, false on error
+ */
+static bool init_simulation(const Options *options)
+{
+    const size_t arena_bytes = arena_estimate(options);
+    if (!arena_reserve(arena_bytes))
+    {
+        printf("Could not reserve a %zu MB arena, allocating arrays one by one\n", arena_bytes >> 20);
+    }
+
+    if (!allocate_grid(options->rows, options->cols) || !recorder_init(options->slow_ms) ||
+        !history_init(options->history_bytes))
+    {
+        return false;
+    }
+
+    initialize_grid();
+    build_palette();
+    g_color_mode = options->color_mode;
+    g_render.backend = options->render_backend;
+    g_physics_mode = options->physics_mode;
+    g_physics_params = options->physics_params;
+    g_slice.budget_ms = options->step_budget_ms;
+    g_substeps = options->substeps;
+    g_dynres.enabled = options->dynres_target_ms > 0.0f;
+    g_dynres.target_ms = options->dynres_target_ms;
+
+    if (options->script_path && !script_load(options->script_path, &g_script))
+    {
+        return false;
+    }
+
+    if (options->morph_path &&
+        !morph_load(options->morph_path, options->morph_width > 0 ? options->morph_width : options->cols,
+                    options->morph_height > 0 ? options->morph_height : options->rows, options->morph_rate))
+    {
+        return false;
+    }
+
+    if (options->frames_path &&
+        !frame_source_open(options->frames_path,
+                           options->frame_width > 0 ? options->frame_width : options->cols,
+                           options->frame_height > 0 ? options->frame_height : options->rows,
+                           options->frame_format, options->frame_rate))
+    {
+        return false;
+    }
+
+#ifdef HAS_LOCKSTEP
+    if ((options->lockstep_port > 0 && !lockstep_serve(options->lockstep_port)) ||
+        (options->lockstep_join && !lockstep_join(options->lockstep_join)))
+    {
+        return false;
+    }
+#endif
+
+#ifdef __EMSCRIPTEN__
+    printf("Memory: %zu MB heap, %zu of %zu MB arena used\n", emscripten_get_heap_size() >> 20,
+           g_arena.used >> 20, g_arena.capacity >> 20);
+#endif
+    return true;
+}
+
+/**
+ * Releases what init_simulation() set up.
+ */
+static void shutdown_simulation(void)
+{
+#ifdef HAS_LOCKSTEP
+    lockstep_shutdown();
+#endif
+    frame_source_close();
+    morph_shutdown();
+    physics_slice_shutdown();
+    forces_shutdown();
+    script_free(&g_script);
+    fixed_shutdown();
+    render_shutdown();
+    dynres_shutdown();
+    history_shutdown();
+    recorder_shutdown();
+    arena_free(g_dots);
+    g_dots = NULL;
+    arena_release();
+}
+
+/**
+ * Prints command line usage.
+ *
+ * @param program Name the program was invoked as
+ */
+static void print_usage(const char *program)
+{
+    fprintf(stderr,
+            "Usage: %s [--grid ROWSxCOLS] [--slow-ms MS] [--history-mb MB] [--no-latch]\n"
+            "          [--replay FILE] [--script FILE] [--latency-bench [FRAMES]] [--render-bench [FILE]]\n"
+            "          [--stress-bench [SEEDS] [--seed N]] [--scaling-bench [THREADS]] [--term]\n"
+            "          [--sweep [THREADS] [--settle-ms MS] [--max-strain S]]\n"
+            "          [--stiffness K] [--damping D] [--restoring R]\n"
+            "          [--frames PATH [--frame-size WxH] [--frame-format grey|rgb] [--frame-rate FPS]]\n"
+            "          [--morph FILE [--morph-size WxH] [--morph-rate RATE]] [--color solid|speed|strain]\n"
+            "          [--renderer points|geometry|sprite|raster] [--dynamic-res [MS]] [--physics float|fixed]\n"
+            "          [--step-budget MS] [--substeps N] [--wall COLSxROWS [--wall-tile COL,ROW]]\n"
+            "          [--lockstep-serve PORT | --lockstep-join HOST:PORT]\n"
+            "  --grid ROWSxCOLS  Grid size (default %dx%d)\n"
+            "  --slow-ms MS      Frame time that triggers a flight recorder dump (default %.0f)\n"
+            "  --history-mb MB   Rewind history memory budget, 0 to disable (default %d)\n"
+            "  --no-latch        Do not re-sample the drag position just before rendering\n"
+            "  --replay FILE     Replay a flight recorder dump or an input script headlessly and exit\n"
+            "  --script FILE     Play an input script: grab, move, release, brush, touch N down|move|up,\n"
+            "                    wait, and repeat/parallel blocks; also drives --render-bench\n"
+            "  --latency-bench [FRAMES]\n"
+            "                    Measure input-to-present latency headlessly with synthetic\n"
+            "                    input and the software renderer (default %d frames)\n"
+            "  --render-bench [FILE]\n"
+            "                    Draw the frames of a flight recorder dump, of --script, or of %d\n"
+            "                    frames of a circular drag, with every renderer offscreen and compare them\n"
+            "  --stress-bench [SEEDS]\n"
+            "                    Run adversarial input scripts generated from SEEDS seeds (default %d)\n"
+            "                    headlessly, report tail step and render times and save the worst scripts\n"
+            "  --seed N          First --stress-bench seed (default 1)\n"
+            "  --scaling-bench [THREADS]\n"
+            "                    Measure how the physics step scales from 1 to THREADS threads\n"
+            "                    (default: one per CPU) on the --grid sheet (default %dx%d)\n"
+            "                    and print a roofline report\n"
+            "  --sweep [THREADS] Run --script, or a pull on the centre dot, with every combination of\n"
+            "                    sweep parameters on THREADS threads (default: one per CPU) and report\n"
+            "                    the cheapest one that is stable, stretches springs by at most\n"
+            "                    --max-strain (default %.1f) and settles within --settle-ms (default %.0f)\n"
+            "  --stiffness K     Spring force per px of stretch (default %.2f)\n"
+            "  --damping D       Fraction of its velocity a dot keeps per step (default %.2f)\n"
+            "  --restoring R     Pull toward the rest position per px (default %.2f)\n"
+            "  --term            Draw the sheet in the terminal with Braille characters\n"
+            "  --frames PATH     Drive dot colours from raw frames in a file, pipe or - for stdin\n"
+            "  --frame-size WxH  Frame size in pixels (default: the grid size)\n"
+            "  --frame-format F  grey (1 byte per pixel, default) or rgb (3 bytes per pixel)\n"
+            "  --frame-rate FPS  Frames shown per second (default %d)\n"
+            "  --morph FILE      Morph the rest shape toward raw greyscale brightness maps; M cycles them\n"
+            "  --morph-size WxH  Brightness map size in pixels (default: the grid size)\n"
+            "  --morph-rate RATE Fraction of the remaining distance moved per step (default %.2f)\n"
+            "  --color MODE      Dot colours: solid (default), speed or strain; C cycles them\n"
+            "  --renderer NAME   points (integer circles), geometry (flat squares),\n"
+            "                    sprite (antialiased, the default with SDL 2.0.18+)\n"
+            "                    or raster (antialiased on the CPU)\n"
+            "  --dynamic-res [MS]\n"
+            "                    Render at a reduced resolution when render + present time\n"
+            "                    exceeds MS, and upscale (default %.0f)\n"
+            "  --physics MODE    float (default) or fixed: 32-bit fixed point, bit-identical on every\n"
+            "                    platform and build\n"
+            "  --step-budget MS  Spread physics steps longer than MS over several frames, showing\n"
+            "                    the last completed step meanwhile; 0 runs them whole (default %.0f)\n"
+            "  --substeps N      Physics steps per frame, with the drag samples of the frame spread\n"
+            "                    over them by time (1 to %d, default 1)\n"
+            "  --wall COLSxROWS  Span the sheet across a grid of windows, one per display\n"
+            "                    when there are enough (at most %d windows)\n"
+            "  --wall-tile COL,ROW\n"
+            "                    Show only this window of the wall, for one process per display\n"
+            "  --lockstep-serve PORT\n"
+            "                    Send each frame's input and a state checksum to nodes on PORT\n"
+            "  --lockstep-join HOST:PORT\n"
+            "                    Simulate in lockstep with a coordinator; local mouse input is ignored\n",
+            program, GRID_ROWS, GRID_COLS, SLOW_FRAME_THRESHOLD_MS, HISTORY_MEMORY_MB, LATENCY_BENCH_FRAMES,
+            RENDER_BENCH_FRAMES, STRESS_DEFAULT_SEEDS, SCALING_GRID, SCALING_GRID, SWEEP_MAX_STRAIN, SWEEP_SETTLE_MS,
+            SPRING_STIFFNESS, VELOCITY_DAMPING, RESTORING_FORCE_STRENGTH,
+            FRAME_DEFAULT_RATE, MORPH_DEFAULT_RATE, DYNRES_DEFAULT_TARGET_MS, STEP_BUDGET_DEFAULT_MS,
+            SUBSTEPS_MAX, WALL_MAX_WINDOWS);
+}
+
+/**
+ * Parses command line options.
+ *
+ * @param argc Argument count
+ * @param argv Argument vector
+ * @param options Output, filled with defaults for options not given
+ * @return true on success, false on an unknown or malformed option
+ */
+static bool parse_options(int argc, char *argv[], Options *options)
+{
+    *options = (Options){
+        .rows = GRID_ROWS,
+        .cols = GRID_COLS,
+        .slow_ms = SLOW_FRAME_THRESHOLD_MS,
+        .history_bytes = (size_t)HISTORY_MEMORY_MB * 1024 * 1024,
+        .frame_format = FRAME_GREY,
+        .frame_rate = FRAME_DEFAULT_RATE,
+        .morph_rate = MORPH_DEFAULT_RATE,
+        .step_budget_ms = STEP_BUDGET_DEFAULT_MS,
+        .physics_params = {SPRING_STIFFNESS, VELOCITY_DAMPING, RESTORING_FORCE_STRENGTH},
+        .substeps = 1,
+        .stress_seed = 1,
+        .settle_ms = SWEEP_SETTLE_MS,
+        .max_strain = SWEEP_MAX_STRAIN,
+        .wall_cols = 1,
+        .wall_rows = 1,
+        .wall_tile_col = -1,
+        .wall_tile_row = -1,
+#ifdef HAS_RENDER_GEOMETRY
+        .render_backend = RENDER_SPRITE
+#else
+        .render_backend = RENDER_RASTER
+#endif
+    };
+
+    for (int i = 1; i < argc; i++)
+    {
+        if (strcmp(argv[i], "--grid") == 0 && i + 1 < argc &&
+            sscanf(argv[i + 1], "%dx%d", &options->rows, &options->cols) == 2 && options->rows > 0 &&
+            options->cols > 0)
+        {
+            options->grid_given = true;
+            i++;
+        }
+        else if (strcmp(argv[i], "--slow-ms") == 0 && i + 1 < argc)
+        {
+            options->slow_ms = (float)atof(argv[++i]);
+        }
+        else if (strcmp(argv[i], "--history-mb") == 0 && i + 1 < argc)
+        {
+            const int history_mb = atoi(argv[++i]);
+            options->history_bytes = (size_t)(history_mb > 0 ? history_mb : 0) * 1024 * 1024;
+        }
+        else if (strcmp(argv[i], "--no-latch") == 0)
+        {
+            g_late_latch = false;
+        }
+        else if (strcmp(argv[i], "--replay") == 0 && i + 1 < argc)
+        {
+            options->replay_path = argv[++i];
+        }
+        else if (strcmp(argv[i], "--script") == 0 && i + 1 < argc)
+        {
+            options->script_path = argv[++i];
+        }
+        else if (strcmp(argv[i], "--latency-bench") == 0)
+        {
+            options->latency_frames = LATENCY_BENCH_FRAMES;
+            if (i + 1 < argc && atoi(argv[i + 1]) > 0)
+            {
+                options->latency_frames = atoi(argv[++i]);
+            }
+        }
+        else if (strcmp(argv[i], "--render-bench") == 0)
+        {
+            options->render_bench = true;
+            if (i + 1 < argc && strncmp(argv[i + 1], "--", 2) != 0)
+            {
+                options->render_bench_path = argv[++i];
+            }
+        }
+        else if (strcmp(argv[i], "--stress-bench") == 0)
+        {
+            options->stress_seeds = STRESS_DEFAULT_SEEDS;
+            if (i + 1 < argc && atoi(argv[i + 1]) > 0)
+            {
+                const int seeds = atoi(argv[++i]);
+                options->stress_seeds = SDL_min(seeds, STRESS_MAX_SEEDS);
+            }
+        }
+        else if (strcmp(argv[i], "--seed") == 0 && i + 1 < argc)
+        {
+            options->stress_seed = (Uint32)strtoul(argv[++i], NULL, 10);
+        }
+        else if (strcmp(argv[i], "--scaling-bench") == 0)
+        {
+            options->scaling_threads = SDL_GetCPUCount();
+            if (i + 1 < argc && atoi(argv[i + 1]) > 0)
+            {
+                options->scaling_threads = atoi(argv[++i]);
+            }
+        }
+        else if (strcmp(argv[i], "--sweep") == 0)
+        {
+            options->sweep_threads = SDL_GetCPUCount();
+            if (i + 1 < argc && atoi(argv[i + 1]) > 0)
+            {
+                options->sweep_threads = atoi(argv[++i]);
+            }
+        }
+        else if (strcmp(argv[i], "--settle-ms") == 0 && i + 1 < argc && atof(argv[i + 1]) > 0.0)
+        {
+            options->settle_ms = atof(argv[++i]);
+        }
+        else if (strcmp(argv[i], "--max-strain") == 0 && i + 1 < argc && atof(argv[i + 1]) > 0.0)
+        {
+            options->max_strain = atof(argv[++i]);
+        }
+        else if (strcmp(argv[i], "--stiffness") == 0 && i + 1 < argc && atof(argv[i + 1]) > 0.0 &&
+                 atof(argv[i + 1]) <= 1.0)
+        {
+            options->physics_params.stiffness = atof(argv[++i]);
+        }
+        else if (strcmp(argv[i], "--damping") == 0 && i + 1 < argc && atof(argv[i + 1]) > 0.0 &&
+                 atof(argv[i + 1]) <= 1.0)
+        {
+            options->physics_params.damping = atof(argv[++i]);
+        }
+        else if (strcmp(argv[i], "--restoring") == 0 && i + 1 < argc && atof(argv[i + 1]) >= 0.0 &&
+                 atof(argv[i + 1]) <= 1.0)
+        {
+            options->physics_params.restoring = atof(argv[++i]);
+        }
+        else if (strcmp(argv[i], "--term") == 0)
+        {
+            options->terminal_view = true;
+        }
+        else if (strcmp(argv[i], "--frames") == 0 && i + 1 < argc)
+        {
+            options->frames_path = argv[++i];
+        }
+        else if (strcmp(argv[i], "--frame-size") == 0 && i + 1 < argc &&
+                 sscanf(argv[i + 1], "%dx%d", &options->frame_width, &options->frame_height) == 2 &&
+                 options->frame_width > 0 && options->frame_height > 0)
+        {
+            i++;
+        }
+        else if (strcmp(argv[i], "--frame-format") == 0 && i + 1 < argc &&
+                 (strcmp(argv[i + 1], "grey") == 0 || strcmp(argv[i + 1], "rgb") == 0))
+        {
+            options->frame_format = strcmp(argv[++i], "rgb") == 0 ? FRAME_RGB : FRAME_GREY;
+        }
+        else if (strcmp(argv[i], "--frame-rate") == 0 && i + 1 < argc && atoi(argv[i + 1]) > 0)
+        {
+            options->frame_rate = atoi(argv[++i]);
+        }
+        else if (strcmp(argv[i], "--color") == 0 && i + 1 < argc)
+        {
+            i++;
+            int mode = 0;
+            while (mode < COLOR_MODE_COUNT && strcmp(argv[i], k_color_mode_names[mode]) != 0)
+            {
+                mode++;
+            }
+            if (mode == COLOR_MODE_COUNT)
+            {
+                return false;
+            }
+            options->color_mode = (ColorMode)mode;
+        }
+        else if (strcmp(argv[i], "--renderer") == 0 && i + 1 < argc)
+        {
+            i++;
+            int backend = 0;
+            while (backend < RENDER_BACKEND_COUNT && strcmp(argv[i], k_render_backend_names[backend]) != 0)
+            {
+                backend++;
+            }
+#ifndef HAS_RENDER_GEOMETRY
+            if (backend == RENDER_GEOMETRY || backend == RENDER_SPRITE)
+            {
+                fprintf(stderr, "--renderer %s needs SDL 2.0.18 or newer\n", argv[i]);
+                return false;
+            }
+#endif
+            if (backend == RENDER_BACKEND_COUNT)
+            {
+                return false;
+            }
+            options->render_backend = (RenderBackend)backend;
+        }
+        else if (strcmp(argv[i], "--physics") == 0 && i + 1 < argc)
+        {
+            i++;
+            int mode = 0;
+            while (mode < PHYSICS_MODE_COUNT && strcmp(argv[i], k_physics_mode_names[mode]) != 0)
+            {
+                mode++;
+            }
+            if (mode == PHYSICS_MODE_COUNT)
+            {
+                return false;
+            }
+            options->physics_mode = (PhysicsMode)mode;
+        }
+        else if (strcmp(argv[i], "--step-budget") == 0 && i + 1 < argc && atof(argv[i + 1]) >= 0.0)
         {
-            const float pos_x = start_x + col * SPRING_REST_LENGTH;
-            const float pos_y = start_y + row * SPRING_REST_LENGTH;
-
-            g_dots[row][col] = (Dot){
-                .x = pos_x,
-                .y = pos_y,
-                .vx = 0.0f,
-                .vy = 0.0f,
-                .original_x = pos_x,
-                .original_y = pos_y,
-                .fixed = false};
+            options->step_budget_ms = (float)atof(argv[++i]);
+        }
+        else if (strcmp(argv[i], "--substeps") == 0 && i + 1 < argc && atoi(argv[i + 1]) >= 1 &&
+                 atoi(argv[i + 1]) <= SUBSTEPS_MAX)
+        {
+            options->substeps = atoi(argv[++i]);
+        }
+        else if (strcmp(argv[i], "--dynamic-res") == 0)
+        {
+            options->dynres_target_ms = DYNRES_DEFAULT_TARGET_MS;
+            if (i + 1 < argc && atof(argv[i + 1]) > 0.0)
+            {
+                options->dynres_target_ms = (float)atof(argv[++i]);
+            }
+        }
+        else if (strcmp(argv[i], "--wall") == 0 && i + 1 < argc &&
+                 sscanf(argv[i + 1], "%dx%d", &options->wall_cols, &options->wall_rows) == 2 &&
+                 options->wall_cols > 0 && options->wall_rows > 0 &&
+                 options->wall_cols * options->wall_rows <= WALL_MAX_WINDOWS)
+        {
+#ifdef __EMSCRIPTEN__
+            fprintf(stderr, "--wall is not available in the browser\n");
+            return false;
+#endif
+            i++;
+        }
+        else if (strcmp(argv[i], "--wall-tile") == 0 && i + 1 < argc &&
+                 sscanf(argv[i + 1], "%d,%d", &options->wall_tile_col, &options->wall_tile_row) == 2 &&
+                 options->wall_tile_col >= 0 && options->wall_tile_row >= 0)
+        {
+            i++;
+        }
+        else if (strcmp(argv[i], "--lockstep-serve") == 0 && i + 1 < argc && atoi(argv[i + 1]) > 0 &&
+                 atoi(argv[i + 1]) < 65536)
+        {
+#ifndef HAS_LOCKSTEP
+            fprintf(stderr, "--lockstep-serve is not available on this platform\n");
+            return false;
+#endif
+            options->lockstep_port = atoi(argv[++i]);
+        }
+        else if (strcmp(argv[i], "--lockstep-join") == 0 && i + 1 < argc)
+        {
+#ifndef HAS_LOCKSTEP
+            fprintf(stderr, "--lockstep-join is not available on this platform\n");
+            return false;
+#endif
+            options->lockstep_join = argv[++i];
+        }
+        else if (strcmp(argv[i], "--morph") == 0 && i + 1 < argc)
+        {
+            options->morph_path = argv[++i];
+        }
+        else if (strcmp(argv[i], "--morph-size") == 0 && i + 1 < argc &&
+                 sscanf(argv[i + 1], "%dx%d", &options->morph_width, &options->morph_height) == 2 &&
+                 options->morph_width > 0 && options->morph_height > 0)
+        {
+            i++;
+        }
+        else if (strcmp(argv[i], "--morph-rate") == 0 && i + 1 < argc && atof(argv[i + 1]) > 0.0 &&
+                 atof(argv[i + 1]) <= 1.0)
+        {
+            options->morph_rate = (float)atof(argv[++i]);
+        }
+        else
+        {
+            return false;
         }
     }
 
-    /* Fix the top corners as anchor points */
-    g_dots[0][0].fixed = true;
-    g_dots[0][GRID_COLS - 1].fixed = true;
-}
-
-/**
- * Applies spring force between two connected dots using Hooke's Law.
- * The force is proportional to the displacement from the rest length.
- *
- * @param dot_a First dot
- * @param dot_b Second dot connected to first dot
- */
-static void apply_spring_force(Dot *dot_a, Dot *dot_b)
-{
-    const float dx = dot_b->x - dot_a->x;
-    const float dy = dot_b->y - dot_a->y;
-    const float distance = sqrtf(dx * dx + dy * dy);
-
-    if (distance < 0.001f)
+    if (options->lockstep_port > 0 && options->lockstep_join)
     {
-        return; /* Avoid division by zero */
+        fprintf(stderr, "--lockstep-serve and --lockstep-join are exclusive\n");
+        return false;
     }
-
-    const float displacement = distance - SPRING_REST_LENGTH;
-    const float force_magnitude = displacement * SPRING_STIFFNESS;
-    const float fx = force_magnitude * (dx / distance);
-    const float fy = force_magnitude * (dy / distance);
-
-    if (!dot_a->fixed)
+    if (options->step_budget_ms > 0.0f && (options->lockstep_port > 0 || options->lockstep_join))
     {
-        dot_a->vx += fx;
-        dot_a->vy += fy;
+        fprintf(stderr, "--step-budget cannot be used with lockstep, which sends every frame's state\n");
+        return false;
     }
-
-    if (!dot_b->fixed)
+    if (options->wall_tile_col >= options->wall_cols || options->wall_tile_row >= options->wall_rows)
     {
-        dot_b->vx -= fx;
-        dot_b->vy -= fy;
+        fprintf(stderr, "--wall-tile must be inside the --wall layout\n");
+        return false;
     }
+    return true;
 }
 
-/**
- * Applies a gentle force that pulls the dot back toward its original position.
- * This helps the grid return to its rest state after being disturbed.
- *
- * @param dot The dot to apply restoring force to
- */
-static void apply_restoring_force(Dot *dot)
+int main(int argc, char *argv[])
 {
-    if (dot->fixed)
+    Options options;
+    if (!parse_options(argc, argv, &options))
     {
-        return;
+        print_usage(argv[0]);
+        return EXIT_FAILURE;
     }
 
-    const float dx = dot->original_x - dot->x;
-    const float dy = dot->original_y - dot->y;
-
-    dot->vx += dx * RESTORING_FORCE_STRENGTH;
-    dot->vy += dy * RESTORING_FORCE_STRENGTH;
-}
-
-/**
- * Updates all dots' positions and velocities based on physics simulation.
- * First applies damping and integrates velocity, then applies spring and restoring forces.
- */
-static void update_physics(void)
-{
-    /* Update positions and apply damping */
-    for (int row = 0; row < GRID_ROWS; row++)
+    if (options.replay_path)
     {
-        for (int col = 0; col < GRID_COLS; col++)
-        {
-            Dot *dot = &g_dots[row][col];
+        return run_replay_benchmark(&options);
+    }
 
-            if (!dot->fixed)
-            {
-                dot->vx *= VELOCITY_DAMPING;
-                dot->vy *= VELOCITY_DAMPING;
-                dot->x += dot->vx;
-                dot->y += dot->vy;
-                apply_restoring_force(dot);
-            }
-        }
+    if (options.scaling_threads > 0)
+    {
+#ifdef __EMSCRIPTEN__
+        fprintf(stderr, "--scaling-bench is not available in the browser\n");
+        return EXIT_FAILURE;
+#else
+        return run_scaling_benchmark(options.scaling_threads, options.grid_given ? options.rows : SCALING_GRID,
+                                     options.grid_given ? options.cols : SCALING_GRID);
+#endif
     }
 
-    /* Apply spring forces between connected dots */
-    for (int row = 0; row < GRID_ROWS; row++)
+    if (options.sweep_threads > 0)
     {
-        for (int col = 0; col < GRID_COLS; col++)
+#ifdef __EMSCRIPTEN__
+        fprintf(stderr, "--sweep is not available in the browser\n");
+        return EXIT_FAILURE;
+#else
+        if (SDL_Init(SDL_INIT_EVENTS) < 0)
         {
-            Dot *current = &g_dots[row][col];
+            fprintf(stderr, "SDL initialization failed: %s\n", SDL_GetError());
+            return EXIT_FAILURE;
+        }
 
-            /* Connect to neighboring dots (up, down, left, right) */
-            if (row > 0)
-            {
-                apply_spring_force(current, &g_dots[row - 1][col]);
-            }
-            if (row < GRID_ROWS - 1)
-            {
-                apply_spring_force(current, &g_dots[row + 1][col]);
-            }
-            if (col > 0)
-            {
-                apply_spring_force(current, &g_dots[row][col - 1]);
-            }
-            if (col < GRID_COLS - 1)
-            {
-                apply_spring_force(current, &g_dots[row][col + 1]);
-            }
+        int status = EXIT_FAILURE;
+        if (init_simulation(&options))
+        {
+            status = run_parameter_sweep(options.sweep_threads, options.settle_ms, options.max_strain);
         }
+        shutdown_simulation();
+        SDL_Quit();
+        return status;
+#endif
     }
-}
 
-/**
- * Draws a filled circle using the midpoint circle algorithm.
- *
- * @param renderer SDL renderer to draw with
- * @param center_x X coordinate of circle center
- * @param center_y Y coordinate of circle center
- * @param radius Radius of the circle in pixels
- */
-static void draw_filled_circle(SDL_Renderer *renderer, int center_x, int center_y, int radius)
-{
-    for (int w = 0; w < radius * 2; w++)
+    if (options.stress_seeds > 0)
     {
-        for (int h = 0; h < radius * 2; h++)
+        if (SDL_Init(SDL_INIT_EVENTS) < 0)
         {
-            const int dx = radius - w;
-            const int dy = radius - h;
-            if ((dx * dx + dy * dy) <= (radius * radius))
-            {
-                SDL_RenderDrawPoint(renderer, center_x + dx, center_y + dy);
-            }
+            fprintf(stderr, "SDL initialization failed: %s\n", SDL_GetError());
+            return EXIT_FAILURE;
         }
-    }
-}
-
-/**
- * Renders all dots in the grid as filled circles.
- *
- * @param renderer SDL renderer to draw with
- */
-static void render_grid(SDL_Renderer *renderer)
-{
-    SDL_SetRenderDrawColor(renderer, DOT_COLOR_R, DOT_COLOR_G, DOT_COLOR_B, DOT_COLOR_A);
 
-    for (int row = 0; row < GRID_ROWS; row++)
-    {
-        for (int col = 0; col < GRID_COLS; col++)
+        int status = EXIT_FAILURE;
+        if (init_simulation(&options))
         {
-            const Dot *dot = &g_dots[row][col];
-            draw_filled_circle(renderer, (int)dot->x, (int)dot->y, DOT_RADIUS);
+            status = run_stress_benchmark(options.stress_seeds, options.stress_seed);
         }
+        shutdown_simulation();
+        SDL_Quit();
+        return status;
     }
-}
 
-/**
- * Finds the dot closest to the given mouse position within the click radius.
- *
- * @param mouse_x Mouse X coordinate
- * @param mouse_y Mouse Y coordinate
- * @param row Output parameter for the row of the found dot
- * @param col Output parameter for the column of the found dot
- * @return true if a dot was found, false otherwise
- */
-static bool find_dot_at_position(int mouse_x, int mouse_y, int *row, int *col)
-{
-    for (int r = 0; r < GRID_ROWS; r++)
+    if (options.render_bench)
     {
-        for (int c = 0; c < GRID_COLS; c++)
+        if (SDL_Init(SDL_INIT_EVENTS) < 0)
         {
-            const float dx = mouse_x - g_dots[r][c].x;
-            const float dy = mouse_y - g_dots[r][c].y;
-            const float distance = sqrtf(dx * dx + dy * dy);
-
-            if (distance < CLICK_DETECTION_RADIUS)
-            {
-                *row = r;
-                *col = c;
-                return true;
-            }
+            fprintf(stderr, "SDL initialization failed: %s\n", SDL_GetError());
+            return EXIT_FAILURE;
         }
-    }
-    return false;
-}
-
-/**
- * Handles mouse events for dragging dots.
- * Users can click and drag dots to move them, creating wave effects in the grid.
- *
- * @param event SDL event to process
- */
-static void handle_mouse_event(const SDL_Event *event)
-{
-    int mouse_x, mouse_y;
-    SDL_GetMouseState(&mouse_x, &mouse_y);
 
-    switch (event->type)
-    {
-    case SDL_MOUSEBUTTONDOWN:
-    {
-        int row, col;
-        if (find_dot_at_position(mouse_x, mouse_y, &row, &col))
+        int status = EXIT_FAILURE;
+        if (init_simulation(&options))
         {
-            g_drag_state.is_dragging = true;
-            g_drag_state.row = row;
-            g_drag_state.col = col;
-            g_dots[row][col].fixed = true;
+            status = run_render_benchmark(options.render_bench_path);
         }
-        break;
+        shutdown_simulation();
+        SDL_Quit();
+        return status;
     }
 
-    case SDL_MOUSEBUTTONUP:
-        if (g_drag_state.is_dragging)
+    if (options.latency_frames > 0)
+    {
+        if (SDL_Init(SDL_INIT_EVENTS) < 0)
         {
-            g_dots[g_drag_state.row][g_drag_state.col].fixed = false;
-            g_drag_state.is_dragging = false;
+            fprintf(stderr, "SDL initialization failed: %s\n", SDL_GetError());
+            return EXIT_FAILURE;
         }
-        break;
 
-    case SDL_MOUSEMOTION:
-        if (g_drag_state.is_dragging)
+        int status = EXIT_FAILURE;
+        if (init_simulation(&options))
         {
-            g_dots[g_drag_state.row][g_drag_state.col].x = mouse_x;
-            g_dots[g_drag_state.row][g_drag_state.col].y = mouse_y;
+            status = run_latency_benchmark(options.latency_frames);
         }
-        break;
-
-    default:
-        break;
+        shutdown_simulation();
+        SDL_Quit();
+        return status;
     }
-}
-
-/**
- * Main entry point for the Dot Matrix Sheet simulation.
- * Initializes SDL, creates the window and renderer, runs the main loop,
- * and cleans up resources on exit.
- *
- * @return EXIT_SUCCESS on successful execution, EXIT_FAILURE on error
- */
-
-/**
- * Main loop iteration function.
- * Processes events, updates physics, and renders the frame.
- * This function is called repeatedly either by the native loop or by Emscripten.
- */
-static void main_loop(void)
-{
-    SDL_Event event;
 
-    /* Process all pending events */
-    while (SDL_PollEvent(&event))
+    if (options.terminal_view)
     {
-        if (event.type == SDL_QUIT)
+#ifdef HAS_TERMINAL_VIEW
+        if (SDL_Init(SDL_INIT_TIMER) < 0)
         {
-            g_running = false;
-#ifdef __EMSCRIPTEN__
-            emscripten_cancel_main_loop();
-#endif
+            fprintf(stderr, "SDL initialization failed: %s\n", SDL_GetError());
+            return EXIT_FAILURE;
         }
-        else
+
+        int status = EXIT_FAILURE;
+        if (init_simulation(&options))
         {
-            handle_mouse_event(&event);
+            status = run_terminal_view();
         }
+        shutdown_simulation();
+        SDL_Quit();
+        return status;
+#else
+        fprintf(stderr, "--term is not available on this platform\n");
+        return EXIT_FAILURE;
+#endif
     }
 
-    /* Update physics simulation */
-    update_physics();
-
-    /* Render frame */
-    SDL_SetRenderDrawColor(
-        g_renderer,
-        BACKGROUND_COLOR_R,
-        BACKGROUND_COLOR_G,
-        BACKGROUND_COLOR_B,
-        BACKGROUND_COLOR_A);
-    SDL_RenderClear(g_renderer);
-    render_grid(g_renderer);
-    SDL_RenderPresent(g_renderer);
-}
-
-int main(void)
-{
     /* Initialize SDL video subsystem */
     if (SDL_Init(SDL_INIT_VIDEO) < 0)
     {
@@ -406,7 +10436,7 @@ int main(void)
         SDL_WINDOWPOS_UNDEFINED,
         WINDOW_WIDTH,
         WINDOW_HEIGHT,
-        SDL_WINDOW_SHOWN);
+        SDL_WINDOW_SHOWN | SDL_WINDOW_RESIZABLE | SDL_WINDOW_ALLOW_HIGHDPI);
 
     if (!g_window)
     {
@@ -429,8 +10459,19 @@ int main(void)
         return EXIT_FAILURE;
     }
 
-    /* Initialize the dot grid */
-    initialize_grid();
+    view_update(g_window, g_renderer, &g_view);
+
+    /* Initialize the dot grid, then any further windows of a video wall */
+    if (!init_simulation(&options) ||
+        !wall_init(options.wall_cols, options.wall_rows, options.wall_tile_col, options.wall_tile_row))
+    {
+        wall_shutdown();
+        shutdown_simulation();
+        SDL_DestroyRenderer(g_renderer);
+        SDL_DestroyWindow(g_window);
+        SDL_Quit();
+        return EXIT_FAILURE;
+    }
 
 #ifdef __EMSCRIPTEN__
     /* Use Emscripten's main loop for browser compatibility */
@@ -440,14 +10481,23 @@ int main(void)
     while (g_running)
     {
         main_loop();
-        SDL_Delay(FRAME_DELAY_MS);
+        if (g_power.paused)
+        {
+            SDL_WaitEventTimeout(NULL, POWER_HIDDEN_WAIT_MS); /* Sleep until the windows are shown again */
+        }
+        else
+        {
+            SDL_Delay(FRAME_DELAY_MS);
+        }
     }
 #endif
 
     /* Cleanup resources */
+    wall_shutdown();
+    shutdown_simulation();
     SDL_DestroyRenderer(g_renderer);
     SDL_DestroyWindow(g_window);
     SDL_Quit();
 
     return EXIT_SUCCESS;
-}
\ No newline at end of file
+}